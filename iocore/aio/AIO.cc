@@ -27,9 +27,11 @@
 
 #include "P_AIO.h"
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 #define AIO_PERIOD -HRTIME_MSECONDS(10)
-#else
+#endif
+
+#if AIO_MODE != AIO_MODE_NATIVE
 
 #define MAX_DISKS_POSSIBLE 100
 
@@ -46,10 +48,21 @@ volatile int num_filedes = 1;
 static ink_mutex insert_mutex;
 
 int thread_is_created = 0;
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE != AIO_MODE_NATIVE
 RecInt cache_config_threads_per_disk = 12;
 RecInt api_config_threads_per_disk   = 12;
 
+// Implementation in use, see ink_aio_set_mode().
+static int aio_mode = AIO_MODE;
+#if AIO_MODE == AIO_MODE_IO_URING
+RecInt aio_io_uring_entries       = MAX_AIO_EVENTS;
+static bool aio_io_uring_required = false;
+// protects the list of buffers registered with ink_aio_register_buffer()
+static ink_mutex aio_fixed_mutex;
+
+static bool aio_io_uring_queue(AIOCallback *op, int opcode);
+#endif
+
 RecRawStatBlock *aio_rsb      = nullptr;
 Continuation *aio_err_callbck = nullptr;
 // AIO Stats
@@ -142,6 +155,24 @@ ink_aio_set_callback(Continuation *callback)
   aio_err_callbck = callback;
 }
 
+bool
+ink_aio_set_mode(int mode)
+{
+#if AIO_MODE == AIO_MODE_IO_URING
+  if (mode == AIO_MODE_THREAD || mode == AIO_MODE_IO_URING) {
+    aio_mode = mode;
+    return true;
+  }
+#endif
+  return mode == AIO_MODE;
+}
+
+int
+ink_aio_get_mode()
+{
+  return aio_mode;
+}
+
 void
 ink_aio_init(ModuleVersion v)
 {
@@ -164,6 +195,26 @@ ink_aio_init(ModuleVersion v)
 #if TS_USE_LINUX_NATIVE_AIO
   Warning("Running with Linux AIO, there are known issues with this feature");
 #endif
+#if AIO_MODE == AIO_MODE_IO_URING
+  char *mode = REC_ConfigReadString("proxy.config.aio.mode");
+  if (mode) {
+    if (strcasecmp(mode, "thread") == 0) {
+      ink_aio_set_mode(AIO_MODE_THREAD);
+    } else if (strcasecmp(mode, "io_uring") == 0) {
+      ink_aio_set_mode(AIO_MODE_IO_URING);
+      aio_io_uring_required = true;
+    } else if (strcasecmp(mode, "auto") != 0) {
+      Warning("invalid value '%s' for proxy.config.aio.mode, using 'auto'", mode);
+    }
+    ats_free(mode);
+  }
+  REC_ReadConfigInteger(aio_io_uring_entries, "proxy.config.aio.io_uring.entries");
+  if (aio_io_uring_entries <= 0) {
+    aio_io_uring_entries = MAX_AIO_EVENTS;
+  }
+  ink_mutex_init(&aio_fixed_mutex);
+  Debug("aio", "using %s for disk IO", aio_mode == AIO_MODE_IO_URING ? "io_uring" : "AIO threads");
+#endif
 }
 
 int
@@ -430,9 +481,28 @@ cache_op(AIOCallbackInternal *op)
   return 1;
 }
 
+/* tell the registered error handler that a disk operation failed */
+static void
+aio_notify_error(AIOCallback *op)
+{
+  if (aio_err_callbck) {
+    AIOCallback *callback_op          = new AIOCallbackInternal();
+    callback_op->aiocb.aio_fildes     = op->aiocb.aio_fildes;
+    callback_op->aiocb.aio_lio_opcode = op->aiocb.aio_lio_opcode;
+    callback_op->mutex                = aio_err_callbck->mutex;
+    callback_op->action               = aio_err_callbck;
+    eventProcessor.schedule_imm(callback_op);
+  }
+}
+
 int
 ink_aio_read(AIOCallback *op, int fromAPI)
 {
+#if AIO_MODE == AIO_MODE_IO_URING
+  if (!fromAPI && aio_io_uring_queue(op, LIO_READ)) {
+    return 1;
+  }
+#endif
   op->aiocb.aio_lio_opcode = LIO_READ;
   aio_queue_req((AIOCallbackInternal *)op, fromAPI);
 
@@ -442,6 +512,11 @@ ink_aio_read(AIOCallback *op, int fromAPI)
 int
 ink_aio_write(AIOCallback *op, int fromAPI)
 {
+#if AIO_MODE == AIO_MODE_IO_URING
+  if (!fromAPI && aio_io_uring_queue(op, LIO_WRITE)) {
+    return 1;
+  }
+#endif
   op->aiocb.aio_lio_opcode = LIO_WRITE;
   aio_queue_req((AIOCallbackInternal *)op, fromAPI);
 
@@ -496,14 +571,7 @@ aio_thread_main(void *arg)
       }
       ink_mutex_release(&current_req->aio_mutex);
       if (cache_op((AIOCallbackInternal *)op) <= 0) {
-        if (aio_err_callbck) {
-          AIOCallback *callback_op          = new AIOCallbackInternal();
-          callback_op->aiocb.aio_fildes     = op->aiocb.aio_fildes;
-          callback_op->aiocb.aio_lio_opcode = op->aiocb.aio_lio_opcode;
-          callback_op->mutex                = aio_err_callbck->mutex;
-          callback_op->action               = aio_err_callbck;
-          eventProcessor.schedule_imm(callback_op);
-        }
+        aio_notify_error(op);
       }
       ink_atomic_increment((int *)&current_req->requests_queued, -1);
 #ifdef AIO_STATS
@@ -684,3 +752,459 @@ ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
   return 1;
 }
 #endif // AIO_MODE != AIO_MODE_NATIVE
+
+#if AIO_MODE == AIO_MODE_IO_URING
+/*
+ * io_uring
+ */
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <vector>
+
+// Low bit of the completion user_data, set when the request used a registered buffer.
+#define AIO_FIXED_BUFFER_TAG ((uintptr_t)1)
+
+// A buffer registered with ink_aio_register_buffer(), picked up by each ring when idle. @a rings
+// counts the rings that have it registered with the kernel, an unregistered buffer is only freed
+// once the last of them has dropped it.
+struct AIOFixedBuffer {
+  struct iovec iov;
+  int rings;
+  bool retired;
+};
+
+static std::vector<AIOFixedBuffer> aio_fixed_list;
+static volatile int aio_fixed_gen = 0;
+
+static int
+sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+  return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int
+sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+static int
+sys_io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args)
+{
+  return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+void
+ink_aio_register_buffer(void *buf, size_t len)
+{
+  AIOFixedBuffer fb;
+
+  fb.iov.iov_base = buf;
+  fb.iov.iov_len  = len;
+  fb.rings        = 0;
+  fb.retired      = false;
+  ink_mutex_acquire(&aio_fixed_mutex);
+  aio_fixed_list.push_back(fb);
+  ink_atomic_increment(&aio_fixed_gen, 1);
+  ink_mutex_release(&aio_fixed_mutex);
+}
+
+void
+ink_aio_unregister_buffer(void *buf)
+{
+  bool in_use = false;
+
+  ink_mutex_acquire(&aio_fixed_mutex);
+  for (auto spot = aio_fixed_list.begin(); spot != aio_fixed_list.end(); ++spot) {
+    if (spot->iov.iov_base == buf) {
+      ink_atomic_increment(&aio_fixed_gen, 1);
+      if (spot->rings > 0) {
+        // Still pinned by a ring, the last one to drop it frees it.
+        spot->retired = true;
+        in_use        = true;
+      } else {
+        aio_fixed_list.erase(spot);
+      }
+      break;
+    }
+  }
+  ink_mutex_release(&aio_fixed_mutex);
+
+  if (!in_use) {
+    ats_memalign_free(buf);
+  }
+}
+
+/* take a ring reference on every live fixed buffer, returns the current generation */
+static int
+aio_fixed_acquire(std::vector<struct iovec> &list)
+{
+  int gen;
+
+  ink_mutex_acquire(&aio_fixed_mutex);
+  gen = aio_fixed_gen;
+  for (auto &fb : aio_fixed_list) {
+    if (!fb.retired) {
+      ++fb.rings;
+      list.push_back(fb.iov);
+    }
+  }
+  ink_mutex_release(&aio_fixed_mutex);
+  return gen;
+}
+
+/* drop a ring reference on each of @a bufs, freeing unregistered buffers no ring uses anymore */
+static void
+aio_fixed_release(const struct iovec *bufs, int n)
+{
+  std::vector<void *> dead;
+
+  ink_mutex_acquire(&aio_fixed_mutex);
+  for (int i = 0; i < n; ++i) {
+    for (auto spot = aio_fixed_list.begin(); spot != aio_fixed_list.end(); ++spot) {
+      if (spot->iov.iov_base == bufs[i].iov_base) {
+        if (--spot->rings == 0 && spot->retired) {
+          dead.push_back(spot->iov.iov_base);
+          aio_fixed_list.erase(spot);
+        }
+        break;
+      }
+    }
+  }
+  ink_mutex_release(&aio_fixed_mutex);
+
+  for (auto buf : dead) {
+    ats_memalign_free(buf);
+  }
+}
+
+/* run the callback of a finished request on the polling thread @a t */
+static void
+aio_io_uring_complete(AIOCallback *op, EThread *t)
+{
+  if (!op->ok()) {
+    Warning("cache disk operation failed %s %" PRId64 " %d\n", (op->aiocb.aio_lio_opcode == LIO_READ) ? "READ" : "WRITE",
+            op->aio_result, (int)-op->aio_result);
+    aio_notify_error(op);
+  }
+  op->link.prev = nullptr;
+  op->link.next = nullptr;
+  op->mutex     = op->action.mutex;
+  if (op->thread == AIO_CALLBACK_THREAD_ANY || op->thread == AIO_CALLBACK_THREAD_AIO || op->thread == t) {
+    MUTEX_TRY_LOCK(lock, op->mutex, t);
+    if (!lock.is_locked()) {
+      t->schedule_imm(op);
+    } else if (!op->action.cancelled) {
+      op->action.continuation->handleEvent(AIO_EVENT_DONE, op);
+    }
+  } else {
+    op->thread->schedule_imm_signal(op);
+  }
+}
+
+/* queue @a op (and anything chained by @c then) on the ring of the calling thread */
+static bool
+aio_io_uring_queue(AIOCallback *op, int opcode)
+{
+  EThread *t      = this_ethread();
+  DiskHandler *dh = t ? t->diskHandler : nullptr;
+  AIOCallback *io;
+  int sz = 0;
+
+  if (!dh || !dh->is_active()) {
+    return false;
+  }
+
+  for (io = op; io; io = io->then) {
+    io->aiocb.aio_lio_opcode = opcode;
+    ++sz;
+  }
+
+  if (sz > 1) {
+    ink_assert(op->action.continuation);
+    AIOVec *vec = new AIOVec(sz, op);
+    for (io = op; io; io = io->then) {
+      io->action = vec;
+    }
+  }
+
+  for (io = op; io; io = io->then) {
+    if (opcode == LIO_WRITE) {
+      aio_num_write++;
+      aio_bytes_written += io->aiocb.aio_nbytes;
+    } else {
+      aio_num_read++;
+      aio_bytes_read += io->aiocb.aio_nbytes;
+    }
+    dh->queue(io);
+  }
+  return true;
+}
+
+DiskHandler::~DiskHandler()
+{
+  if (sqes) {
+    munmap(sqes, sqes_sz);
+  }
+  if (cq_ring_ptr && cq_ring_ptr != sq_ring_ptr) {
+    munmap(cq_ring_ptr, cq_ring_sz);
+  }
+  if (sq_ring_ptr) {
+    munmap(sq_ring_ptr, sq_ring_sz);
+  }
+  if (ring_fd >= 0) {
+    close(ring_fd);
+  }
+  aio_fixed_release(fixed_buffers, n_fixed_buffers);
+  ats_free(fixed_buffers);
+}
+
+bool
+DiskHandler::ring_setup(unsigned entries)
+{
+  struct io_uring_params p;
+  char *sq, *cq;
+
+  memset(&p, 0, sizeof(p));
+  int fd = sys_io_uring_setup(entries, &p);
+  if (fd < 0) {
+    return false;
+  }
+
+  sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_ring_sz = cq_ring_sz = std::max(sq_ring_sz, cq_ring_sz);
+  }
+  sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+
+  sq_ring_ptr = mmap(nullptr, sq_ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring_ptr == MAP_FAILED) {
+    sq_ring_ptr = nullptr;
+    close(fd);
+    return false;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ptr = sq_ring_ptr;
+  } else {
+    cq_ring_ptr = mmap(nullptr, cq_ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ring_ptr == MAP_FAILED) {
+      cq_ring_ptr = nullptr;
+      close(fd);
+      return false;
+    }
+  }
+  void *ptr = mmap(nullptr, sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (ptr == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  sqes = (struct io_uring_sqe *)ptr;
+
+  sq         = (char *)sq_ring_ptr;
+  sq_head    = (unsigned *)(sq + p.sq_off.head);
+  sq_tail    = (unsigned *)(sq + p.sq_off.tail);
+  sq_mask    = (unsigned *)(sq + p.sq_off.ring_mask);
+  sq_array   = (unsigned *)(sq + p.sq_off.array);
+  sq_entries = p.sq_entries;
+
+  cq      = (char *)cq_ring_ptr;
+  cq_head = (unsigned *)(cq + p.cq_off.head);
+  cq_tail = (unsigned *)(cq + p.cq_off.tail);
+  cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+  cqes    = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+  ring_fd = fd;
+  return true;
+}
+
+/* fill in a submission queue entry for @a op, returns false if the queue is full */
+bool
+DiskHandler::prep(AIOCallback *op)
+{
+  unsigned tail = *sq_tail;
+  if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+    return false;
+  }
+
+  ink_aiocb *a   = &op->aiocb;
+  bool read      = (a->aio_lio_opcode == LIO_READ);
+  char *buf      = (char *)a->aio_buf + op->aio_result;
+  size_t len     = a->aio_nbytes - op->aio_result;
+  uintptr_t data = (uintptr_t)op;
+  unsigned idx   = tail & *sq_mask;
+
+  struct io_uring_sqe *sqe = &sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = read ? IORING_OP_READ : IORING_OP_WRITE;
+  sqe->fd     = a->aio_fildes;
+  sqe->off    = a->aio_offset + op->aio_result;
+  sqe->addr   = (uintptr_t)buf;
+  sqe->len    = len;
+  // Once the buffer set changes, stop using the old registrations so the ring goes idle and
+  // drops them. An unregistered buffer may be freed as soon as that happens.
+  for (int i = 0; buffer_gen == aio_fixed_gen && i < n_fixed_buffers; ++i) {
+    char *base = (char *)fixed_buffers[i].iov_base;
+    if (buf >= base && buf + len <= base + fixed_buffers[i].iov_len) {
+      sqe->opcode    = read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+      sqe->buf_index = i;
+      data |= AIO_FIXED_BUFFER_TAG;
+      ++fixed_in_flight;
+      break;
+    }
+  }
+  sqe->user_data = data;
+
+  sq_array[idx] = idx;
+  __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ++sq_pending;
+  ++in_flight;
+  return true;
+}
+
+void
+DiskHandler::queue(AIOCallback *op)
+{
+  ink_assert(op->action.continuation);
+  op->aio_result = 0;
+  if (ready_list.head || !prep(op)) {
+    ready_list.enqueue(op);
+  }
+}
+
+/* hand everything queued since the last pass to the kernel with one system call */
+void
+DiskHandler::submit()
+{
+  AIOCallback *op;
+
+  while ((op = ready_list.dequeue()) != nullptr) {
+    if (!prep(op)) {
+      ready_list.push(op);
+      break;
+    }
+  }
+
+  if (sq_pending == 0) {
+    return;
+  }
+
+  int ret;
+  do {
+    ret = sys_io_uring_enter(ring_fd, sq_pending, 0, 0);
+  } while (ret < 0 && errno == EINTR);
+
+  if (ret < 0) {
+    // EAGAIN and EBUSY leave the entries on the ring, they are retried on the next pass.
+    if (errno != EAGAIN && errno != EBUSY) {
+      Warning("io_uring_enter failed: %s (%d)", strerror(errno), errno);
+    }
+    return;
+  }
+  sq_pending -= ret;
+}
+
+/* move finished requests from the completion queue to complete_list */
+void
+DiskHandler::reap()
+{
+  unsigned head = *cq_head;
+  unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+  for (; head != tail; ++head) {
+    struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+    AIOCallback *op          = (AIOCallback *)(cqe->user_data & ~AIO_FIXED_BUFFER_TAG);
+
+    if (cqe->user_data & AIO_FIXED_BUFFER_TAG) {
+      --fixed_in_flight;
+    }
+    --in_flight;
+
+    if (cqe->res <= 0) {
+      op->aio_result = cqe->res ? cqe->res : -EIO;
+    } else {
+      op->aio_result += cqe->res;
+      if (op->aio_result < (int64_t)op->aiocb.aio_nbytes) {
+        // short transfer, issue the remainder
+        ready_list.push(op);
+        continue;
+      }
+    }
+    complete_list.enqueue(op);
+  }
+  __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+}
+
+/* register the current set of fixed buffers with this ring */
+void
+DiskHandler::update_fixed_buffers()
+{
+  std::vector<struct iovec> list;
+
+  if (n_fixed_buffers) {
+    sys_io_uring_register(ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+    aio_fixed_release(fixed_buffers, n_fixed_buffers);
+    ats_free(fixed_buffers);
+    fixed_buffers   = nullptr;
+    n_fixed_buffers = 0;
+  }
+  buffer_gen = aio_fixed_acquire(list);
+
+  if (list.empty()) {
+    return;
+  }
+  if (sys_io_uring_register(ring_fd, IORING_REGISTER_BUFFERS, list.data(), list.size()) < 0) {
+    // Typically RLIMIT_MEMLOCK, the requests still work without registration.
+    Debug("aio", "unable to register %zu io_uring buffers: %s", list.size(), strerror(errno));
+    aio_fixed_release(list.data(), list.size());
+    return;
+  }
+  fixed_buffers = (struct iovec *)ats_malloc(list.size() * sizeof(struct iovec));
+  memcpy(fixed_buffers, list.data(), list.size() * sizeof(struct iovec));
+  n_fixed_buffers = list.size();
+}
+
+int
+DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
+{
+  if (aio_mode != AIO_MODE_IO_URING) {
+    return EVENT_DONE;
+  }
+
+  if (!ring_setup(aio_io_uring_entries)) {
+    if (aio_io_uring_required) {
+      Fatal("unable to create an io_uring instance: %s (%d)", strerror(errno), errno);
+    }
+    Warning("unable to create an io_uring instance: %s (%d), falling back to AIO threads", strerror(errno), errno);
+    return EVENT_DONE;
+  }
+#if HAVE_EVENTFD
+  if (sys_io_uring_register(ring_fd, IORING_REGISTER_EVENTFD, &e->ethread->evfd, 1) < 0) {
+    Debug("aio", "unable to register eventfd with io_uring: %s (%d)", strerror(errno), errno);
+  }
+#endif
+
+  SET_HANDLER(&DiskHandler::mainAIOEvent);
+  e->schedule_every(AIO_PERIOD);
+  trigger_event = e;
+  return EVENT_CONT;
+}
+
+int
+DiskHandler::mainAIOEvent(int /* event ATS_UNUSED */, Event *e)
+{
+  AIOCallback *op;
+
+  reap();
+  // Callbacks may queue new requests, run them before submitting so those go out in this pass.
+  while ((op = complete_list.dequeue()) != nullptr) {
+    aio_io_uring_complete(op, e->ethread);
+  }
+  if (buffer_gen != aio_fixed_gen && fixed_in_flight == 0) {
+    update_fixed_buffers();
+  }
+  submit();
+  return EVENT_CONT;
+}
+#endif // AIO_MODE == AIO_MODE_IO_URING
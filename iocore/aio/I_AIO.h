@@ -43,9 +43,12 @@
 
 #define AIO_MODE_THREAD 0
 #define AIO_MODE_NATIVE 1
+#define AIO_MODE_IO_URING 2
 
 #if TS_USE_LINUX_NATIVE_AIO
 #define AIO_MODE AIO_MODE_NATIVE
+#elif TS_USE_LINUX_IO_URING
+#define AIO_MODE AIO_MODE_IO_URING
 #else
 #define AIO_MODE AIO_MODE_THREAD
 #endif
@@ -111,7 +114,7 @@ struct AIOCallback : public Continuation {
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 
 struct AIOVec : public Continuation {
   Action action;
@@ -127,6 +130,9 @@ struct AIOVec : public Continuation {
 
   int mainEvent(int event, Event *e);
 };
+#endif
+
+#if AIO_MODE == AIO_MODE_NATIVE
 
 struct DiskHandler : public Continuation {
   Event *trigger_event;
@@ -146,8 +152,100 @@ struct DiskHandler : public Continuation {
     }
   }
 };
+
+#elif AIO_MODE == AIO_MODE_IO_URING
+
+#include <linux/io_uring.h>
+
+#define MAX_AIO_EVENTS 1024
+
+/**
+  Per ET_NET thread io_uring instance.
+
+  Requests issued from the owning thread are placed directly on the submission queue
+  and handed to the kernel with a single io_uring_enter() from the poll event, so every
+  request made during one pass of the event loop is submitted as one batch. Completions
+  are reaped on the same thread; the thread's eventfd is registered with the ring so a
+  completion wakes the thread out of epoll_wait().
+
+  If the ring cannot be created, or proxy.config.aio.mode selects the thread pool, the
+  handler stays idle and requests fall back to the AIO threads.
+*/
+struct DiskHandler : public Continuation {
+  Event *trigger_event = nullptr;
+  int ring_fd          = -1;
+
+  /// Submission queue, mapped from the kernel.
+  unsigned *sq_head         = nullptr;
+  unsigned *sq_tail         = nullptr;
+  unsigned *sq_mask         = nullptr;
+  unsigned *sq_array        = nullptr;
+  struct io_uring_sqe *sqes = nullptr;
+  unsigned sq_entries       = 0;
+  unsigned sq_pending       = 0; ///< Entries filled in but not yet passed to io_uring_enter().
+
+  /// Completion queue, mapped from the kernel.
+  unsigned *cq_head         = nullptr;
+  unsigned *cq_tail         = nullptr;
+  unsigned *cq_mask         = nullptr;
+  struct io_uring_cqe *cqes = nullptr;
+
+  void *sq_ring_ptr = nullptr;
+  size_t sq_ring_sz = 0;
+  void *cq_ring_ptr = nullptr;
+  size_t cq_ring_sz = 0;
+  size_t sqes_sz    = 0;
+
+  int in_flight               = 0; ///< Requests owned by the kernel.
+  int fixed_in_flight         = 0; ///< Requests in flight that use a registered buffer.
+  int buffer_gen              = 0; ///< Generation of the registered buffer set on this ring.
+  int n_fixed_buffers         = 0;
+  struct iovec *fixed_buffers = nullptr;
+
+  Que(AIOCallback, link) ready_list;
+  Que(AIOCallback, link) complete_list;
+
+  bool
+  is_active() const
+  {
+    return ring_fd >= 0;
+  }
+
+  void queue(AIOCallback *op);
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+
+  DiskHandler() { SET_HANDLER(&DiskHandler::startAIOEvent); }
+  ~DiskHandler();
+
+private:
+  bool ring_setup(unsigned entries);
+  bool prep(AIOCallback *op);
+  void submit();
+  void reap();
+  void update_fixed_buffers();
+};
+
+/** Register @a buf for use as an io_uring fixed buffer.
+
+    Every ring picks up the registration the next time it is idle. Intended for long lived,
+    heavily used buffers such as the volume aggregation buffers. @a buf must come from
+    ats_memalign(); ink_aio_unregister_buffer() takes it over and frees it once no ring has it
+    pinned anymore, the caller must not free it.
+*/
+void ink_aio_register_buffer(void *buf, size_t len);
+void ink_aio_unregister_buffer(void *buf);
 #endif
 
+/** Select the AIO implementation at run time.
+
+    @a mode must be AIO_MODE_THREAD or the compiled-in AIO_MODE. Must be called before any
+    DiskHandler is started; proxy.config.aio.mode is applied by ink_aio_init().
+    @return @c true if @a mode is available in this build.
+*/
+bool ink_aio_set_mode(int mode);
+int ink_aio_get_mode();
+
 void ink_aio_init(ModuleVersion version);
 int ink_aio_start();
 void ink_aio_set_callback(Continuation *error_callback);
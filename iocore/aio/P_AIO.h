@@ -73,7 +73,9 @@ AIOCallbackInternal::io_complete(int event, void *data)
     action.continuation->handleEvent(AIO_EVENT_DONE, this);
   return EVENT_DONE;
 }
+#endif // AIO_MODE == AIO_MODE_NATIVE
 
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 TS_INLINE int
 AIOVec::mainEvent(int /* event */, Event *)
 {
@@ -90,8 +92,9 @@ AIOVec::mainEvent(int /* event */, Event *)
   ink_assert(!"AIOVec mainEvent err");
   return EVENT_ERROR;
 }
+#endif
 
-#else /* AIO_MODE != AIO_MODE_NATIVE */
+#if AIO_MODE != AIO_MODE_NATIVE
 
 struct AIO_Reqs;
 
@@ -129,7 +132,7 @@ struct AIO_Reqs {
   volatile int requests_queued;
 };
 
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE != AIO_MODE_NATIVE
 #ifdef AIO_STATS
 class AIOTestData : public Continuation
 {
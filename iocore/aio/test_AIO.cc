@@ -26,6 +26,7 @@
 #include "ts/I_Layout.h"
 #include <iostream>
 #include <fstream>
+#include <string>
 
 using std::cout;
 using std::endl;
@@ -83,6 +84,7 @@ double real_rand_read_percent = 0.0;
 int seq_read_size             = 0;
 int seq_write_size            = 0;
 int rand_read_size            = 0;
+std::string aio_mode          = "default";
 
 struct AIO_Device : public Continuation {
   char *path;
@@ -164,6 +166,8 @@ dump_summary()
   printf("%d disks\n", n_disk_path);
   printf("%d chains\n", chains);
   printf("%d threads_per_disk\n", threads_per_disk);
+  printf("%s aio_mode\n", ink_aio_get_mode() == AIO_MODE_IO_URING ? "io_uring" :
+                          (ink_aio_get_mode() == AIO_MODE_NATIVE ? "native" : "thread"));
 
   printf("%0.1f percent %d byte seq_reads by volume\n", seq_read_percent * 100.0, seq_read_size);
   printf("%0.1f percent %d byte seq_writes by volume\n", seq_write_percent * 100.0, seq_write_size);
@@ -376,6 +380,7 @@ read_config(const char *config_filename)
     PARAM(chains)
     PARAM(threads_per_disk)
     PARAM(delete_disks)
+    PARAM(aio_mode)
     else if (strcmp(field_name, "disk_path") == 0)
     {
       assert(n_disk_path < MAX_DISK_THREADS);
@@ -420,16 +425,6 @@ main(int /* argc ATS_UNUSED */, char *argv[])
   Thread *main_thread = new EThread;
   main_thread->set_specific();
 
-#if AIO_MODE == AIO_MODE_NATIVE
-  int etype            = ET_NET;
-  int n_netthreads     = eventProcessor.n_threads_for_type[etype];
-  EThread **netthreads = eventProcessor.eventthread[etype];
-  for (int i = 0; i < n_netthreads; ++i) {
-    netthreads[i]->diskHandler = new DiskHandler();
-    netthreads[i]->schedule_imm(netthreads[i]->diskHandler);
-  }
-#endif
-
   RecProcessStart();
   ink_aio_init(AIO_MODULE_VERSION);
   srand48(time(nullptr));
@@ -438,6 +433,24 @@ main(int /* argc ATS_UNUSED */, char *argv[])
     exit(1);
   }
 
+  // Compare the implementations by running the same configuration with each aio_mode.
+  if ((aio_mode == "thread" && !ink_aio_set_mode(AIO_MODE_THREAD)) ||
+      (aio_mode == "native" && !ink_aio_set_mode(AIO_MODE_NATIVE)) ||
+      (aio_mode == "io_uring" && !ink_aio_set_mode(AIO_MODE_IO_URING))) {
+    cout << "aio_mode " << aio_mode << " is not available in this build" << endl;
+    exit(0);
+  }
+
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
+  int etype            = ET_NET;
+  int n_netthreads     = eventProcessor.thread_group[etype]._count;
+  EThread **netthreads = eventProcessor.thread_group[etype]._thread;
+  for (int i = 0; i < n_netthreads; ++i) {
+    netthreads[i]->diskHandler = new DiskHandler();
+    netthreads[i]->schedule_imm(netthreads[i]->diskHandler);
+  }
+#endif
+
   max_size = seq_read_size;
   if (seq_write_size > max_size) {
     max_size = seq_write_size;
@@ -314,6 +314,32 @@ unlink_from_freelist(Dir *e, int s, Vol *d)
   }
 }
 
+// Take a free entry from the buckets next to bucket @a bi, if there is one.
+// Entries from the freelist are scattered over the whole segment, so a chain
+// built from them costs a cache miss per link on every probe.
+static inline Dir *
+dir_neighbor_free_entry(int bi, int s, Vol *d)
+{
+  Dir *seg = dir_segment(s, d);
+  for (int i = 1; i <= DIR_NEIGHBOR_BUCKETS; i++) {
+    int nb[2] = {bi + i, bi - i};
+    for (int j = 0; j < 2; j++) {
+      if (nb[j] < 0 || nb[j] >= d->buckets) {
+        continue;
+      }
+      Dir *b = dir_bucket(nb[j], seg);
+      for (int l = 1; l < DIR_DEPTH; l++) {
+        Dir *e = dir_bucket_row(b, l);
+        if (dir_is_empty(e)) {
+          unlink_from_freelist(e, s, d);
+          return e;
+        }
+      }
+    }
+  }
+  return nullptr;
+}
+
 inline Dir *
 dir_delete_entry(Dir *e, Dir *p, int s, Vol *d)
 {
@@ -633,6 +659,10 @@ Lagain:
       goto Llink;
     }
   }
+  // then from the neighboring buckets
+  if ((e = dir_neighbor_free_entry(bi, s, d))) {
+    goto Llink;
+  }
   // get one from the freelist
   e = freelist_pop(s, d);
   if (!e) {
@@ -709,6 +739,10 @@ Lagain:
       goto Llink;
     }
   }
+  // then from the neighboring buckets
+  if ((e = dir_neighbor_free_entry(bi, s, d))) {
+    goto Llink;
+  }
   // get one from the freelist
   e = freelist_pop(s, d);
   if (!e) {
@@ -1447,6 +1481,20 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir)(RegressionTest *t, int /* atype ATS_UNUSED
   int s    = key.slice32(0) % d->segments, i, j;
   Dir *seg = dir_segment(s, d);
 
+  // test that a full bucket overflows into its neighbors
+  rprintf(t, "neighbor test\n");
+  int bi = key.slice32(1) % d->buckets;
+  for (i = 0; i <= DIR_DEPTH; i++) {
+    dir_insert(&key, d, &dir);
+  }
+  int nbi = dir_to_offset(next_dir(dir_bucket(bi, seg), seg), seg) / DIR_DEPTH;
+  rprintf(t, "bucket %d overflowed into bucket %d\n", bi, nbi);
+  if (nbi == bi || abs(nbi - bi) > DIR_NEIGHBOR_BUCKETS) {
+    ret = REGRESSION_TEST_FAILED;
+  }
+  vol_dir_clear(d);
+  d->header->agg_pos = d->header->write_pos += 1024;
+
   // test insert
   rprintf(t, "insert test\n", free);
   int inserted = 0;
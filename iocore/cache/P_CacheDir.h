@@ -50,6 +50,10 @@ struct CacheVC;
 #define DIR_BLOCK_SHIFT(_i) (3 * (_i))
 #define DIR_BLOCK_SIZE(_i) (CACHE_BLOCK_SIZE << DIR_BLOCK_SHIFT(_i))
 #define DIR_SIZE_WITH_BLOCK(_i) ((1 << DIR_SIZE_WIDTH) * DIR_BLOCK_SIZE(_i))
+// When a bucket overflows, free entries of up to this many buckets on either
+// side are used before the segment freelist so the chain stays within a few
+// cache lines of the bucket head.
+#define DIR_NEIGHBOR_BUCKETS 2
 #define DIR_OFFSET_BITS 40
 #define DIR_OFFSET_MAX ((((off_t)1) << DIR_OFFSET_BITS) - 1)
 
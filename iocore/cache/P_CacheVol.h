@@ -248,10 +248,20 @@ struct Vol : public Continuation {
     open_dir.mutex = mutex;
     agg_buffer     = (char *)ats_memalign(ats_pagesize(), AGG_SIZE);
     memset(agg_buffer, 0, AGG_SIZE);
+#if AIO_MODE == AIO_MODE_IO_URING
+    ink_aio_register_buffer(agg_buffer, AGG_SIZE);
+#endif
     SET_HANDLER(&Vol::aggWrite);
   }
 
-  ~Vol() { ats_memalign_free(agg_buffer); }
+  ~Vol()
+  {
+#if AIO_MODE == AIO_MODE_IO_URING
+    ink_aio_unregister_buffer(agg_buffer); // frees it when no ring uses it anymore
+#else
+    ats_memalign_free(agg_buffer);
+#endif
+  }
 };
 
 struct AIO_Callback_handler : public Continuation {
@@ -298,6 +298,7 @@ public:
 
   static constexpr int NO_ETHREAD_ID = -1;
   int id                             = NO_ETHREAD_ID;
+  int numa_node                      = -1; ///< NUMA node the thread is bound to, -1 if none.
   unsigned int event_types           = 0;
   bool is_event_type(EventType et);
   void set_event_type(EventType et);
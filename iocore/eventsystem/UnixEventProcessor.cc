@@ -60,11 +60,15 @@ protected:
 
   /// Allocate a stack based on NUMA information, if possible.
   void *alloc_numa_stack(EThread *t, size_t stacksize);
+  /// Find the NUMA nodes of @a obj and the memory policy to use for them. If @a obj lies within
+  /// a single node its logical index is stored in @a numa_node.
+  hwloc_membind_policy_t numa_policy(hwloc_obj_t obj, hwloc_nodeset_t nodeset, int *numa_node = nullptr);
 
 private:
   hwloc_obj_type_t obj_type;
   int obj_count        = 0;
   char const *obj_name = nullptr;
+  bool numa_membind    = false; ///< Bind all the memory a thread allocates to its NUMA nodes.
 #endif
 };
 
@@ -135,6 +139,10 @@ ThreadAffinityInitializer::init()
 
   obj_count = hwloc_get_nbobjs_by_type(ink_get_topology(), obj_type);
   Debug("iocore_thread", "Affinity: %d %ss: %d PU: %d", affinity, obj_name, obj_count, ink_number_of_processors());
+
+  int membind = 0;
+  REC_ReadConfigInteger(membind, "proxy.config.exec_thread.numa_membind");
+  numa_membind = membind && affinity != 0;
 }
 
 int
@@ -154,27 +162,40 @@ ThreadAffinityInitializer::set_affinity(int, Event *)
     Debug("iocore_thread", "EThread: %d %s: %d", _name, obj->logical_index);
 #endif // HWLOC_API_VERSION
     hwloc_set_thread_cpubind(ink_get_topology(), t->tid, obj->cpuset, HWLOC_CPUBIND_STRICT);
+
+    hwloc_nodeset_t nodeset           = hwloc_bitmap_alloc();
+    hwloc_membind_policy_t mem_policy = this->numa_policy(obj, nodeset, &t->numa_node);
+
+    // Everything this thread allocates from now on (freelist chunks, IO buffers, headers) comes from its
+    // own nodes, instead of wherever the first touch happens to land.
+    if (numa_membind && mem_policy != HWLOC_MEMBIND_DEFAULT) {
+      hwloc_set_membind_nodeset(ink_get_topology(), nodeset, mem_policy, HWLOC_MEMBIND_THREAD);
+      Debug("iocore_thread", "EThread: %p memory bound to NUMA node %d", t, t->numa_node);
+    }
+    hwloc_bitmap_free(nodeset);
   } else {
     Warning("hwloc returned an unexpected number of objects -- CPU affinity disabled");
   }
   return 0;
 }
 
-void *
-ThreadAffinityInitializer::alloc_numa_stack(EThread *t, size_t stacksize)
+hwloc_membind_policy_t
+ThreadAffinityInitializer::numa_policy(hwloc_obj_t obj, hwloc_nodeset_t nodeset, int *numa_node)
 {
   hwloc_membind_policy_t mem_policy = HWLOC_MEMBIND_DEFAULT;
-  hwloc_nodeset_t nodeset           = hwloc_bitmap_alloc();
   int num_nodes                     = 0;
-  void *stack                       = nullptr;
-  hwloc_obj_t obj                   = hwloc_get_obj_by_type(ink_get_topology(), obj_type, t->id % obj_count);
 
   // Find the NUMA node set that correlates to our next thread CPU set
   hwloc_cpuset_to_nodeset(ink_get_topology(), obj->cpuset, nodeset);
-  // How many NUMA nodes will we be needing to allocate across?
-  num_nodes = hwloc_get_nbobjs_inside_cpuset_by_type(ink_get_topology(), obj->cpuset, HWLOC_OBJ_NODE);
+  // How many NUMA nodes will we be needing to allocate across? Count the nodes the CPU set overlaps
+  // rather than those inside it, a core or PU is inside no node at all.
+  num_nodes = hwloc_bitmap_weight(nodeset);
 
   if (num_nodes == 1) {
+    hwloc_obj_t node = hwloc_get_next_obj_covering_cpuset_by_type(ink_get_topology(), obj->cpuset, HWLOC_OBJ_NODE, nullptr);
+    if (node && numa_node) {
+      *numa_node = node->logical_index;
+    }
     // The preferred memory policy. The thread lives in one NUMA node.
     mem_policy = HWLOC_MEMBIND_BIND;
   } else if (num_nodes > 1) {
@@ -182,6 +203,17 @@ ThreadAffinityInitializer::alloc_numa_stack(EThread *t, size_t stacksize)
     mem_policy = HWLOC_MEMBIND_INTERLEAVE;
   }
 
+  return mem_policy;
+}
+
+void *
+ThreadAffinityInitializer::alloc_numa_stack(EThread *t, size_t stacksize)
+{
+  hwloc_nodeset_t nodeset           = hwloc_bitmap_alloc();
+  void *stack                       = nullptr;
+  hwloc_obj_t obj                   = hwloc_get_obj_by_type(ink_get_topology(), obj_type, t->id % obj_count);
+  hwloc_membind_policy_t mem_policy = this->numa_policy(obj, nodeset);
+
   if (mem_policy != HWLOC_MEMBIND_DEFAULT) {
     // Let's temporarily set the memory binding to our destination NUMA node
     hwloc_set_membind_nodeset(ink_get_topology(), nodeset, mem_policy, HWLOC_MEMBIND_THREAD);
@@ -212,6 +212,12 @@ Server::setup_fd_for_listen(bool non_blocking, const NetProcessor::AcceptOptions
     goto Lerror;
   }
 
+#ifdef SO_REUSEPORT
+  if (reuseport && (res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, SOCKOPT_ON, sizeof(int))) < 0) {
+    goto Lerror;
+  }
+#endif
+
   if ((opt.sockopt_flags & NetVCOptions::SOCK_OPT_NO_DELAY) &&
       (res = safe_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, SOCKOPT_ON, sizeof(int))) < 0) {
     goto Lerror;
@@ -241,6 +247,31 @@ Server::setup_fd_for_listen(bool non_blocking, const NetProcessor::AcceptOptions
 #endif
   }
 
+#ifdef TCP_DEFER_ACCEPT
+  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
+  // data on the socket ready to be read
+  {
+    int defer_accept = 0;
+    REC_ReadConfigInteger(defer_accept, "proxy.config.net.defer_accept");
+    if (defer_accept > 0) {
+      setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer_accept, sizeof(int));
+    }
+  }
+#endif
+
+#ifdef TCP_INIT_CWND
+  {
+    int tcp_init_cwnd = 0;
+    REC_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
+    if (tcp_init_cwnd > 0) {
+      Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
+      if (setsockopt(fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
+        Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
+      }
+    }
+  }
+#endif
+
 #if defined(TCP_MAXSEG)
   if (NetProcessor::accept_mss > 0) {
     if ((res = safe_setsockopt(fd, IPPROTO_TCP, TCP_MAXSEG, (char *)&NetProcessor::accept_mss, sizeof(int))) < 0) {
@@ -31,7 +31,8 @@
 #include "P_Net.h"
 #include <utility>
 
-RecRawStatBlock *net_rsb = nullptr;
+RecRawStatBlock *net_rsb      = nullptr;
+RecRawStatBlock *net_numa_rsb = nullptr;
 
 // All in milli-seconds
 int net_config_poll_timeout = -1; // This will get set via either command line or records.config.
@@ -112,6 +113,21 @@ register_net_stats()
   RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.tcp.total_accepts", RECD_INT, RECP_NON_PERSISTENT,
                      static_cast<int>(net_tcp_accept_stat), RecRawStatSyncSum);
   NET_CLEAR_DYN_STAT(net_tcp_accept_stat);
+
+  const char *numa_stats[] = {"accepts", "read_bytes", "write_bytes"};
+  int numa_nodes           = ink_number_of_numa_nodes();
+
+  static_assert(sizeof(numa_stats) / sizeof(*numa_stats) == Net_Numa_Stat_Count, "missing NUMA stat name");
+  net_numa_rsb = RecAllocateRawStatBlock(numa_nodes * Net_Numa_Stat_Count);
+  for (int node = 0; node < numa_nodes; ++node) {
+    for (int i = 0; i < Net_Numa_Stat_Count; ++i) {
+      char name[64];
+
+      snprintf(name, sizeof(name), "proxy.process.net.numa.node_%d.%s", node, numa_stats[i]);
+      RecRegisterRawStat(net_numa_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, node * Net_Numa_Stat_Count + i,
+                         RecRawStatSyncSum);
+    }
+  }
 }
 
 void
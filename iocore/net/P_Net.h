@@ -59,8 +59,17 @@ enum Net_Stats {
   Net_Stat_Count
 };
 
+// Per NUMA node stats, counted for the threads bound to a single node
+enum Net_Numa_Stats {
+  net_numa_accepts_stat,
+  net_numa_read_bytes_stat,
+  net_numa_write_bytes_stat,
+  Net_Numa_Stat_Count
+};
+
 struct RecRawStatBlock;
 extern RecRawStatBlock *net_rsb;
+extern RecRawStatBlock *net_numa_rsb;
 #define SSL_HANDSHAKE_WANT_READ 6
 #define SSL_HANDSHAKE_WANT_WRITE 7
 #define SSL_HANDSHAKE_WANT_ACCEPT 8
@@ -74,6 +83,16 @@ extern RecRawStatBlock *net_rsb;
 
 #define NET_READ_DYN_SUM(_x, _sum) RecGetRawStatSum(net_rsb, (int)_x, &_sum)
 
+// Takes the thread doing the work explicitly: accepts can run under a fresh,
+// unheld mutex, so mutex->thread_holding may be NULL here.
+#define NET_NUMA_SUM_DYN_STAT(_t, _x, _r)                                                                       \
+  do {                                                                                                          \
+    EThread *_nt = (_t);                                                                                        \
+    if (_nt != nullptr && _nt->numa_node >= 0) {                                                                \
+      RecIncrRawStatSum(net_numa_rsb, _nt, _nt->numa_node * (int)Net_Numa_Stat_Count + (int)(_x), _r);          \
+    }                                                                                                           \
+  } while (0)
+
 #define NET_READ_DYN_STAT(_x, _count, _sum)        \
   do {                                             \
     RecGetRawStatSum(net_rsb, (int)_x, &_sum);     \
@@ -89,6 +89,8 @@ struct NetAccept : public Continuation {
   Ptr<NetAcceptAction> action_;
   SSLNextProtocolAccept *snpa = nullptr;
   EventIO ep;
+  /// proxy.config.exec_thread.listen, non-zero if this accept has its own SO_REUSEPORT socket.
+  int listen_per_thread = 0;
 
   HttpProxyPort *proxyPort = nullptr;
   NetProcessor::AcceptOptions opt;
@@ -79,6 +79,8 @@ struct SSLConfigParams : public ConfigInfo {
   int ssl_session_cache_skip_on_contention;
   int ssl_session_cache_timeout;
   int ssl_session_cache_auto_clear;
+  int ssl_session_cache_keep_parsed;
+  int ssl_session_cache_per_thread_size;
 
   char *clientCertPath;
   char *clientKeyPath;
@@ -101,6 +103,8 @@ struct SSLConfigParams : public ConfigInfo {
   static size_t session_cache_number_buckets;
   static size_t session_cache_max_bucket_size;
   static bool session_cache_skip_on_lock_contention;
+  static bool session_cache_keep_parsed;
+  static size_t session_cache_per_thread_size;
 
   // TS-3435 Wiretracing for SSL Connections
   static int ssl_wire_trace_enabled;
@@ -79,6 +79,10 @@ enum SSL_Stats {
   ssl_session_cache_eviction,
   ssl_session_cache_lock_contention,
   ssl_session_cache_new_session,
+  ssl_session_cache_index_lookup,
+  ssl_session_cache_index_probe,
+  ssl_session_cache_shard_hit,
+  ssl_session_cache_promotion,
 
   /* error stats */
   ssl_error_want_write,
@@ -54,6 +54,8 @@ int SSLConfigParams::ssl_handshake_timeout_in               = 0;
 size_t SSLConfigParams::session_cache_number_buckets        = 1024;
 bool SSLConfigParams::session_cache_skip_on_lock_contention = false;
 size_t SSLConfigParams::session_cache_max_bucket_size       = 100;
+bool SSLConfigParams::session_cache_keep_parsed             = false;
+size_t SSLConfigParams::session_cache_per_thread_size       = 0;
 init_ssl_ctx_func SSLConfigParams::init_ssl_ctx_cb          = nullptr;
 load_ssl_file_func SSLConfigParams::load_ssl_file_cb        = nullptr;
 
@@ -101,6 +103,8 @@ SSLConfigParams::reset()
   ssl_session_cache_skip_on_contention = 0;
   ssl_session_cache_timeout            = 0;
   ssl_session_cache_auto_clear         = 1;
+  ssl_session_cache_keep_parsed        = 0;
+  ssl_session_cache_per_thread_size    = 0;
   configExitOnLoadError                = 1;
 }
 
@@ -276,10 +280,14 @@ SSLConfigParams::initialize()
   REC_ReadConfigInteger(ssl_session_cache_skip_on_contention, "proxy.config.ssl.session_cache.skip_cache_on_bucket_contention");
   REC_ReadConfigInteger(ssl_session_cache_timeout, "proxy.config.ssl.session_cache.timeout");
   REC_ReadConfigInteger(ssl_session_cache_auto_clear, "proxy.config.ssl.session_cache.auto_clear");
+  REC_ReadConfigInteger(ssl_session_cache_keep_parsed, "proxy.config.ssl.session_cache.keep_parsed_session");
+  REC_ReadConfigInteger(ssl_session_cache_per_thread_size, "proxy.config.ssl.session_cache.per_thread_size");
 
   SSLConfigParams::session_cache_max_bucket_size = (size_t)ceil((double)ssl_session_cache_size / ssl_session_cache_num_buckets);
   SSLConfigParams::session_cache_skip_on_lock_contention = ssl_session_cache_skip_on_contention;
   SSLConfigParams::session_cache_number_buckets          = ssl_session_cache_num_buckets;
+  SSLConfigParams::session_cache_keep_parsed             = ssl_session_cache_keep_parsed;
+  SSLConfigParams::session_cache_per_thread_size         = ssl_session_cache_per_thread_size;
 
   if (ssl_session_cache == SSL_SESSION_CACHE_MODE_SERVER_ATS_IMPL) {
     session_cache = new SSLSessionCache();
@@ -370,6 +370,7 @@ SSLNetVConnection::read_raw_data()
   NET_SUM_DYN_STAT(net_read_bytes_stat, r);
 
   if (r > 0) {
+    NET_NUMA_SUM_DYN_STAT(this_ethread(), net_numa_read_bytes_stat, r);
     this->handShakeBuffer->fill(r);
 
     char *start              = this->handShakeReader->start();
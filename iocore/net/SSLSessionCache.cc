@@ -21,6 +21,7 @@
 
 #include "P_SSLConfig.h"
 #include "SSLSessionCache.h"
+#include "I_Net.h"
 #include <cstring>
 
 #define SSLSESSIONCACHE_STRINGIFY0(x) #x
@@ -28,25 +29,85 @@
 #define SSLSESSIONCACHE_LINENO SSLSESSIONCACHE_STRINGIFY(__LINE__)
 
 #ifdef DEBUG
-#define PRINT_BUCKET(x) this->print(x " at " __FILE__ ":" SSLSESSIONCACHE_LINENO);
+#define PRINT_BUCKET(x) this->sessions.print(x " at " __FILE__ ":" SSLSESSIONCACHE_LINENO);
 #else
 #define PRINT_BUCKET(x)
 #endif
 
 using ts::detail::RBNode;
 
+static inline void
+ssl_session_up_ref(SSL_SESSION *sess)
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L || defined(LIBRESSL_VERSION_NUMBER)
+  CRYPTO_add(&sess->references, 1, CRYPTO_LOCK_SSL_SESSION);
+#else
+  SSL_SESSION_up_ref(sess);
+#endif
+}
+
+// Hand out a new reference to the session held by @a node.
+static bool
+ssl_session_get(SSLSession *node, SSL_SESSION **sess)
+{
+  if (node->session) {
+    ssl_session_up_ref(node->session);
+    *sess = node->session;
+  } else {
+    const unsigned char *loc = reinterpret_cast<const unsigned char *>(node->asn1_data->data());
+    *sess                    = d2i_SSL_SESSION(nullptr, &loc, node->len_asn1_data);
+  }
+
+  return *sess != nullptr;
+}
+
 /* Session Cache */
-SSLSessionCache::SSLSessionCache() : session_bucket(nullptr), nbuckets(SSLConfigParams::session_cache_number_buckets)
+SSLSessionCache::SSLSessionCache()
+  : session_bucket(nullptr),
+    nbuckets(SSLConfigParams::session_cache_number_buckets),
+    shards(nullptr),
+    shard_size(SSLConfigParams::session_cache_per_thread_size)
 {
   Debug("ssl.session_cache", "Created new ssl session cache %p with %zu buckets each with size max size %zu", this, nbuckets,
         SSLConfigParams::session_cache_max_bucket_size);
 
   session_bucket = new SSLSessionBucket[nbuckets];
+
+  if (shard_size > 0) {
+    Debug("ssl.session_cache", "Session cache %p using per thread shards of size %zu", this, shard_size);
+    shards = static_cast<SSLSessionList **>(ats_calloc(MAX_EVENT_THREADS, sizeof(SSLSessionList *)));
+  }
 }
 
 SSLSessionCache::~SSLSessionCache()
 {
   delete[] session_bucket;
+
+  if (shards) {
+    for (int i = 0; i < MAX_EVENT_THREADS; ++i) {
+      delete shards[i];
+    }
+    ats_free(shards);
+  }
+}
+
+SSLSessionList *
+SSLSessionCache::getShard() const
+{
+  EThread *t = this_ethread();
+
+  // EThread::id is only unique within a thread group, so the shards are limited to the ET_NET
+  // threads which handle the handshakes. Any other thread goes straight to the locked buckets.
+  if (!shards || !t || !t->is_event_type(ET_NET)) {
+    return nullptr;
+  }
+  ink_release_assert(t->id >= 0 && t->id < MAX_EVENT_THREADS);
+
+  // Only the owning thread ever reads or writes its slot, so no locking is required.
+  if (!shards[t->id]) {
+    shards[t->id] = new SSLSessionList(shard_size);
+  }
+  return shards[t->id];
 }
 
 bool
@@ -55,6 +116,7 @@ SSLSessionCache::getSession(const SSLSessionID &sid, SSL_SESSION **sess) const
   uint64_t hash            = sid.hash();
   uint64_t target_bucket   = hash % nbuckets;
   SSLSessionBucket *bucket = &session_bucket[target_bucket];
+  SSLSessionList *shard    = getShard();
 
   if (is_debug_tag_set("ssl.session_cache")) {
     char buf[sid.len * 2 + 1];
@@ -63,6 +125,32 @@ SSLSessionCache::getSession(const SSLSessionID &sid, SSL_SESSION **sess) const
           target_bucket, bucket, buf, hash);
   }
 
+  if (shard) {
+    SSLSession *node = shard->find(sid);
+    if (node && node->generation != bucket->generation(sid)) {
+      // The bucket removed or replaced a session in this slot since this copy was promoted, possibly
+      // this one, so drop it and go back to the shared tier which is authoritative.
+      shard->remove(node);
+      delete node;
+      node = nullptr;
+    }
+    if (node) {
+      SSL_INCREMENT_DYN_STAT(ssl_session_cache_shard_hit);
+      return ssl_session_get(node, sess);
+    }
+
+    // Miss on this thread, promote the session from the shared tier if it's there.
+    SSLSession *promoted = nullptr;
+    if (bucket->getSession(sid, sess, &promoted)) {
+      if (promoted) {
+        SSL_INCREMENT_DYN_STAT(ssl_session_cache_promotion);
+        shard->insert(promoted);
+      }
+      return true;
+    }
+    return false;
+  }
+
   return bucket->getSession(sid, sess);
 }
 
@@ -72,6 +160,7 @@ SSLSessionCache::removeSession(const SSLSessionID &sid)
   uint64_t hash            = sid.hash();
   uint64_t target_bucket   = hash % nbuckets;
   SSLSessionBucket *bucket = &session_bucket[target_bucket];
+  SSLSessionList *shard    = getShard();
 
   if (is_debug_tag_set("ssl.session_cache")) {
     char buf[sid.len * 2 + 1];
@@ -80,7 +169,15 @@ SSLSessionCache::removeSession(const SSLSessionID &sid)
           target_bucket, bucket, buf, hash);
   }
 
+  // Copies of the session in other threads' shards are invalidated by the bucket slot generation.
   SSL_INCREMENT_DYN_STAT(ssl_session_cache_eviction);
+  if (shard) {
+    SSLSession *node = shard->find(sid);
+    if (node) {
+      shard->remove(node);
+      delete node;
+    }
+  }
   bucket->removeSession(sid);
 }
 
@@ -98,9 +195,24 @@ SSLSessionCache::insertSession(const SSLSessionID &sid, SSL_SESSION *sess)
           target_bucket, bucket, buf, hash);
   }
 
+  // New sessions only go to the shared tier, the first resumption promotes them into the
+  // shard of the thread that handles it.
   bucket->insertSession(sid, sess);
 }
 
+/* Session Bucket */
+SSLSessionBucket::SSLSessionBucket()
+  : mutex(new_ProxyMutex()), sessions(SSLConfigParams::session_cache_max_bucket_size)
+{
+  for (auto &generation : _generation) {
+    generation.store(0, std::memory_order_relaxed);
+  }
+}
+
+SSLSessionBucket::~SSLSessionBucket()
+{
+}
+
 void
 SSLSessionBucket::insertSession(const SSLSessionID &id, SSL_SESSION *sess)
 {
@@ -123,7 +235,13 @@ SSLSessionBucket::insertSession(const SSLSessionID &id, SSL_SESSION *sess)
   unsigned char *loc = reinterpret_cast<unsigned char *>(buf->data());
   i2d_SSL_SESSION(sess, &loc);
 
-  ats_scoped_obj<SSLSession> ssl_session(new SSLSession(id, buf, len));
+  SSL_SESSION *parsed = nullptr;
+  if (SSLConfigParams::session_cache_keep_parsed) {
+    ssl_session_up_ref(sess);
+    parsed = sess;
+  }
+
+  ats_scoped_obj<SSLSession> ssl_session(new SSLSession(id, buf, len, parsed));
 
   MUTEX_TRY_LOCK(lock, mutex, this_ethread());
   if (!lock.is_locked()) {
@@ -136,18 +254,15 @@ SSLSessionBucket::insertSession(const SSLSessionID &id, SSL_SESSION *sess)
   }
 
   PRINT_BUCKET("insertSession before")
-  if (queue.size >= static_cast<int>(SSLConfigParams::session_cache_max_bucket_size)) {
-    removeOldestSession();
+  if (sessions.find(id)) {
+    _generation[generationSlot(id)].fetch_add(1, std::memory_order_release);
   }
-
-  /* do the actual insert */
-  queue.enqueue(ssl_session.release());
-
+  sessions.insert(ssl_session.release());
   PRINT_BUCKET("insertSession after")
 }
 
 bool
-SSLSessionBucket::getSession(const SSLSessionID &id, SSL_SESSION **sess)
+SSLSessionBucket::getSession(const SSLSessionID &id, SSL_SESSION **sess, SSLSession **promote)
 {
   char buf[id.len * 2 + 1];
   buf[0] = '\0'; // just to be safe.
@@ -169,81 +284,177 @@ SSLSessionBucket::getSession(const SSLSessionID &id, SSL_SESSION **sess)
 
   PRINT_BUCKET("getSession")
 
-  // We work backwards because that's the most likely place we'll find our session...
-  SSLSession *node = queue.tail;
-  while (node) {
-    if (node->session_id == id) {
-      const unsigned char *loc = reinterpret_cast<const unsigned char *>(node->asn1_data->data());
-      *sess                    = d2i_SSL_SESSION(nullptr, &loc, node->len_asn1_data);
+  SSLSession *node = sessions.find(id);
+  if (!node) {
+    Debug("ssl.session_cache", "Session with id '%s' not found in bucket %p.", buf, this);
+    return false;
+  }
 
-      return true;
+  // Deserialize outside of the bucket lock, the buffer reference keeps the data alive
+  // even if the session is evicted in the meantime.
+  SSL_SESSION *parsed    = node->session;
+  Ptr<IOBufferData> data = node->asn1_data;
+  size_t len             = node->len_asn1_data;
+  uint64_t generation    = _generation[generationSlot(id)].load(std::memory_order_relaxed);
+  if (parsed) {
+    ssl_session_up_ref(parsed); // for the caller
+    if (promote) {
+      ssl_session_up_ref(parsed); // for the promoted copy
     }
-    node = node->link.prev;
   }
+  lock.release();
+
+  if (parsed) {
+    *sess = parsed;
+  } else {
+    const unsigned char *loc = reinterpret_cast<const unsigned char *>(data->data());
+    if ((*sess = d2i_SSL_SESSION(nullptr, &loc, len)) == nullptr) {
+      return false;
+    }
+  }
+
+  if (promote) {
+    *promote               = new SSLSession(id, data, len, parsed);
+    (*promote)->generation = generation;
+  }
+  return true;
+}
 
-  Debug("ssl.session_cache", "Session with id '%s' not found in bucket %p.", buf, this);
-  return false;
+void
+SSLSessionBucket::removeSession(const SSLSessionID &id)
+{
+  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread()); // We can't bail on contention here because this session MUST be removed.
+  // Bump even if the session already aged out of the bucket, a shard may still hold a copy.
+  _generation[generationSlot(id)].fetch_add(1, std::memory_order_release);
+  SSLSession *node = sessions.find(id);
+  if (node) {
+    sessions.remove(node);
+    delete node;
+  }
 }
 
-void inline SSLSessionBucket::print(const char *ref_str) const
+/* Session List */
+SSLSessionList::SSLSessionList(size_t cap) : capacity(cap), index(nullptr), index_mask(0), index_shift(0)
 {
-  /* NOTE: This method assumes you're already holding the bucket lock */
-  if (!is_debug_tag_set("ssl.session_cache.bucket")) {
-    return;
+  // Keep the load factor at or below 1/2.
+  unsigned bits = 3;
+  while ((static_cast<size_t>(1) << bits) < 2 * capacity) {
+    ++bits;
   }
 
-  fprintf(stderr, "-------------- BUCKET %p (%s) ----------------\n", this, ref_str);
-  fprintf(stderr, "Current Size: %d, Max Size: %zd\n", queue.size, SSLConfigParams::session_cache_max_bucket_size);
-  fprintf(stderr, "Queue: \n");
+  index       = static_cast<SSLSession **>(ats_calloc(static_cast<size_t>(1) << bits, sizeof(SSLSession *)));
+  index_mask  = (static_cast<size_t>(1) << bits) - 1;
+  index_shift = 64 - bits;
+}
 
-  SSLSession *node = queue.head;
-  while (node) {
-    char s_buf[2 * node->session_id.len + 1];
-    node->session_id.toString(s_buf, sizeof(s_buf));
-    fprintf(stderr, "  %s\n", s_buf);
-    node = node->link.next;
+SSLSessionList::~SSLSessionList()
+{
+  SSLSession *node;
+  while ((node = queue.pop()) != nullptr) {
+    delete node;
   }
+  ats_free(index);
 }
 
-void inline SSLSessionBucket::removeOldestSession()
+void
+SSLSessionList::insert(SSLSession *ssl_session)
 {
-  // Caller must hold the bucket lock.
-  ink_assert(this_ethread() == mutex->thread_holding);
+  // A session id is only ever cached once, replace any stale entry.
+  SSLSession *old = find(ssl_session->session_id);
+  if (old) {
+    remove(old);
+    delete old;
+  }
 
-  PRINT_BUCKET("removeOldestSession before")
-  while (queue.head && queue.size >= static_cast<int>(SSLConfigParams::session_cache_max_bucket_size)) {
-    SSLSession *old_head = queue.pop();
+  while (queue.head && queue.size >= static_cast<int>(capacity)) {
+    SSLSession *old_head = queue.head;
     if (is_debug_tag_set("ssl.session_cache")) {
       char buf[old_head->session_id.len * 2 + 1];
       old_head->session_id.toString(buf, sizeof(buf));
-      Debug("ssl.session_cache", "Removing session '%s' from bucket %p because the bucket has size %d and max %zd", buf, this,
-            (queue.size + 1), SSLConfigParams::session_cache_max_bucket_size);
+      Debug("ssl.session_cache", "Removing session '%s' from list %p because the list has size %d and max %zd", buf, this,
+            queue.size, capacity);
     }
+    remove(old_head);
     delete old_head;
   }
-  PRINT_BUCKET("removeOldestSession after")
+
+  size_t i = indexSlot(ssl_session->session_id);
+  while (index[i]) {
+    i = (i + 1) & index_mask;
+  }
+  index[i] = ssl_session;
+  queue.enqueue(ssl_session);
 }
 
 void
-SSLSessionBucket::removeSession(const SSLSessionID &id)
+SSLSessionList::remove(SSLSession *node)
 {
-  SCOPED_MUTEX_LOCK(lock, mutex, this_ethread()); // We can't bail on contention here because this session MUST be removed.
+  indexRemove(node);
+  queue.remove(node);
+}
+
+void
+SSLSessionList::print(const char *ref_str) const
+{
+  if (!is_debug_tag_set("ssl.session_cache.bucket")) {
+    return;
+  }
+
+  fprintf(stderr, "-------------- LIST %p (%s) ----------------\n", this, ref_str);
+  fprintf(stderr, "Current Size: %d, Max Size: %zd\n", queue.size, capacity);
+  fprintf(stderr, "Queue: \n");
+
   SSLSession *node = queue.head;
   while (node) {
-    if (node->session_id == id) {
-      queue.remove(node);
-      delete node;
-      return;
-    }
+    char s_buf[2 * node->session_id.len + 1];
+    node->session_id.toString(s_buf, sizeof(s_buf));
+    fprintf(stderr, "  %s\n", s_buf);
     node = node->link.next;
   }
 }
 
-/* Session Bucket */
-SSLSessionBucket::SSLSessionBucket() : mutex(new_ProxyMutex())
+inline size_t
+SSLSessionList::indexSlot(const SSLSessionID &id) const
 {
+  // All the ids in a bucket share the same hash modulo the bucket count, so mix the
+  // hash and take the high bits rather than using the low bits directly.
+  return static_cast<size_t>((id.hash() * 0x9E3779B97F4A7C15ULL) >> index_shift);
 }
 
-SSLSessionBucket::~SSLSessionBucket()
+SSLSession *
+SSLSessionList::find(const SSLSessionID &id)
 {
+  size_t probes = 1;
+  SSLSession *node;
+
+  for (size_t i = indexSlot(id); (node = index[i]) != nullptr; i = (i + 1) & index_mask, ++probes) {
+    if (node->session_id == id) {
+      break;
+    }
+  }
+
+  SSL_INCREMENT_DYN_STAT(ssl_session_cache_index_lookup);
+  SSL_INCREMENT_DYN_STAT_EX(ssl_session_cache_index_probe, probes);
+  return node;
+}
+
+void
+SSLSessionList::indexRemove(SSLSession *node)
+{
+  size_t i = indexSlot(node->session_id);
+
+  while (index[i] != node) {
+    ink_assert(index[i] != nullptr);
+    i = (i + 1) & index_mask;
+  }
+
+  // Backward shift deletion, so lookups never need tombstones.
+  for (size_t j = (i + 1) & index_mask; index[j]; j = (j + 1) & index_mask) {
+    size_t home = indexSlot(index[j]->session_id);
+    if (((j - home) & index_mask) >= ((j - i) & index_mask)) {
+      index[i] = index[j];
+      i        = j;
+    }
+  }
+  index[i] = nullptr;
 }
@@ -32,6 +32,7 @@
 #include "P_SSLUtils.h"
 #include "ts/RbTree.h"
 #include <openssl/ssl.h>
+#include <atomic>
 
 #define SSL_MAX_SESSION_SIZE 256
 
@@ -118,31 +119,80 @@ public:
   SSLSessionID session_id;
   Ptr<IOBufferData> asn1_data; /* this is the ASN1 representation of the SSL_CTX */
   size_t len_asn1_data;
+  SSL_SESSION *session; /* optional parsed copy, owns one reference */
+  uint64_t generation;  /* generation of its bucket slot a shard copy was promoted at */
 
-  SSLSession(const SSLSessionID &id, Ptr<IOBufferData> ssl_asn1_data, size_t len_asn1)
-    : session_id(id), asn1_data(ssl_asn1_data), len_asn1_data(len_asn1)
+  SSLSession(const SSLSessionID &id, Ptr<IOBufferData> ssl_asn1_data, size_t len_asn1, SSL_SESSION *sess = nullptr)
+    : session_id(id), asn1_data(ssl_asn1_data), len_asn1_data(len_asn1), session(sess), generation(0)
   {
   }
 
+  ~SSLSession()
+  {
+    if (session) {
+      SSL_SESSION_free(session);
+    }
+  }
+
   LINK(SSLSession, link);
 };
 
+/* An unlocked LRU list of sessions with a hash index, the caller provides any locking. */
+class SSLSessionList
+{
+public:
+  explicit SSLSessionList(size_t capacity);
+  ~SSLSessionList();
+  SSLSession *find(const SSLSessionID &);
+  void insert(SSLSession *);
+  void remove(SSLSession *);
+  void print(const char *) const;
+
+private:
+  size_t indexSlot(const SSLSessionID &) const;
+  void indexRemove(SSLSession *);
+
+  size_t capacity;
+  CountQueue<SSLSession> queue;
+
+  // Open addressed (linear probing) index over the sessions in queue. The queue
+  // keeps the eviction order, the index makes lookups and removals O(1).
+  SSLSession **index;
+  size_t index_mask;
+  unsigned index_shift;
+};
+
 class SSLSessionBucket
 {
 public:
   SSLSessionBucket();
   ~SSLSessionBucket();
   void insertSession(const SSLSessionID &, SSL_SESSION *ctx);
-  bool getSession(const SSLSessionID &, SSL_SESSION **ctx);
+  bool getSession(const SSLSessionID &, SSL_SESSION **ctx, SSLSession **promote = nullptr);
   void removeSession(const SSLSessionID &);
 
+  /// Bumped whenever a session hashing to the same slot as @a id is removed or replaced, a
+  /// shard copy of @a id promoted at an older generation may be stale. The slots keep a removal
+  /// from invalidating the shard copies of every other session in the bucket.
+  uint64_t
+  generation(const SSLSessionID &id) const
+  {
+    return _generation[generationSlot(id)].load(std::memory_order_acquire);
+  }
+
 private:
-  /* these method must be used while hold the lock */
-  void print(const char *) const;
-  void removeOldestSession();
+  static const unsigned GENERATION_SLOT_BITS = 5;
+
+  static size_t
+  generationSlot(const SSLSessionID &id)
+  {
+    // All the ids in a bucket share the same hash modulo the bucket count, so mix the hash first.
+    return static_cast<size_t>((id.hash() * 0x9E3779B97F4A7C15ULL) >> (64 - GENERATION_SLOT_BITS));
+  }
 
   Ptr<ProxyMutex> mutex;
-  CountQueue<SSLSession> queue;
+  SSLSessionList sessions;
+  std::atomic<uint64_t> _generation[1 << GENERATION_SLOT_BITS];
 };
 
 class SSLSessionCache
@@ -155,8 +205,16 @@ public:
   ~SSLSessionCache();
 
 private:
+  SSLSessionList *getShard() const;
+
   SSLSessionBucket *session_bucket;
   size_t nbuckets;
+
+  // Per ET_NET thread first tier, indexed by EThread::id (which is only unique within a
+  // thread group) and only ever touched by the owning thread. Empty if
+  // proxy.config.ssl.session_cache.per_thread_size is 0.
+  SSLSessionList **shards;
+  size_t shard_size;
 };
 
 #endif /* __SSLSESSIONCACHE_H__ */
@@ -23,6 +23,10 @@
 
 #include "P_Net.h"
 
+#if defined(linux)
+#include <linux/filter.h>
+#endif
+
 #ifdef ROUNDUP
 #undef ROUNDUP
 #endif
@@ -39,6 +43,34 @@ safe_delay(int msec)
   socketManager.poll(nullptr, 0, msec);
 }
 
+//
+// Have the kernel hand a connection to the listen socket of the thread whose index
+// matches the CPU the connection came in on. The shared socket was the first to
+// listen but belongs to the last thread, so the socket index is (cpu + 1) % n.
+//
+static void
+steer_accepts_by_cpu(int fd, int n)
+{
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+  struct sock_filter code[] = {
+    {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(n)},
+    {BPF_ALU | BPF_ADD | BPF_K, 0, 0, 1},
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(n)},
+    {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog = {static_cast<unsigned short>(countof(code)), code};
+
+  if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0) {
+    Warning("unable to steer accepts by CPU: %d, %s", errno, strerror(errno));
+  }
+#else
+  (void)fd;
+  (void)n;
+  Warning("steering accepts by CPU is not supported on this platform");
+#endif
+}
+
 //
 // General case network connection accept code
 //
@@ -187,6 +219,17 @@ NetAccept::init_accept_per_thread()
 
     if (i < n - 1) {
       a = clone();
+      if (listen_per_thread) {
+        a->server.fd = NO_FD;
+        if (a->server.listen(NON_BLOCKING, opt)) {
+          // Most likely the port was bound without SO_REUSEPORT or by another user, share it instead.
+          Warning("unable to open a listen socket per thread on port %d, sharing one: %d, %s", ntohs(server.accept_addr.port()),
+                  errno, strerror(errno));
+          a->server.fd         = server.fd;
+          a->listen_per_thread = 0;
+          listen_per_thread    = 0;
+        }
+      }
     } else {
       a = this;
     }
@@ -201,6 +244,10 @@ NetAccept::init_accept_per_thread()
     a->mutex = get_NetHandler(t)->mutex;
     t->schedule_every(a, period, opt.etype);
   }
+
+  if (listen_per_thread > 1 && n > 1) {
+    steer_accepts_by_cpu(server.fd, n);
+  }
 }
 
 int
@@ -329,6 +376,10 @@ NetAccept::acceptEvent(int event, void *ep)
   MUTEX_TRY_LOCK(lock, m, e->ethread);
   if (lock.is_locked()) {
     if (action_->cancelled) {
+      // The action only closes the socket of the first accept.
+      if (listen_per_thread) {
+        server.close();
+      }
       e->cancel();
       NET_DECREMENT_DYN_STAT(net_accepts_currently_open_stat);
       delete this;
@@ -367,6 +418,11 @@ NetAccept::acceptFastEvent(int event, void *ep)
   UnixNetVConnection *vc = nullptr;
   int loop               = accept_till_done;
 
+  // The action only closes the socket of the first accept.
+  if (listen_per_thread && action_->cancelled) {
+    goto Lerror;
+  }
+
   do {
     if (!opt.backdoor && check_net_throttle(ACCEPT, Thread::get_hrtime())) {
       ifd = NO_FD;
@@ -131,6 +131,12 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
     na->server.http_accept_filter = true;
   }
 
+  // Accepting on the event threads, they may each get their own listen socket.
+  if (opt.frequent_accept && accept_threads <= 0) {
+    REC_ReadConfigInteger(na->listen_per_thread, "proxy.config.exec_thread.listen");
+    na->server.reuseport = na->listen_per_thread > 0;
+  }
+
   SessionAccept *sa = dynamic_cast<SessionAccept *>(cont);
   na->proxyPort     = sa ? sa->proxyPort : nullptr;
   na->snpa          = dynamic_cast<SSLNextProtocolAccept *>(cont);
@@ -174,25 +180,6 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
     na->init_accept(nullptr);
   }
   naVec.push_back(na);
-#ifdef TCP_DEFER_ACCEPT
-  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
-  // data on the socket ready to be read
-  if (should_filter_int > 0) {
-    setsockopt(na->server.fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
-  }
-#endif
-
-#ifdef TCP_INIT_CWND
-  int tcp_init_cwnd = 0;
-  REC_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
-  if (tcp_init_cwnd > 0) {
-    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
-    if (setsockopt(na->server.fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
-      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
-    }
-  }
-#endif
-
   return na->action_.get();
 }
 
@@ -333,6 +333,7 @@ read_from_net(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
       return;
     }
     NET_SUM_DYN_STAT(net_read_bytes_stat, r);
+    NET_NUMA_SUM_DYN_STAT(thread, net_numa_read_bytes_stat, r);
 
     // Add data to buffer and signal continuation.
     buf.writer()->fill(r);
@@ -495,6 +496,7 @@ write_to_net_io(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
 
   if (total_written > 0) {
     NET_SUM_DYN_STAT(net_write_bytes_stat, total_written);
+    NET_NUMA_SUM_DYN_STAT(thread, net_numa_write_bytes_stat, total_written);
     s->vio.ndone += total_written;
     net_activity(vc, thread);
   }
@@ -1136,6 +1138,8 @@ UnixNetVConnection::acceptEvent(int event, Event *e)
     return EVENT_DONE;
   }
 
+  NET_NUMA_SUM_DYN_STAT(t, net_numa_accepts_stat, 1);
+
   // Setup a timeout callback handler.
   SET_HANDLER((NetVConnHandler)&UnixNetVConnection::mainEvent);
 
@@ -20,12 +20,14 @@
  */
 
 #include "ConsistentHash.h"
+#include "ts/ink_assert.h"
 #include <cstring>
 #include <string>
 #include <sstream>
 #include <cmath>
 #include <climits>
 #include <cstdio>
+#include <algorithm>
 
 std::ostream &
 operator<<(std::ostream &os, ATSConsistentHashNode &thing)
@@ -33,7 +35,7 @@ operator<<(std::ostream &os, ATSConsistentHashNode &thing)
   return os << thing.name;
 }
 
-ATSConsistentHash::ATSConsistentHash(int r, ATSHash64 *h) : replicas(r), hash(h)
+ATSConsistentHash::ATSConsistentHash(int r, ATSHash64 *h) : hash(h), replicas(r)
 {
 }
 
@@ -62,11 +64,78 @@ ATSConsistentHash::insert(ATSConsistentHashNode *node, float weight, ATSHash64 *
     thash->update(numstr, strlen(numstr));
     thash->update(std_string.c_str(), strlen(std_string.c_str()));
     thash->final();
-    NodeMap.insert(std::pair<uint64_t, ATSConsistentHashNode *>(thash->get(), node));
+    pending.emplace_back(thash->get(), node);
     thash->clear();
   }
 }
 
+// Sort the points queued by insert() into the ring. Doing this once for all the nodes
+// keeps loading a large ring O(n log n), merging on every insert made it quadratic.
+void
+ATSConsistentHash::build()
+{
+  if (pending.empty()) {
+    return;
+  }
+
+  std::stable_sort(pending.begin(), pending.end(),
+                   [](const std::pair<uint64_t, ATSConsistentHashNode *> &a, const std::pair<uint64_t, ATSConsistentHashNode *> &b) {
+                     return a.first < b.first;
+                   });
+
+  // Merge the new points into the ring. As with a map insert, a hash value that is
+  // already on the ring keeps the node it was first inserted with.
+  std::vector<uint64_t> merged_hash;
+  std::vector<ATSConsistentHashNode *> merged_node;
+  size_t r = 0, p = 0;
+
+  merged_hash.reserve(ring_hash.size() + pending.size());
+  merged_node.reserve(ring_hash.size() + pending.size());
+
+  while (r < ring_hash.size() || p < pending.size()) {
+    if (p == pending.size() || (r < ring_hash.size() && ring_hash[r] <= pending[p].first)) {
+      merged_hash.push_back(ring_hash[r]);
+      merged_node.push_back(ring_node[r]);
+      ++r;
+    } else {
+      merged_hash.push_back(pending[p].first);
+      merged_node.push_back(pending[p].second);
+      ++p;
+    }
+    // Skip new points that duplicate the value just added.
+    while (p < pending.size() && merged_hash.back() == pending[p].first) {
+      ++p;
+    }
+  }
+
+  ring_hash.swap(merged_hash);
+  ring_node.swap(merged_node);
+  pending.clear();
+  pending.shrink_to_fit();
+}
+
+// Index of the first ring entry not less than @a hashval, or the ring size if there is
+// none. The search is branchless so the loop compiles to conditional moves and its
+// trip count only depends on the ring size.
+size_t
+ATSConsistentHash::lower_bound(uint64_t hashval) const
+{
+  size_t n = ring_hash.size();
+
+  if (n == 0) {
+    return 0;
+  }
+
+  const uint64_t *base = ring_hash.data();
+  while (n > 1) {
+    size_t half = n / 2;
+    base        = (base[half - 1] < hashval) ? base + half : base;
+    n -= half;
+  }
+
+  return (base - ring_hash.data()) + (*base < hashval);
+}
+
 ATSConsistentHashNode *
 ATSConsistentHash::lookup(const char *url, ATSConsistentHashIter *i, bool *w, ATSHash64 *h)
 {
@@ -101,26 +170,26 @@ ATSConsistentHash::lookup(const char *url, ATSConsistentHashIter *i, bool *w, AT
     url_hash = thash->get();
     thash->clear();
 
-    *iter = NodeMap.lower_bound(url_hash);
+    *iter = lower_bound(url_hash);
 
-    if (*iter == NodeMap.end()) {
+    if (*iter == ring_hash.size()) {
       *wptr = true;
-      *iter = NodeMap.begin();
+      *iter = 0;
     }
   } else {
     (*iter)++;
   }
 
-  if (!(*wptr) && *iter == NodeMap.end()) {
+  if (!(*wptr) && *iter >= ring_hash.size()) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    *iter = 0;
   }
 
-  if (*wptr && *iter == NodeMap.end()) {
+  if (*wptr && *iter >= ring_hash.size()) {
     return nullptr;
   }
 
-  return (*iter)->second;
+  return ring_node[*iter];
 }
 
 ATSConsistentHashNode *
@@ -151,32 +220,36 @@ ATSConsistentHash::lookup_available(const char *url, ATSConsistentHashIter *i, b
     iter = &NodeMapIterUp;
   }
 
+  if (ring_hash.empty()) {
+    return nullptr;
+  }
+
   if (url) {
     thash->update(url, strlen(url));
     thash->final();
     url_hash = thash->get();
     thash->clear();
 
-    *iter = NodeMap.lower_bound(url_hash);
+    *iter = lower_bound(url_hash);
   }
 
-  if (*iter == NodeMap.end()) {
+  if (*iter >= ring_hash.size()) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    *iter = 0;
   }
 
-  while (!(*iter)->second->available) {
+  while (!ring_node[*iter]->available) {
     (*iter)++;
 
-    if (!(*wptr) && *iter == NodeMap.end()) {
+    if (!(*wptr) && *iter == ring_hash.size()) {
       *wptr = true;
-      *iter = NodeMap.begin();
-    } else if (*wptr && *iter == NodeMap.end()) {
+      *iter = 0;
+    } else if (*wptr && *iter == ring_hash.size()) {
       return nullptr;
     }
   }
 
-  return (*iter)->second;
+  return ring_node[*iter];
 }
 
 ATSConsistentHashNode *
@@ -197,14 +270,18 @@ ATSConsistentHash::lookup_by_hashval(uint64_t hashval, ATSConsistentHashIter *i,
     iter = &NodeMapIterUp;
   }
 
-  *iter = NodeMap.lower_bound(hashval);
+  if (ring_hash.empty()) {
+    return nullptr;
+  }
+
+  *iter = lower_bound(hashval);
 
-  if (*iter == NodeMap.end()) {
+  if (*iter == ring_hash.size()) {
     *wptr = true;
-    *iter = NodeMap.begin();
+    *iter = 0;
   }
 
-  return (*iter)->second;
+  return ring_node[*iter];
 }
 
 ATSConsistentHash::~ATSConsistentHash()
@@ -213,3 +290,198 @@ ATSConsistentHash::~ATSConsistentHash()
     delete hash;
   }
 }
+
+/* Maglev */
+
+ATSMaglevHash::ATSMaglevHash(ATSHash64 *h, size_t size) : ATSConsistentHash(1, h), table_slots(size)
+{
+  ink_release_assert(table_slots > 1);
+}
+
+void
+ATSMaglevHash::insert(ATSConsistentHashNode *node, float weight, ATSHash64 *h)
+{
+  ATSHash64 *thash;
+  std::ostringstream string_stream;
+  std::string std_string;
+
+  if (h) {
+    thash = h;
+  } else if (hash) {
+    thash = hash;
+  } else {
+    return;
+  }
+
+  // The table stores node indices in 16 bits, and every node needs at least one slot.
+  ink_release_assert(entries.size() < UINT16_MAX && entries.size() < table_slots);
+
+  string_stream << *node;
+  std_string = string_stream.str();
+
+  thash->update(std_string.c_str(), std_string.size());
+  thash->final();
+  entries.push_back(Entry{node, weight, thash->get()});
+  thash->clear();
+
+  table.clear();
+}
+
+void
+ATSMaglevHash::build()
+{
+  size_t n_entries = entries.size();
+  float max_weight = 0;
+
+  table.clear();
+  if (n_entries == 0) {
+    return;
+  }
+
+  for (auto const &e : entries) {
+    max_weight = std::max(max_weight, e.weight);
+  }
+
+  // The size doesn't depend on the nodes, a different size would move almost every key.
+  size_t size = table_slots;
+
+  std::vector<uint64_t> offset(n_entries), skip(n_entries), next(n_entries, 0);
+  std::vector<float> credit(n_entries, 0);
+  std::vector<bool> taken(size, false);
+
+  for (size_t i = 0; i < n_entries; ++i) {
+    offset[i] = (entries[i].hashval >> 32) % size;
+    skip[i]   = (entries[i].hashval & 0xffffffff) % (size - 1) + 1;
+  }
+
+  table.resize(size);
+  size_t filled = 0;
+  while (filled < size) {
+    for (size_t i = 0; i < n_entries && filled < size; ++i) {
+      // Nodes take a turn in proportion to their weight, every node takes a turn if
+      // none of them has a positive weight.
+      credit[i] += max_weight > 0 ? std::max(entries[i].weight, 0.0f) / max_weight : 1;
+      if (credit[i] < 1) {
+        continue;
+      }
+      credit[i] -= 1;
+
+      uint64_t slot;
+      do {
+        slot = (offset[i] + next[i] * skip[i]) % size;
+        ++next[i];
+      } while (taken[slot]);
+
+      taken[slot] = true;
+      table[slot] = i;
+      ++filled;
+    }
+  }
+}
+
+ATSConsistentHashNode *
+ATSMaglevHash::lookup(const char *url, ATSConsistentHashIter *i, bool *w, ATSHash64 *h)
+{
+  ATSConsistentHashIter TableIter, *iter;
+  ATSHash64 *thash;
+  bool *wptr, wrapped = false;
+
+  if (h) {
+    thash = h;
+  } else if (hash) {
+    thash = hash;
+  } else {
+    return nullptr;
+  }
+
+  wptr = w ? w : &wrapped;
+  iter = i ? i : &TableIter;
+
+  if (table.empty()) {
+    return nullptr;
+  }
+
+  if (url) {
+    thash->update(url, strlen(url));
+    thash->final();
+    *iter = thash->get() % table.size();
+    thash->clear();
+  } else {
+    (*iter)++;
+  }
+
+  if (!(*wptr) && *iter >= table.size()) {
+    *wptr = true;
+    *iter = 0;
+  }
+
+  if (*wptr && *iter >= table.size()) {
+    return nullptr;
+  }
+
+  return entries[table[*iter]].node;
+}
+
+ATSConsistentHashNode *
+ATSMaglevHash::lookup_available(const char *url, ATSConsistentHashIter *i, bool *w, ATSHash64 *h)
+{
+  ATSConsistentHashIter TableIter, *iter;
+  ATSHash64 *thash;
+  bool *wptr, wrapped = false;
+
+  if (h) {
+    thash = h;
+  } else if (hash) {
+    thash = hash;
+  } else {
+    return nullptr;
+  }
+
+  wptr = w ? w : &wrapped;
+  iter = i ? i : &TableIter;
+
+  if (table.empty()) {
+    return nullptr;
+  }
+
+  if (url) {
+    thash->update(url, strlen(url));
+    thash->final();
+    *iter = thash->get() % table.size();
+    thash->clear();
+  }
+
+  if (*iter >= table.size()) {
+    *wptr = true;
+    *iter = 0;
+  }
+
+  while (!entries[table[*iter]].node->available) {
+    (*iter)++;
+
+    if (!(*wptr) && *iter == table.size()) {
+      *wptr = true;
+      *iter = 0;
+    } else if (*wptr && *iter == table.size()) {
+      return nullptr;
+    }
+  }
+
+  return entries[table[*iter]].node;
+}
+
+ATSConsistentHashNode *
+ATSMaglevHash::lookup_by_hashval(uint64_t hashval, ATSConsistentHashIter *i, bool * /* w ATS_UNUSED */)
+{
+  ATSConsistentHashIter TableIter, *iter;
+
+  iter = i ? i : &TableIter;
+
+  if (table.empty()) {
+    return nullptr;
+  }
+
+  *iter = hashval % table.size();
+
+  return entries[table[*iter]].node;
+}
@@ -25,7 +25,8 @@
 #include "Hash.h"
 #include <stdint.h>
 #include <iostream>
-#include <map>
+#include <utility>
+#include <vector>
 
 /*
   Helper class to be extended to make ring nodes.
@@ -38,27 +39,90 @@ struct ATSConsistentHashNode {
 
 std::ostream &operator<<(std::ostream &os, ATSConsistentHashNode &thing);
 
-typedef std::map<uint64_t, ATSConsistentHashNode *>::iterator ATSConsistentHashIter;
+// Position on the ring, an index into the sorted ring arrays.
+typedef size_t ATSConsistentHashIter;
 
 /*
   TSConsistentHash requires a TSHash64 object
 
   Caller is responsible for freeing ring node memory.
+
+  The ring is stored flat, as a sorted array of hash values and a parallel array of
+  nodes, so a lookup is a binary search over contiguous memory. All the inserts happen
+  when the configuration is loaded, after that the ring is only read.
+
+  insert() only queues the node's points, build() must be called after the last insert
+  to sort them into the ring.
  */
 
 struct ATSConsistentHash {
   ATSConsistentHash(int r = 1024, ATSHash64 *h = nullptr);
-  void insert(ATSConsistentHashNode *node, float weight = 1.0, ATSHash64 *h = nullptr);
-  ATSConsistentHashNode *lookup(const char *url = nullptr, ATSConsistentHashIter *i = NULL, bool *w = NULL, ATSHash64 *h = NULL);
-  ATSConsistentHashNode *lookup_available(const char *url = nullptr, ATSConsistentHashIter *i = NULL, bool *w = NULL,
-                                          ATSHash64 *h = nullptr);
-  ATSConsistentHashNode *lookup_by_hashval(uint64_t hashval, ATSConsistentHashIter *i = nullptr, bool *w = NULL);
-  ~ATSConsistentHash();
+  virtual void insert(ATSConsistentHashNode *node, float weight = 1.0, ATSHash64 *h = nullptr);
+  virtual ATSConsistentHashNode *lookup(const char *url = nullptr, ATSConsistentHashIter *i = NULL, bool *w = NULL,
+                                        ATSHash64 *h = NULL);
+  virtual ATSConsistentHashNode *lookup_available(const char *url = nullptr, ATSConsistentHashIter *i = NULL, bool *w = NULL,
+                                                  ATSHash64 *h = nullptr);
+  virtual ATSConsistentHashNode *lookup_by_hashval(uint64_t hashval, ATSConsistentHashIter *i = nullptr, bool *w = NULL);
+  // Called once all the nodes are inserted, before the first lookup.
+  virtual void build();
+  virtual ~ATSConsistentHash();
+
+protected:
+  ATSHash64 *hash;
 
 private:
+  size_t lower_bound(uint64_t hashval) const;
+
   int replicas;
-  ATSHash64 *hash;
-  std::map<uint64_t, ATSConsistentHashNode *> NodeMap;
+  std::vector<uint64_t> ring_hash;
+  std::vector<ATSConsistentHashNode *> ring_node;
+  std::vector<std::pair<uint64_t, ATSConsistentHashNode *>> pending; // inserted, not yet in the ring
 };
 
+/*
+  Maglev hashing (Eisenbud et al., NSDI 2016) with the same interface as the ring.
+
+  Every node gets a pseudo random permutation of the slots of a prime sized lookup
+  table, and the nodes take turns claiming their next free preferred slot, as often
+  as their weight allows, until the table is full. A lookup is then a single table
+  index, and adding or removing a node only moves a small fraction of the slots.
+  Walking the table from a slot gives the fallback order for that key.
+
+  The table size is fixed when the hash is created, and must be prime so that every
+  node's permutation visits every slot. It must not change with the set of nodes, or
+  almost every key would move. The default gives a few hundred nodes about a hundred
+  slots each, which keeps the split between them even.
+
+  build() must be called after the last insert.
+ */
+
+#define MAGLEV_DEFAULT_TABLE_SIZE 65521
+
+struct ATSMaglevHash : public ATSConsistentHash {
+  ATSMaglevHash(ATSHash64 *h = nullptr, size_t size = MAGLEV_DEFAULT_TABLE_SIZE);
+  void insert(ATSConsistentHashNode *node, float weight = 1.0, ATSHash64 *h = nullptr) override;
+  ATSConsistentHashNode *lookup(const char *url = nullptr, ATSConsistentHashIter *i = NULL, bool *w = NULL,
+                                ATSHash64 *h = NULL) override;
+  ATSConsistentHashNode *lookup_available(const char *url = nullptr, ATSConsistentHashIter *i = NULL, bool *w = NULL,
+                                          ATSHash64 *h = nullptr) override;
+  ATSConsistentHashNode *lookup_by_hashval(uint64_t hashval, ATSConsistentHashIter *i = nullptr, bool *w = NULL) override;
+  void build() override;
+
+  size_t
+  table_size() const
+  {
+    return table.size();
+  }
+
+private:
+  struct Entry {
+    ATSConsistentHashNode *node;
+    float weight;
+    uint64_t hashval; // seeds the node's slot permutation
+  };
+
+  size_t table_slots;
+  std::vector<Entry> entries;
+  std::vector<uint16_t> table; // index into entries, for each slot
+};
 #endif
@@ -139,7 +139,7 @@ int EventNotify::timedwait(int timeout) // milliseconds
 #else
   ink_timestruc abstime;
 
-  abstime = ink_hrtime_to_timespec(ink_get_hrtime_internal() + HRTIME_SECONDS(timeout));
+  abstime = ink_hrtime_to_timespec(ink_get_hrtime_internal() + HRTIME_MSECONDS(timeout));
   return ink_cond_timedwait(&m_cond, &m_mutex, &abstime);
 #endif
 }
@@ -0,0 +1,352 @@
+/** @file
+
+  Literal prefilter for large sets of regular expressions.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "ts/RegexPrefilter.h"
+#include "ts/ink_assert.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+
+// Skip a character class starting at p[i] == '['. Returns the index after the closing ']'
+// or -1 if there is none.
+static int
+skip_class(const char *p, int i)
+{
+  ++i;
+  if (p[i] == '^') {
+    ++i;
+  }
+  if (p[i] == ']') { // a leading ']' is a literal
+    ++i;
+  }
+  for (; p[i]; ++i) {
+    if (p[i] == '\\' && p[i + 1]) {
+      ++i;
+    } else if (p[i] == '[' && p[i + 1] == ':') { // POSIX class, e.g. [:alpha:]
+      const char *end = strstr(p + i + 2, ":]");
+      if (!end) {
+        return -1;
+      }
+      i = end - p + 1;
+    } else if (p[i] == ']') {
+      return i + 1;
+    }
+  }
+  return -1;
+}
+
+// Skip a group starting at p[i] == '('. Returns the index after the closing ')' or -1.
+static int
+skip_group(const char *p, int i)
+{
+  int depth = 0;
+
+  while (p[i]) {
+    if (p[i] == '\\' && p[i + 1]) {
+      i += 2;
+    } else if (p[i] == '[') {
+      if ((i = skip_class(p, i)) < 0) {
+        return -1;
+      }
+    } else {
+      if (p[i] == '(') {
+        ++depth;
+      } else if (p[i] == ')' && --depth == 0) {
+        return i + 1;
+      }
+      ++i;
+    }
+  }
+  return -1;
+}
+
+std::string
+RegexPrefilter::required_literal(const char *p)
+{
+  std::string best, run;
+  int i = 0;
+
+  // Inline options can change case sensitivity or the meaning of the pattern, don't try.
+  if (strstr(p, "(?") || strstr(p, "(*")) {
+    return best;
+  }
+
+  auto end_run = [&]() {
+    if (run.size() > best.size()) {
+      best = run;
+    }
+    run.clear();
+  };
+
+  while (p[i]) {
+    char c = p[i];
+
+    switch (c) {
+    case '\\':
+      if (!p[i + 1]) {
+        return std::string();
+      }
+      if (isalnum(static_cast<unsigned char>(p[i + 1]))) {
+        // Character types, assertions and control characters are a single character
+        // that ends the literal. Anything else (\x41, \Q, back references, ...) can span
+        // more than one character, so give up.
+        if (!strchr("dDwWsSbBAzZGhHvVRXKnrtfea", p[i + 1])) {
+          return std::string();
+        }
+        end_run();
+      } else {
+        run += p[i + 1];
+      }
+      i += 2;
+      continue;
+    case '(':
+      end_run();
+      if ((i = skip_group(p, i)) < 0) {
+        return std::string();
+      }
+      continue;
+    case '[':
+      end_run();
+      if ((i = skip_class(p, i)) < 0) {
+        return std::string();
+      }
+      continue;
+    case '|':
+    case ')':
+      // A top level alternation means no single literal is required.
+      return std::string();
+    case '*':
+    case '?':
+    case '{':
+      // The previous character might not be there at all.
+      if (!run.empty()) {
+        run.erase(run.size() - 1);
+      }
+      end_run();
+      if (c == '{') {
+        const char *close = strchr(p + i, '}');
+        if (!close) {
+          return std::string();
+        }
+        i = close - p;
+      }
+      ++i;
+      continue;
+    case '+':
+      end_run();
+      ++i;
+      continue;
+    case '.':
+    case '^':
+    case '$':
+      end_run();
+      ++i;
+      continue;
+    default:
+      run += c;
+      ++i;
+      continue;
+    }
+  }
+
+  // A quantifier following a run is handled above, so the final run is complete.
+  end_run();
+
+  for (auto &ch : best) {
+    ch = tolower(static_cast<unsigned char>(ch));
+  }
+  return best;
+}
+
+void
+RegexPrefilter::add(const char *pattern, int id)
+{
+  ink_assert(nodes.empty()); // not built yet
+  ink_assert(literal_ids.empty() || literal_ids.back() < id);
+  ink_assert(unfiltered.empty() || unfiltered.back() < id);
+
+  std::string literal = required_literal(pattern);
+
+  if (literal.size() < MIN_LITERAL_LENGTH) {
+    unfiltered.push_back(id);
+  } else {
+    literal_ids.push_back(id);
+    literals.push_back(literal);
+  }
+}
+
+void
+RegexPrefilter::add_literal(const char *literal, int id)
+{
+  ink_assert(nodes.empty()); // not built yet
+  ink_assert(literal_ids.empty() || literal_ids.back() < id);
+  ink_assert(unfiltered.empty() || unfiltered.back() < id);
+
+  if (!*literal) {
+    unfiltered.push_back(id); // the empty string is in every string
+  } else {
+    literal_ids.push_back(id);
+    literals.emplace_back(literal);
+    for (auto &ch : literals.back()) {
+      ch = tolower(static_cast<unsigned char>(ch));
+    }
+  }
+}
+
+void
+RegexPrefilter::build()
+{
+  std::vector<std::map<unsigned char, int32_t>> trie(1);
+  std::vector<int32_t> output(1, -1);
+
+  literal_next.assign(literals.size(), -1);
+
+  for (size_t li = 0; li < literals.size(); ++li) {
+    int32_t state = 0;
+    for (unsigned char c : literals[li]) {
+      auto spot = trie[state].find(c);
+      if (spot == trie[state].end()) {
+        trie[state][c] = trie.size();
+        state          = trie.size();
+        trie.emplace_back();
+        output.push_back(-1);
+      } else {
+        state = spot->second;
+      }
+    }
+    literal_next[li] = output[state];
+    output[state]    = li;
+  }
+  literals.clear();
+
+  // Breadth first, so the fail links of the shorter prefixes are set first.
+  nodes.resize(trie.size());
+  nodes[0].fail   = 0;
+  nodes[0].dict   = -1;
+  nodes[0].output = output[0];
+
+  std::vector<int32_t> queue;
+  queue.reserve(trie.size());
+  queue.push_back(0);
+
+  for (size_t q = 0; q < queue.size(); ++q) {
+    int32_t u = queue[q];
+
+    for (auto const &edge : trie[u]) {
+      int32_t v = edge.second;
+      int32_t f = nodes[u].fail;
+
+      if (u == 0) {
+        f = 0;
+      } else {
+        while (f != 0 && trie[f].find(edge.first) == trie[f].end()) {
+          f = nodes[f].fail;
+        }
+        auto spot = trie[f].find(edge.first);
+        f         = (spot != trie[f].end()) ? spot->second : 0;
+      }
+
+      nodes[v].fail   = f;
+      nodes[v].output = output[v];
+      nodes[v].dict   = (output[f] >= 0) ? f : nodes[f].dict;
+      queue.push_back(v);
+    }
+  }
+
+  // Flatten the transitions, they are already sorted by character.
+  for (size_t s = 0; s < trie.size(); ++s) {
+    nodes[s].edge_begin = edge_char.size();
+    for (auto const &edge : trie[s]) {
+      edge_char.push_back(edge.first);
+      edge_target.push_back(edge.second);
+    }
+    nodes[s].edge_end = edge_char.size();
+  }
+
+  for (int c = 0; c < 256; ++c) {
+    auto spot    = trie[0].find(c);
+    root_next[c] = (spot != trie[0].end()) ? spot->second : 0;
+  }
+}
+
+int
+RegexPrefilter::step(int state, unsigned char c) const
+{
+  while (state != 0) {
+    const Node &node         = nodes[state];
+    const unsigned char *beg = edge_char.data() + node.edge_begin;
+    const unsigned char *end = edge_char.data() + node.edge_end;
+    const unsigned char *hit = std::lower_bound(beg, end, c);
+
+    if (hit != end && *hit == c) {
+      return edge_target[hit - edge_char.data()];
+    }
+    state = node.fail;
+  }
+  return root_next[c];
+}
+
+int
+RegexPrefilter::candidates(const char *str, int length, int *ids, int max_ids) const
+{
+  int n = 0;
+
+  ink_assert(!nodes.empty());
+
+  auto add = [&](int id) -> bool {
+    for (int k = 0; k < n; ++k) {
+      if (ids[k] == id) {
+        return true;
+      }
+    }
+    if (n == max_ids) {
+      return false;
+    }
+    ids[n++] = id;
+    return true;
+  };
+
+  for (int id : unfiltered) {
+    if (!add(id)) {
+      return -1;
+    }
+  }
+
+  int state = 0;
+  for (int i = 0; i < length; ++i) {
+    state = step(state, tolower(static_cast<unsigned char>(str[i])));
+
+    for (int t = (nodes[state].output >= 0) ? state : nodes[state].dict; t >= 0; t = nodes[t].dict) {
+      for (int li = nodes[t].output; li >= 0; li = literal_next[li]) {
+        if (!add(literal_ids[li])) {
+          return -1;
+        }
+      }
+    }
+  }
+
+  std::sort(ids, ids + n);
+  return n;
+}
@@ -0,0 +1,110 @@
+/** @file
+
+  Literal prefilter for large sets of regular expressions.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __TS_REGEX_PREFILTER_H__
+#define __TS_REGEX_PREFILTER_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+  Narrows a large, ordered set of regular expressions down to the few that can match a
+  given string, in a single pass over that string.
+
+  For every pattern the longest literal that any match must contain is extracted, and all
+  those literals go into one Aho-Corasick automaton. A pattern can only match a string
+  that contains its literal, so scanning the string once gives the candidate patterns.
+  Patterns without a usable literal are always candidates. The caller still runs the
+  real regular expression on the candidates, in order, which keeps first-match semantics
+  and gives the captures of the winner.
+
+  Plain strings can be added with add_literal() as well, which turns the prefilter into a
+  search for many substrings at once.
+
+  Matching is case insensitive, so the candidates are a superset for case sensitive
+  patterns as well. The prefilter is immutable once built and safe to use concurrently.
+ */
+class RegexPrefilter
+{
+public:
+  /// Add @a pattern with identifier @a id. Identifiers must be added in increasing order.
+  void add(const char *pattern, int id);
+
+  /** Add the plain string @a literal with identifier @a id.
+
+      The literal is searched for as is, whatever its length, so a candidate is a string
+      that contains @a literal, ignoring case. Identifiers share the ordering of add().
+   */
+  void add_literal(const char *literal, int id);
+
+  /// Build the automaton. Must be called after the last add() and before candidates().
+  void build();
+
+  /** Find the patterns that might match @a str.
+
+      The identifiers are stored in @a ids in increasing order.
+
+      @return The number of candidates, or -1 if there are more than @a max_ids of them,
+      in which case the caller should try all the patterns.
+   */
+  int candidates(const char *str, int length, int *ids, int max_ids) const;
+
+  /// The number of patterns that are filtered by a literal.
+  size_t
+  filtered() const
+  {
+    return literal_ids.size();
+  }
+
+  /// The longest literal every match of @a pattern contains, empty if there is none.
+  static std::string required_literal(const char *pattern);
+
+  /// Literals shorter than this match too often to be worth filtering on.
+  static const size_t MIN_LITERAL_LENGTH = 3;
+
+private:
+  struct Node {
+    uint32_t edge_begin; // transitions, in edge_char / edge_target
+    uint32_t edge_end;
+    int32_t fail;   // longest proper suffix that is also in the trie
+    int32_t output; // first literal ending here, index into literal_ids, or -1
+    int32_t dict;   // nearest node on the fail chain with an output, or -1
+  };
+
+  int step(int state, unsigned char c) const;
+
+  std::vector<Node> nodes;
+  std::vector<unsigned char> edge_char;
+  std::vector<int32_t> edge_target;
+  int32_t root_next[256];
+
+  std::vector<int> literal_ids;      // pattern id for each literal
+  std::vector<int32_t> literal_next; // next literal ending at the same node, or -1
+  std::vector<int> unfiltered;       // patterns without a literal, always candidates
+
+  // Build time only.
+  std::vector<std::string> literals;
+};
+
+#endif /* __TS_REGEX_PREFILTER_H__ */
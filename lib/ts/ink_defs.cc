@@ -140,6 +140,17 @@ ink_number_of_processors()
 #endif
 }
 
+int
+ink_number_of_numa_nodes()
+{
+#if TS_USE_HWLOC
+  int nodes = hwloc_get_nbobjs_by_type(ink_get_topology(), HWLOC_OBJ_NODE);
+  return nodes > 0 ? nodes : 1;
+#else
+  return 1;
+#endif
+}
+
 int
 ink_login_name_max()
 {
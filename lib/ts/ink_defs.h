@@ -125,6 +125,7 @@ extern int on;
 */
 int ink_sys_name_release(char *name, int namelen, char *release, int releaselen);
 int ink_number_of_processors();
+int ink_number_of_numa_nodes();
 int ink_login_name_max();
 
 #if TS_USE_HWLOC
@@ -49,6 +49,7 @@
 #include "ts/ink_error.h"
 #include "ts/ink_assert.h"
 #include "ts/ink_align.h"
+#include "ts/ink_thread.h"
 #include "ts/hugepages.h"
 #include "ts/Diags.h"
 
@@ -84,11 +85,18 @@ static void *malloc_new(InkFreeList *f);
 static void malloc_free(InkFreeList *f, void *item);
 static void malloc_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item);
 
+static void *magazine_new(InkFreeList *f);
+static void magazine_free(InkFreeList *f, void *item);
+static void magazine_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item);
+static uint32_t magazine_rounds(uint32_t type_size);
+
 static const ink_freelist_ops malloc_ops   = {malloc_new, malloc_free, malloc_bulkfree};
 static const ink_freelist_ops freelist_ops = {freelist_new, freelist_free, freelist_bulkfree};
+static const ink_freelist_ops magazine_ops = {magazine_new, magazine_free, magazine_bulkfree};
 static const ink_freelist_ops *default_ops = &freelist_ops;
 
 static ink_freelist_list *freelists                  = nullptr;
+static uint32_t freelist_count                       = 0;
 static const ink_freelist_ops *freelist_freelist_ops = default_ops;
 
 const InkFreeListOps *
@@ -103,12 +111,19 @@ ink_freelist_freelist_ops()
   return &freelist_ops;
 }
 
+const InkFreeListOps *
+ink_freelist_magazine_ops()
+{
+  return &magazine_ops;
+}
+
 void
 ink_freelist_init_ops(const InkFreeListOps *ops)
 {
-  // This *MUST* only be called at startup before any freelists allocate anything. We will certainly crash if object
-  // allocated from the freelist are freed by malloc.
-  ink_release_assert(freelist_freelist_ops == default_ops);
+  // Switching to malloc *MUST* only be done at startup before any freelists allocate anything. We will certainly
+  // crash if object allocated from the freelist are freed by malloc. The magazines are a cache in front of the
+  // freelists, so those two can be switched at any time.
+  ink_release_assert(freelist_freelist_ops == default_ops || (ops != &malloc_ops && freelist_freelist_ops != &malloc_ops));
 
   freelist_freelist_ops = ops;
 }
@@ -129,7 +144,8 @@ ink_freelist_init(InkFreeList **fl, const char *name, uint32_t type_size, uint32
   fll->next = freelists;
   freelists = fll;
 
-  f->name = name;
+  f->name  = name;
+  f->index = ink_atomic_increment(&freelist_count, 1);
   /* quick test for power of 2 */
   ink_assert(!(alignment & (alignment - 1)));
   // It is never useful to have alignment requirement looser than a page size
@@ -142,6 +158,7 @@ ink_freelist_init(InkFreeList **fl, const char *name, uint32_t type_size, uint32
   // Make sure we align *all* the objects in the allocation, not just the first one
   f->type_size = INK_ALIGN(type_size, f->alignment);
   Debug(DEBUG_TAG "_init", "<%s> Type Size request/actual (%" PRIu32 "/%" PRIu32 ")", name, type_size, f->type_size);
+  f->magazine_rounds = magazine_rounds(f->type_size);
   if (ats_hugepage_enabled()) {
     f->chunk_size = INK_ALIGN(chunk_size * f->type_size, ats_hugepage_size()) / f->type_size;
   } else {
@@ -179,9 +196,11 @@ int fake_global_for_ink_queue = 0;
 void *
 ink_freelist_new(InkFreeList *f)
 {
+  const ink_freelist_ops *ops = freelist_freelist_ops;
   void *ptr;
 
-  if (likely(ptr = freelist_freelist_ops->fl_new(f))) {
+  // The magazines keep their own count of the items they hand out, see magazine_new().
+  if (likely(ptr = ops->fl_new(f)) && ops != &magazine_ops) {
     ink_atomic_increment((int *)&f->used, 1);
   }
 
@@ -272,10 +291,14 @@ malloc_new(InkFreeList *f)
 void
 ink_freelist_free(InkFreeList *f, void *item)
 {
+  const ink_freelist_ops *ops = freelist_freelist_ops;
+
   if (likely(item != nullptr)) {
-    ink_assert(f->used != 0);
-    freelist_freelist_ops->fl_free(f, item);
-    ink_atomic_decrement((int *)&f->used, 1);
+    ops->fl_free(f, item);
+    if (ops != &magazine_ops) {
+      ink_assert(f->used != 0);
+      ink_atomic_decrement((int *)&f->used, 1);
+    }
   }
 }
 
@@ -329,10 +352,13 @@ malloc_free(InkFreeList *f, void *item)
 void
 ink_freelist_free_bulk(InkFreeList *f, void *head, void *tail, size_t num_item)
 {
-  ink_assert(f->used >= num_item);
+  const ink_freelist_ops *ops = freelist_freelist_ops;
 
-  freelist_freelist_ops->fl_bulkfree(f, head, tail, num_item);
-  ink_atomic_decrement((int *)&f->used, num_item);
+  ops->fl_bulkfree(f, head, tail, num_item);
+  if (ops != &magazine_ops) {
+    ink_assert(f->used >= num_item);
+    ink_atomic_decrement((int *)&f->used, num_item);
+  }
 }
 
 static void
@@ -399,6 +425,353 @@ malloc_bulkfree(InkFreeList *f, void *head, void *tail, size_t num_item)
   }
 }
 
+/*
+ * Magazines
+ *
+ * Each thread keeps two magazines, small stacks of free items, for every
+ * freelist and allocates from and frees to them without any atomic
+ * operation. Only when both are empty (or both full) does it trade a whole
+ * magazine with the depot, which holds lists of full and empty magazines.
+ * The thread counts the items it hands out and frees itself, and adds that
+ * count to InkFreeList::used only when it trades with the depot or exits, so
+ * the used count of a freelist lags by at most two magazines per thread.
+ * There is a depot per NUMA node so that items freed on a node are reused
+ * there, and the global freelist is only used when the depot has no full
+ * magazine left. See Bonwick and Adams, "Magazines and Vmem" (USENIX 2001).
+ */
+
+#define MAGAZINE_ROUNDS 64
+#define MAGAZINE_MIN_ROUNDS 2
+#define MAGAZINE_BYTES (32 * 1024)                            // a magazine holds at most this much, unless it has MAGAZINE_MIN_ROUNDS
+#define MAX_DEPOT_MAGAZINES 64                                // of each kind per depot, the rest go back to the freelist or are spares
+#define MAX_DEPOT_BYTES (MAX_DEPOT_MAGAZINES * MAGAZINE_BYTES) // of items in the full magazines of a depot, at least one magazine
+#define MAX_DEPOT_NODES 16
+
+struct ink_freelist_magazine {
+  ink_freelist_magazine *next; // in the depot
+  uint32_t rounds;
+  void *round[MAGAZINE_ROUNDS];
+};
+
+struct ink_freelist_depot {
+  InkFreeList *fl;
+  InkAtomicList full;
+  InkAtomicList empty;
+  uint32_t full_count;
+  uint32_t empty_count;
+  uint32_t misses; // allocations that went to the global freelist
+};
+
+struct ink_freelist_magazines {
+  ink_freelist_magazine *loaded;
+  ink_freelist_magazine *previous;
+  ink_freelist_depot *depot;
+  int32_t used; // items handed out less items freed by this thread, not yet added to InkFreeList::used
+};
+
+// The magazines of one thread, indexed by InkFreeList::index.
+struct ink_freelist_thread_cache {
+  uint32_t count;
+  int node;
+  ink_freelist_magazines *magazines;
+};
+
+static void magazine_thread_exit(void *data);
+
+struct MagazineThreadKey {
+  MagazineThreadKey() { ink_thread_key_create(&this->key, magazine_thread_exit); }
+  ink_thread_key key;
+};
+
+static MagazineThreadKey magazine_key;
+static int depot_nodes = 0;
+
+// Empty magazines the depots had no room for. Like freelist items, magazines are never returned to
+// the allocator: another thread popping a depot list may still be reading the next pointer of one.
+// Zero initialized, which is an empty list with the next pointer at offset 0.
+static InkAtomicList magazine_spares;
+
+// Large items such as I/O buffers get magazines of MAGAZINE_MIN_ROUNDS rounds, which still saves
+// the global freelist for a thread that allocates and frees them in turn, without the thread
+// stranding more than a few of them per freelist.
+static uint32_t
+magazine_rounds(uint32_t type_size)
+{
+  uint32_t rounds = type_size ? MAGAZINE_BYTES / type_size : MAGAZINE_ROUNDS;
+
+  if (rounds < MAGAZINE_MIN_ROUNDS) {
+    return MAGAZINE_MIN_ROUNDS;
+  }
+  return rounds > MAGAZINE_ROUNDS ? MAGAZINE_ROUNDS : rounds;
+}
+
+// The most full magazines a depot of @a f keeps.
+static uint32_t
+magazine_depot_max(InkFreeList *f)
+{
+  uint64_t max = MAX_DEPOT_BYTES / ((uint64_t)f->magazine_rounds * f->type_size);
+
+  if (max < 1) {
+    return 1;
+  }
+  return max > MAX_DEPOT_MAGAZINES ? MAX_DEPOT_MAGAZINES : max;
+}
+
+// Add the count of the items this thread handed out and freed to the freelist.
+static inline void
+magazine_flush_used(InkFreeList *f, ink_freelist_magazines *m)
+{
+  if (m->used != 0) {
+    ink_atomic_increment((int *)&f->used, m->used);
+    m->used = 0;
+  }
+}
+
+static int
+magazine_depot_nodes()
+{
+  if (unlikely(depot_nodes == 0)) {
+    int nodes   = ink_number_of_numa_nodes();
+    depot_nodes = nodes > MAX_DEPOT_NODES ? MAX_DEPOT_NODES : nodes;
+  }
+  return depot_nodes;
+}
+
+// The NUMA node the calling thread is running on.
+static int
+magazine_thread_node()
+{
+  int node = 0;
+
+#if TS_USE_HWLOC
+  hwloc_bitmap_t cpus = hwloc_bitmap_alloc();
+
+  if (hwloc_get_last_cpu_location(ink_get_topology(), cpus, HWLOC_CPUBIND_THREAD) == 0) {
+    hwloc_obj_t obj = hwloc_get_next_obj_covering_cpuset_by_type(ink_get_topology(), cpus, HWLOC_OBJ_NODE, nullptr);
+    if (obj) {
+      node = obj->logical_index % magazine_depot_nodes();
+    }
+  }
+  hwloc_bitmap_free(cpus);
+#endif
+
+  return node;
+}
+
+static ink_freelist_depot *
+magazine_depots(InkFreeList *f)
+{
+  ink_freelist_depot *depots = f->depots;
+
+  if (unlikely(depots == nullptr)) {
+    int nodes = magazine_depot_nodes();
+
+    depots = (ink_freelist_depot *)ats_calloc(nodes, sizeof(ink_freelist_depot));
+    for (int i = 0; i < nodes; ++i) {
+      depots[i].fl = f;
+      ink_atomiclist_init(&depots[i].full, f->name, 0);
+      ink_atomiclist_init(&depots[i].empty, f->name, 0);
+    }
+    if (!ink_atomic_cas(&f->depots, (ink_freelist_depot *)nullptr, depots)) {
+      ats_free(depots);
+      depots = f->depots;
+    }
+  }
+  return depots;
+}
+
+static inline ink_freelist_magazines *
+magazine_thread_magazines(InkFreeList *f)
+{
+  ink_freelist_thread_cache *cache = (ink_freelist_thread_cache *)ink_thread_getspecific(magazine_key.key);
+
+  if (unlikely(cache == nullptr)) {
+    cache       = (ink_freelist_thread_cache *)ats_calloc(1, sizeof(ink_freelist_thread_cache));
+    cache->node = magazine_thread_node();
+    ink_thread_setspecific(magazine_key.key, cache);
+  }
+
+  if (unlikely(f->index >= cache->count)) {
+    uint32_t count = freelist_count > f->index ? freelist_count : f->index + 1;
+
+    cache->magazines = (ink_freelist_magazines *)ats_realloc(cache->magazines, count * sizeof(ink_freelist_magazines));
+    memset(cache->magazines + cache->count, 0, (count - cache->count) * sizeof(ink_freelist_magazines));
+    cache->count = count;
+  }
+
+  ink_freelist_magazines *m = &cache->magazines[f->index];
+  if (unlikely(m->depot == nullptr)) {
+    m->depot = &magazine_depots(f)[cache->node];
+  }
+  return m;
+}
+
+// Return the rounds of @a mag to the global freelist.
+static void
+magazine_drain(InkFreeList *f, ink_freelist_magazine *mag)
+{
+  if (mag->rounds == 0) {
+    return;
+  }
+  for (uint32_t i = 0; i + 1 < mag->rounds; ++i) {
+    *(void **)mag->round[i] = mag->round[i + 1];
+  }
+  *(void **)mag->round[mag->rounds - 1] = nullptr;
+  freelist_bulkfree(f, mag->round[0], mag->round[mag->rounds - 1], mag->rounds);
+  mag->rounds = 0;
+}
+
+static void
+magazine_depot_put(ink_freelist_depot *depot, ink_freelist_magazine *mag)
+{
+  // The counts are only a bound, a few magazines over the limit do no harm.
+  if (mag->rounds > 0) {
+    if (depot->full_count < magazine_depot_max(depot->fl)) {
+      ink_atomiclist_push(&depot->full, mag);
+      ink_atomic_increment(&depot->full_count, 1);
+      return;
+    }
+    magazine_drain(depot->fl, mag);
+  }
+  if (depot->empty_count < MAX_DEPOT_MAGAZINES) {
+    ink_atomiclist_push(&depot->empty, mag);
+    ink_atomic_increment(&depot->empty_count, 1);
+  } else {
+    ink_atomiclist_push(&magazine_spares, mag);
+  }
+}
+
+static void *
+magazine_new(InkFreeList *f)
+{
+  ink_freelist_magazines *m  = magazine_thread_magazines(f);
+  ink_freelist_magazine *mag = m->loaded;
+
+  ++m->used;
+  if (likely(mag != nullptr && mag->rounds > 0)) {
+    return mag->round[--mag->rounds];
+  }
+
+  if (m->previous != nullptr && m->previous->rounds > 0) {
+    m->loaded   = m->previous;
+    m->previous = mag;
+  } else {
+    ink_freelist_magazine *full = (ink_freelist_magazine *)ink_atomiclist_pop(&m->depot->full);
+
+    magazine_flush_used(f, m);
+    if (full == nullptr) {
+      ink_atomic_increment(&m->depot->misses, 1);
+      return freelist_new(f);
+    }
+    ink_atomic_decrement(&m->depot->full_count, 1);
+    if (m->previous != nullptr) {
+      magazine_depot_put(m->depot, m->previous);
+    }
+    m->previous = mag;
+    m->loaded   = full;
+  }
+
+  mag = m->loaded;
+  return mag->round[--mag->rounds];
+}
+
+static void
+magazine_free(InkFreeList *f, void *item)
+{
+  ink_freelist_magazines *m  = magazine_thread_magazines(f);
+  ink_freelist_magazine *mag = m->loaded;
+
+  --m->used;
+  if (likely(mag != nullptr && mag->rounds < f->magazine_rounds)) {
+    mag->round[mag->rounds++] = item;
+    return;
+  }
+
+  if (m->previous != nullptr && m->previous->rounds == 0) {
+    m->loaded   = m->previous;
+    m->previous = mag;
+  } else {
+    ink_freelist_magazine *empty = (ink_freelist_magazine *)ink_atomiclist_pop(&m->depot->empty);
+
+    magazine_flush_used(f, m);
+    if (empty == nullptr) {
+      empty = (ink_freelist_magazine *)ink_atomiclist_pop(&magazine_spares);
+      if (empty == nullptr) {
+        empty = (ink_freelist_magazine *)ats_calloc(1, sizeof(ink_freelist_magazine));
+      }
+    } else {
+      ink_atomic_decrement(&m->depot->empty_count, 1);
+    }
+    if (m->previous != nullptr) {
+      magazine_depot_put(m->depot, m->previous);
+    }
+    m->previous = mag;
+    m->loaded   = empty;
+  }
+
+  mag                       = m->loaded;
+  mag->round[mag->rounds++] = item;
+}
+
+static void
+magazine_bulkfree(InkFreeList *f, void *head, void * /* tail ATS_UNUSED */, size_t num_item)
+{
+  void *item = head;
+  void *next;
+
+  for (size_t i = 0; i < num_item && item; ++i, item = next) {
+    next = *(void **)item; // find next item before freeing current item
+    magazine_free(f, item);
+  }
+}
+
+// Hand the magazines of an exiting thread to the depots.
+static void
+magazine_thread_exit(void *data)
+{
+  ink_freelist_thread_cache *cache = (ink_freelist_thread_cache *)data;
+
+  for (uint32_t i = 0; i < cache->count; ++i) {
+    ink_freelist_magazines *m = &cache->magazines[i];
+
+    if (m->depot) {
+      magazine_flush_used(m->depot->fl, m);
+    }
+    if (m->loaded) {
+      magazine_depot_put(m->depot, m->loaded);
+    }
+    if (m->previous) {
+      magazine_depot_put(m->depot, m->previous);
+    }
+  }
+  ats_free(cache->magazines);
+  ats_free(cache);
+}
+
+static void
+magazines_dump(FILE *f)
+{
+  fprintf(f, "   Full Magazines   |  Empty Magazines   | Depot Misses |   Free List Name\n");
+  fprintf(f, "--------------------|--------------------|--------------|----------------------------------\n");
+
+  for (ink_freelist_list *fll = freelists; fll; fll = fll->next) {
+    ink_freelist_depot *depots = fll->fl->depots;
+    uint64_t full = 0, empty = 0, misses = 0;
+
+    if (depots == nullptr) {
+      continue;
+    }
+    for (int i = 0; i < magazine_depot_nodes(); ++i) {
+      full += depots[i].full_count;
+      empty += depots[i].empty_count;
+      misses += depots[i].misses;
+    }
+    fprintf(f, " %18" PRIu64 " | %18" PRIu64 " | %12" PRIu64 " | memory/%s\n", full, empty, misses,
+            fll->fl->name ? fll->fl->name : "<unknown>");
+  }
+  fprintf(f, "-----------------------------------------------------------------------------------------\n");
+}
+
 void
 ink_freelists_snap_baseline()
 {
@@ -461,6 +834,10 @@ ink_freelists_dump(FILE *f)
   }
   fprintf(f, " %18" PRIu64 " | %18" PRIu64 " |            | TOTAL\n", total_allocated, total_used);
   fprintf(f, "-----------------------------------------------------------------------------------------\n");
+
+  if (freelist_freelist_ops == &magazine_ops) {
+    magazines_dump(f);
+  }
 }
 
 void
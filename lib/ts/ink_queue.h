@@ -152,6 +152,9 @@ struct _InkFreeList {
   uint32_t type_size, chunk_size, used, allocated, alignment;
   uint32_t allocated_base, used_base;
   int advice;
+  uint32_t index;                    // of this freelist in the per-thread magazines
+  uint32_t magazine_rounds;          // items per magazine
+  struct ink_freelist_depot *depots; // magazine depots, one per NUMA node
 };
 
 typedef struct ink_freelist_ops InkFreeListOps;
@@ -159,6 +162,7 @@ typedef struct _InkFreeList InkFreeList;
 
 const InkFreeListOps *ink_freelist_malloc_ops();
 const InkFreeListOps *ink_freelist_freelist_ops();
+const InkFreeListOps *ink_freelist_magazine_ops();
 void ink_freelist_init_ops(const InkFreeListOps *);
 
 /*
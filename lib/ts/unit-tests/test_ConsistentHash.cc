@@ -0,0 +1,287 @@
+/** @file
+
+  Test file for ATSConsistentHash
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include "ts/ConsistentHash.h"
+#include "ts/HashSip.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+const int N_NODES = 200;
+
+struct TestRing {
+  std::vector<ATSConsistentHashNode> nodes;
+  std::vector<std::string> names;
+  ATSConsistentHash ring;
+  std::map<uint64_t, ATSConsistentHashNode *> reference; // the ring as it used to be stored
+
+  TestRing() : nodes(N_NODES), names(N_NODES)
+  {
+    ATSHash64Sip24 hash;
+
+    for (int i = 0; i < N_NODES; ++i) {
+      names[i]           = "parent" + std::to_string(i) + ".example.com";
+      nodes[i].name      = const_cast<char *>(names[i].c_str());
+      nodes[i].available = true;
+
+      float weight = 0.5 + (i % 4) * 0.5;
+      ring.insert(&nodes[i], weight, &hash);
+
+      char numstr[256];
+      for (int j = 0; j < (int)roundf(1024 * weight); ++j) {
+        snprintf(numstr, sizeof(numstr), "%d-", j);
+        hash.update(numstr, strlen(numstr));
+        hash.update(names[i].c_str(), names[i].size());
+        hash.final();
+        reference.insert(std::make_pair(hash.get(), &nodes[i]));
+        hash.clear();
+      }
+    }
+    ring.build();
+  }
+
+  ATSConsistentHashNode *
+  reference_lookup(uint64_t hashval)
+  {
+    auto spot = reference.lower_bound(hashval);
+    return spot == reference.end() ? reference.begin()->second : spot->second;
+  }
+};
+} // namespace
+
+TEST_CASE("ConsistentHash matches a map based ring", "[libts][ConsistentHash]")
+{
+  TestRing t;
+  std::mt19937_64 rng(42);
+
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t hashval = rng();
+    REQUIRE(t.ring.lookup_by_hashval(hashval) == t.reference_lookup(hashval));
+  }
+
+  // Exact ring points and the ends of the hash space.
+  for (auto const &spot : t.reference) {
+    REQUIRE(t.ring.lookup_by_hashval(spot.first) == spot.second);
+  }
+  REQUIRE(t.ring.lookup_by_hashval(0) == t.reference.begin()->second);
+  REQUIRE(t.ring.lookup_by_hashval(UINT64_MAX) == t.reference_lookup(UINT64_MAX));
+}
+
+TEST_CASE("ConsistentHash iteration walks the whole ring once", "[libts][ConsistentHash]")
+{
+  TestRing t;
+  ATSHash64Sip24 hash;
+  ATSConsistentHashIter iter;
+  bool wrapped = false;
+  size_t count = 0;
+
+  ATSConsistentHashNode *node = t.ring.lookup_by_hashval(t.reference.rbegin()->first, &iter, &wrapped);
+  REQUIRE(node == t.reference.rbegin()->second);
+  REQUIRE(wrapped == false);
+
+  // Stepping past the end wraps around and then visits every point on the ring.
+  auto spot = t.reference.begin();
+  while ((node = t.ring.lookup(nullptr, &iter, &wrapped, &hash)) != nullptr) {
+    REQUIRE(wrapped == true);
+    REQUIRE(spot != t.reference.end());
+    REQUIRE(node == spot->second);
+    ++spot;
+    ++count;
+  }
+  REQUIRE(count == t.reference.size());
+}
+
+TEST_CASE("ConsistentHash lookup_available skips unavailable nodes", "[libts][ConsistentHash]")
+{
+  TestRing t;
+  ATSHash64Sip24 hash;
+
+  for (int i = 0; i < N_NODES; i += 2) {
+    t.nodes[i].available = false;
+  }
+
+  std::mt19937_64 rng(7);
+  for (int i = 0; i < 1000; ++i) {
+    std::string url             = "http://example.com/" + std::to_string(rng());
+    ATSConsistentHashNode *node = t.ring.lookup_available(url.c_str(), nullptr, nullptr, &hash);
+    REQUIRE(node != nullptr);
+    REQUIRE(node->available);
+  }
+
+  for (auto &node : t.nodes) {
+    node.available = false;
+  }
+  REQUIRE(t.ring.lookup_available("http://example.com/", nullptr, nullptr, &hash) == nullptr);
+}
+
+TEST_CASE("ConsistentHash empty ring", "[libts][ConsistentHash]")
+{
+  ATSConsistentHash ring;
+  ATSHash64Sip24 hash;
+
+  REQUIRE(ring.lookup_by_hashval(1234) == nullptr);
+  REQUIRE(ring.lookup("http://example.com/", nullptr, nullptr, &hash) == nullptr);
+  REQUIRE(ring.lookup_available("http://example.com/", nullptr, nullptr, &hash) == nullptr);
+}
+
+TEST_CASE("MaglevHash spreads keys by weight", "[libts][MaglevHash]")
+{
+  std::vector<ATSConsistentHashNode> nodes(8);
+  std::vector<std::string> names(nodes.size());
+  ATSHash64Sip24 hash;
+  ATSMaglevHash maglev;
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    names[i]           = "parent" + std::to_string(i) + ".example.com";
+    nodes[i].name      = const_cast<char *>(names[i].c_str());
+    nodes[i].available = true;
+    maglev.insert(&nodes[i], i == 0 ? 2.0 : 1.0, &hash);
+  }
+  maglev.build();
+  REQUIRE(maglev.table_size() == MAGLEV_DEFAULT_TABLE_SIZE);
+
+  std::map<ATSConsistentHashNode *, size_t> counts;
+  for (size_t slot = 0; slot < maglev.table_size(); ++slot) {
+    ++counts[maglev.lookup_by_hashval(slot)];
+  }
+  REQUIRE(counts.size() == nodes.size());
+
+  // Node 0 has twice the weight of the others, which share the rest evenly.
+  double share = maglev.table_size() / 9.0;
+  REQUIRE(std::abs(counts[&nodes[0]] - 2 * share) <= 2);
+  for (size_t i = 1; i < nodes.size(); ++i) {
+    REQUIRE(std::abs(counts[&nodes[i]] - share) <= 2);
+  }
+}
+
+TEST_CASE("MaglevHash removing a node moves few keys", "[libts][MaglevHash]")
+{
+  std::vector<ATSConsistentHashNode> nodes(20);
+  std::vector<std::string> names(nodes.size());
+  ATSHash64Sip24 hash;
+  ATSMaglevHash before, after;
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    names[i]           = "parent" + std::to_string(i) + ".example.com";
+    nodes[i].name      = const_cast<char *>(names[i].c_str());
+    nodes[i].available = true;
+    before.insert(&nodes[i], 1.0, &hash);
+    if (i != 7) {
+      after.insert(&nodes[i], 1.0, &hash);
+    }
+  }
+  before.build();
+  after.build();
+
+  std::mt19937_64 rng(3);
+  size_t moved = 0, keys = 100000;
+  for (size_t i = 0; i < keys; ++i) {
+    uint64_t hashval           = rng();
+    ATSConsistentHashNode *was = before.lookup_by_hashval(hashval);
+    ATSConsistentHashNode *is  = after.lookup_by_hashval(hashval);
+    if (was != &nodes[7] && was != is) {
+      ++moved;
+    }
+  }
+  // Only the keys of the removed node have to move, allow for a little churn.
+  REQUIRE(moved < keys / 20);
+}
+
+TEST_CASE("MaglevHash adding a node to a small set moves few keys", "[libts][MaglevHash]")
+{
+  std::vector<ATSConsistentHashNode> nodes(6);
+  std::vector<std::string> names(nodes.size());
+  ATSHash64Sip24 hash;
+  ATSMaglevHash before, after;
+
+  // Five and six nodes, where a size picked from the node count used to change.
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    names[i]           = "parent" + std::to_string(i) + ".example.com";
+    nodes[i].name      = const_cast<char *>(names[i].c_str());
+    nodes[i].available = true;
+    if (i != 5) {
+      before.insert(&nodes[i], 1.0, &hash);
+    }
+    after.insert(&nodes[i], 1.0, &hash);
+  }
+  before.build();
+  after.build();
+  REQUIRE(before.table_size() == after.table_size());
+
+  std::mt19937_64 rng(4);
+  size_t moved = 0, gained = 0, keys = 100000;
+  for (size_t i = 0; i < keys; ++i) {
+    uint64_t hashval           = rng();
+    ATSConsistentHashNode *was = before.lookup_by_hashval(hashval);
+    ATSConsistentHashNode *is  = after.lookup_by_hashval(hashval);
+    if (is == &nodes[5]) {
+      ++gained;
+    } else if (was != is) {
+      ++moved;
+    }
+  }
+  // The new node takes its sixth of the keys, almost all the others stay where they were.
+  REQUIRE(gained > keys / 7);
+  REQUIRE(moved < keys / 20);
+}
+
+TEST_CASE("MaglevHash iteration and availability", "[libts][MaglevHash]")
+{
+  std::vector<ATSConsistentHashNode> nodes(4);
+  std::vector<std::string> names(nodes.size());
+  ATSHash64Sip24 hash;
+  ATSMaglevHash maglev;
+  ATSConsistentHashIter iter;
+  bool wrapped = false;
+
+  REQUIRE(maglev.lookup_by_hashval(1) == nullptr);
+
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    names[i]           = "parent" + std::to_string(i) + ".example.com";
+    nodes[i].name      = const_cast<char *>(names[i].c_str());
+    nodes[i].available = i == 3;
+    maglev.insert(&nodes[i], 1.0, &hash);
+  }
+  maglev.build();
+
+  REQUIRE(maglev.lookup_available("http://example.com/", nullptr, nullptr, &hash) == &nodes[3]);
+
+  size_t count = 1;
+  REQUIRE(maglev.lookup_by_hashval(maglev.table_size() - 1, &iter, &wrapped) != nullptr);
+  while (maglev.lookup(nullptr, &iter, &wrapped, &hash) != nullptr) {
+    ++count;
+  }
+  REQUIRE(wrapped == true);
+  REQUIRE(count == maglev.table_size() + 1);
+
+  nodes[3].available = false;
+  REQUIRE(maglev.lookup_available("http://example.com/", nullptr, nullptr, &hash) == nullptr);
+}
@@ -0,0 +1,220 @@
+/** @file
+
+  Test file for the freelist magazines
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include "ts/ink_queue.h"
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const int N_ITEMS   = 1000;
+const int N_THREADS = 8;
+
+// The magazines cache items of the freelists, switching back and forth is safe.
+struct UseOps {
+  UseOps(const InkFreeListOps *ops) { ink_freelist_init_ops(ops); }
+  ~UseOps() { ink_freelist_init_ops(ink_freelist_freelist_ops()); }
+};
+
+// Allocate and free batches of items, checking nobody else wrote to them.
+bool
+churn(InkFreeList *f, int id, int rounds)
+{
+  std::vector<uint64_t *> items(64);
+
+  for (int r = 0; r < rounds; ++r) {
+    for (auto &item : items) {
+      item    = static_cast<uint64_t *>(ink_freelist_new(f));
+      item[1] = id;
+    }
+    for (auto item : items) {
+      if (item[1] != static_cast<uint64_t>(id)) {
+        return false;
+      }
+      ink_freelist_free(f, item);
+    }
+  }
+  return true;
+}
+} // namespace
+
+TEST_CASE("Freelist magazines reuse items", "[libts][freelist]")
+{
+  InkFreeList *f = ink_freelist_create("test_magazine_reuse", 64, 256, 8);
+  UseOps magazines(ink_freelist_magazine_ops());
+  std::set<void *> seen;
+  std::vector<void *> items;
+
+  // A thread adds the items it counted in its magazines to the freelist when it exits.
+  std::thread([&]() {
+    for (int i = 0; i < N_ITEMS; ++i) {
+      items.push_back(ink_freelist_new(f));
+    }
+  }).join();
+  for (auto item : items) {
+    REQUIRE(seen.insert(item).second);
+  }
+  REQUIRE(f->used == N_ITEMS);
+
+  // Freeing in bulk goes through the magazines as well.
+  std::thread([&]() {
+    for (size_t i = 0; i + 1 < items.size() / 2; ++i) {
+      *static_cast<void **>(items[i]) = items[i + 1];
+    }
+    ink_freelist_free_bulk(f, items[0], items[items.size() / 2 - 1], items.size() / 2);
+    for (size_t i = items.size() / 2; i < items.size(); ++i) {
+      ink_freelist_free(f, items[i]);
+    }
+  }).join();
+  REQUIRE(f->used == 0);
+
+  uint32_t allocated = f->allocated;
+  std::set<void *> again;
+  for (int i = 0; i < N_ITEMS; ++i) {
+    void *item = ink_freelist_new(f);
+    REQUIRE(seen.count(item) == 1);
+    REQUIRE(again.insert(item).second);
+  }
+  REQUIRE(f->allocated == allocated);
+
+  for (auto item : again) {
+    ink_freelist_free(f, item);
+  }
+}
+
+TEST_CASE("Freelist magazines across threads", "[libts][freelist]")
+{
+  InkFreeList *f = ink_freelist_create("test_magazine_threads", 64, 256, 8);
+  UseOps magazines(ink_freelist_magazine_ops());
+  std::atomic<int> failures(0);
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    threads.emplace_back([&, i]() {
+      if (!churn(f, i, 2000)) {
+        ++failures;
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  REQUIRE(failures == 0);
+  REQUIRE(f->used == 0);
+
+  // Items freed on one thread are handed to others through the depot.
+  std::vector<void *> items(N_ITEMS);
+  std::thread producer([&]() {
+    for (auto &item : items) {
+      item = ink_freelist_new(f);
+    }
+  });
+  producer.join();
+  std::thread consumer([&]() {
+    for (auto item : items) {
+      ink_freelist_free(f, item);
+    }
+  });
+  consumer.join();
+  REQUIRE(f->used == 0);
+
+  uint32_t allocated = f->allocated;
+  REQUIRE(churn(f, 0, 100));
+  REQUIRE(f->allocated == allocated);
+}
+
+TEST_CASE("Freelist magazines hold few large items", "[libts][freelist]")
+{
+  InkFreeList *f = ink_freelist_create("test_magazine_large", 1024 * 1024, 4, 8);
+  REQUIRE(f->magazine_rounds == 2);
+
+  // A thread that frees and allocates in turn gets the same item back from its magazine.
+  std::vector<void *> items(12);
+  bool reused = false;
+  {
+    UseOps magazines(ink_freelist_magazine_ops());
+    std::thread([&]() {
+      void *item = ink_freelist_new(f);
+      ink_freelist_free(f, item);
+      reused = ink_freelist_new(f) == item;
+      ink_freelist_free(f, item);
+
+      for (auto &item : items) {
+        item = ink_freelist_new(f);
+      }
+      for (auto item : items) {
+        ink_freelist_free(f, item);
+      }
+    }).join();
+  }
+  REQUIRE(reused);
+  REQUIRE(f->used == 0);
+
+  // Once the thread is gone the depot keeps a single full magazine of these, the rest are back on
+  // the global freelist.
+  const size_t kept  = 2;
+  uint32_t allocated = f->allocated;
+  for (size_t i = 0; i < items.size() - kept; ++i) {
+    items[i] = ink_freelist_new(f);
+  }
+  REQUIRE(f->allocated == allocated);
+  for (size_t i = 0; i < items.size() - kept; ++i) {
+    ink_freelist_free(f, items[i]);
+  }
+}
+
+TEST_CASE("Freelist magazine depots are bounded", "[libts][freelist]")
+{
+  InkFreeList *f = ink_freelist_create("test_magazine_depot", 64, 256, 8);
+  REQUIRE(f->magazine_rounds == 64);
+
+  const int kept = 64 * 64 + 2 * 64; // a full depot plus the magazines of one thread
+  std::vector<void *> items(kept * 2);
+  for (auto &item : items) {
+    item = ink_freelist_new(f);
+  }
+  {
+    UseOps magazines(ink_freelist_magazine_ops());
+    std::thread t([&]() {
+      for (auto item : items) {
+        ink_freelist_free(f, item);
+      }
+    });
+    t.join();
+  }
+  REQUIRE(f->used == 0);
+
+  // Whatever did not fit in the depot is back on the global freelist.
+  uint32_t allocated = f->allocated;
+  for (size_t i = 0; i < items.size() - kept; ++i) {
+    items[i] = ink_freelist_new(f);
+  }
+  REQUIRE(f->allocated == allocated);
+  for (size_t i = 0; i < items.size() - kept; ++i) {
+    ink_freelist_free(f, items[i]);
+  }
+}
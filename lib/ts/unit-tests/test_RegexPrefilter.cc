@@ -0,0 +1,390 @@
+/** @file
+
+  Test file for RegexPrefilter
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "catch.hpp"
+
+#include "ts/RegexPrefilter.h"
+#include "ts/Regex.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+TEST_CASE("RegexPrefilter required literal", "[libts][RegexPrefilter]")
+{
+  struct {
+    const char *pattern;
+    const char *literal;
+  } cases[] = {
+    {"www.example.com", "example"},
+    {"www\\.example\\.com", "www.example.com"},
+    {"^(.*)\\.Example\\.com$", ".example.com"},
+    {"^[a-z]+\\.cdn\\.net$", ".cdn.net"},
+    {"colou?r-server", "r-server"},
+    {"abc*defgh", "defgh"},
+    {"ab{2,3}cdef", "cdef"},
+    {"ab+cd", "ab"},
+    {"host\\d+\\.example", ".example"},
+    {"[\\]x]static\\.example", "static.example"},
+    {"(a|b)long-literal", "long-literal"},
+    {"foo|barbaz", ""},
+    {"(?i)caseless", ""},
+    {"\\x41\\x42\\x43", ""},
+    {"(unterminated", ""},
+    {".*", ""},
+  };
+
+  for (auto const &c : cases) {
+    INFO(c.pattern);
+    REQUIRE(RegexPrefilter::required_literal(c.pattern) == c.literal);
+  }
+}
+
+TEST_CASE("RegexPrefilter candidates", "[libts][RegexPrefilter]")
+{
+  const char *patterns[] = {
+    "^(.*)\\.example\\.com$", "^www\\.example\\.org$", "^img[0-9]+\\.cdn\\.net$", ".*", "^(.*)\\.example\\.net$", "ample",
+  };
+  RegexPrefilter filter;
+  int ids[16];
+
+  for (int i = 0; i < static_cast<int>(sizeof(patterns) / sizeof(*patterns)); ++i) {
+    filter.add(patterns[i], i);
+  }
+  filter.build();
+  REQUIRE(filter.filtered() == 5);
+
+  SECTION("overlapping literals")
+  {
+    int n = filter.candidates("foo.EXAMPLE.com", 15, ids, 16);
+    REQUIRE(n == 3);
+    REQUIRE(ids[0] == 0);
+    REQUIRE(ids[1] == 3);
+    REQUIRE(ids[2] == 5);
+  }
+
+  SECTION("only the unfiltered pattern")
+  {
+    int n = filter.candidates("img7.cdn.org", 12, ids, 16);
+    REQUIRE(n == 1);
+    REQUIRE(ids[0] == 3);
+  }
+
+  SECTION("overflow")
+  {
+    REQUIRE(filter.candidates("www.example.org", 15, ids, 2) == -1);
+  }
+}
+
+TEST_CASE("RegexPrefilter never drops a matching pattern", "[libts][RegexPrefilter]")
+{
+  std::vector<std::string> patterns;
+  std::vector<std::unique_ptr<Regex>> regexes;
+  RegexPrefilter filter;
+  std::mt19937 rng(5);
+
+  for (int i = 0; i < 500; ++i) {
+    switch (i % 5) {
+    case 0:
+      patterns.push_back("^(.*)\\.site" + std::to_string(i) + "\\.example\\.com$");
+      break;
+    case 1:
+      patterns.push_back("^img[0-9]*\\.s" + std::to_string(i) + "x?\\.cdn\\.net$");
+      break;
+    case 2:
+      patterns.push_back("^(www|static)\\.host" + std::to_string(i) + "\\.org$");
+      break;
+    case 3:
+      patterns.push_back("^[a-z]+-" + std::to_string(i) + "\\.edge\\.example$");
+      break;
+    default:
+      patterns.push_back("^h" + std::to_string(i) + "\\.[a-z]+$");
+      break;
+    }
+    regexes.emplace_back(new Regex);
+    REQUIRE(regexes.back()->compile(patterns.back().c_str(), RE_CASE_INSENSITIVE));
+    filter.add(patterns.back().c_str(), i);
+  }
+  filter.build();
+
+  const char *suffixes[] = {".example.com", ".cdn.net", ".org", ".edge.example", ".net"};
+  const char *prefixes[] = {"a.site", "img4.s", "www.host", "abc-", "h", "static.host", "img.s"};
+  int ids[512];
+
+  for (int i = 0; i < 5000; ++i) {
+    std::string host = std::string(prefixes[rng() % 7]) + std::to_string(rng() % 520) + suffixes[rng() % 5];
+    int n            = filter.candidates(host.data(), host.size(), ids, 512);
+
+    REQUIRE(n >= 0);
+    for (int id = 0, k = 0; id < static_cast<int>(regexes.size()); ++id) {
+      bool candidate = k < n && ids[k] == id;
+      if (candidate) {
+        ++k;
+      } else {
+        INFO(host << " " << patterns[id]);
+        REQUIRE(!regexes[id]->exec(host.c_str()));
+      }
+    }
+  }
+}
+
+TEST_CASE("RegexPrefilter plain literals", "[libts][RegexPrefilter]")
+{
+  const char *literals[] = {"a.b", "X", "", "example.com", "ample"};
+  RegexPrefilter filter;
+  int ids[8];
+
+  for (int i = 0; i < static_cast<int>(sizeof(literals) / sizeof(*literals)); ++i) {
+    filter.add_literal(literals[i], i);
+  }
+  filter.build();
+  REQUIRE(filter.filtered() == 4);
+
+  // Regular expression characters and short literals are taken as is.
+  int n = filter.candidates("aXb.EXAMPLE.COM", 15, ids, 8);
+  REQUIRE(n == 4);
+  REQUIRE(ids[0] == 1);
+  REQUIRE(ids[1] == 2);
+  REQUIRE(ids[2] == 3);
+  REQUIRE(ids[3] == 4);
+
+  n = filter.candidates("a.b", 3, ids, 8);
+  REQUIRE(n == 2);
+  REQUIRE(ids[0] == 0);
+  REQUIRE(ids[1] == 2);
+}
+
+// Not run by default, use "test_tslib [benchmark]" to compare against trying every pattern.
+TEST_CASE("RegexPrefilter benchmark", "[.][benchmark]")
+{
+  const int N_PATTERNS = 40000;
+  std::vector<std::unique_ptr<Regex>> regexes;
+  std::vector<std::string> hosts;
+  RegexPrefilter filter;
+  std::mt19937 rng(9);
+  int ids[64];
+  size_t linear = 0, filtered = 0;
+
+  for (int i = 0; i < N_PATTERNS; ++i) {
+    std::string pattern = "^(.*)\\.site" + std::to_string(i) + "\\.example\\.com$";
+    regexes.emplace_back(new Regex);
+    regexes.back()->compile(pattern.c_str(), RE_CASE_INSENSITIVE);
+    filter.add(pattern.c_str(), i);
+  }
+  filter.build();
+
+  for (int i = 0; i < 200; ++i) {
+    hosts.push_back("www.site" + std::to_string(rng() % (2 * N_PATTERNS)) + ".example.com");
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto const &host : hosts) {
+    for (int id = 0; id < N_PATTERNS; ++id) {
+      if (regexes[id]->exec(host.c_str())) {
+        linear += id;
+        break;
+      }
+    }
+  }
+  auto linear_time = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (auto const &host : hosts) {
+    int n = filter.candidates(host.data(), host.size(), ids, 64);
+    for (int k = 0; k < n; ++k) {
+      if (regexes[ids[k]]->exec(host.c_str())) {
+        filtered += ids[k];
+        break;
+      }
+    }
+  }
+  auto filtered_time = std::chrono::steady_clock::now() - start;
+
+  printf("%d patterns, %zu hosts: every pattern %.1f us/host, prefiltered %.1f us/host\n", N_PATTERNS, hosts.size(),
+         std::chrono::duration<double, std::micro>(linear_time).count() / hosts.size(),
+         std::chrono::duration<double, std::micro>(filtered_time).count() / hosts.size());
+  REQUIRE(linear == filtered);
+}
+
+namespace
+{
+// Write a remap.config with @a count regex_map rules in the shapes seen in real configurations:
+// wildcard subdomains, numbered shard hosts, alternations, unanchored and literal free hosts.
+std::string
+write_remap_config(int count)
+{
+  char path[] = "/tmp/test_RegexPrefilter.XXXXXX";
+  int fd      = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+
+  std::ofstream out(path);
+  std::mt19937 rng(11);
+
+  out << "# Synthetic remap.config for the RegexPrefilter benchmark\n";
+  for (int i = 0; i < count; ++i) {
+    std::string n = std::to_string(i);
+    std::string host;
+
+    switch (rng() % 10) {
+    case 0:
+    case 1:
+    case 2:
+      host = "^(.*)\\.site" + n + "\\.example\\.com$";
+      break;
+    case 3:
+    case 4:
+      host = "^img[0-9]+\\.shard" + n + "\\.cdn\\.net$";
+      break;
+    case 5:
+      host = "^(www|static|media)\\.brand" + n + "\\.(com|net|org)$";
+      break;
+    case 6:
+      host = "^[a-z]+-" + n + "\\.edge\\.example$";
+      break;
+    case 7:
+      host = "tenant" + n + "\\.saas\\.example";
+      break;
+    case 8:
+      host = "^api-v[0-9]\\.svc" + n + "\\.internal$";
+      break;
+    default:
+      // Nothing to filter on, so these are tried for every request.
+      host = (i % 100 == 9) ? "^h[0-9]+\\.[a-z]+$" : "^(.*)\\.zone" + n + "\\.example\\.org$";
+      break;
+    }
+    out << "regex_map http://" << host << "/ http://origin" << n << ".example.com/\n";
+  }
+  return path;
+}
+
+// The host regular expressions of the regex_map rules in @a path, in file order.
+std::vector<std::string>
+load_remap_config(const char *path)
+{
+  std::ifstream in(path);
+  std::vector<std::string> hosts;
+  std::string line;
+
+  REQUIRE(in.is_open());
+  while (std::getline(in, line)) {
+    std::istringstream tokens(line);
+    std::string directive, from;
+
+    if (!(tokens >> directive >> from) || directive != "regex_map") {
+      continue;
+    }
+    size_t begin = from.find("://");
+    begin        = (begin == std::string::npos) ? 0 : begin + 3;
+    size_t end   = from.find('/', begin);
+    hosts.push_back(from.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+  }
+  return hosts;
+}
+} // namespace
+
+// Not run by default, use "test_tslib [benchmark]". Set REMAP_BENCH_CONFIG to a remap.config to
+// measure its regex_map rules instead of the generated ones.
+TEST_CASE("RegexPrefilter remap.config benchmark", "[.][benchmark]")
+{
+  const char *config = getenv("REMAP_BENCH_CONFIG");
+  std::string generated;
+
+  if (config == nullptr) {
+    generated = write_remap_config(40000);
+    config    = generated.c_str();
+  }
+
+  std::vector<std::string> patterns = load_remap_config(config);
+  std::vector<std::unique_ptr<Regex>> regexes;
+  std::vector<std::string> hosts;
+  RegexPrefilter filter;
+  std::mt19937 rng(13);
+  int ids[64];
+  long linear = 0, filtered = 0;
+
+  if (!generated.empty()) {
+    unlink(generated.c_str());
+  }
+  REQUIRE(!patterns.empty());
+
+  for (size_t i = 0; i < patterns.size(); ++i) {
+    regexes.emplace_back(new Regex);
+    regexes.back()->compile(patterns[i].c_str(), RE_CASE_INSENSITIVE);
+    filter.add(patterns[i].c_str(), i);
+  }
+  filter.build();
+
+  // Requests for the hosts the rules name, and a quarter that no rule is written for.
+  for (int i = 0; i < 200; ++i) {
+    if (i % 4 == 3) {
+      hosts.push_back("www.unmapped" + std::to_string(rng()) + ".example.com");
+    } else {
+      hosts.push_back("img1" + RegexPrefilter::required_literal(patterns[rng() % patterns.size()].c_str()));
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto const &host : hosts) {
+    for (size_t id = 0; id < regexes.size(); ++id) {
+      if (regexes[id]->exec(host.c_str())) {
+        linear += id;
+        break;
+      }
+    }
+  }
+  auto linear_time = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (auto const &host : hosts) {
+    int n = filter.candidates(host.data(), host.size(), ids, 64);
+    if (n < 0) {
+      for (size_t id = 0; id < regexes.size(); ++id) {
+        if (regexes[id]->exec(host.c_str())) {
+          filtered += id;
+          break;
+        }
+      }
+      continue;
+    }
+    for (int k = 0; k < n; ++k) {
+      if (regexes[ids[k]]->exec(host.c_str())) {
+        filtered += ids[k];
+        break;
+      }
+    }
+  }
+  auto filtered_time = std::chrono::steady_clock::now() - start;
+
+  printf("%s: %zu regex_map rules (%zu filtered), %zu hosts: every rule %.1f us/host, prefiltered %.1f us/host\n", config,
+         patterns.size(), filter.filtered(), hosts.size(), std::chrono::duration<double, std::micro>(linear_time).count() / hosts.size(),
+         std::chrono::duration<double, std::micro>(filtered_time).count() / hosts.size());
+  REQUIRE(linear == filtered);
+}
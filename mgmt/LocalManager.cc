@@ -959,6 +959,17 @@ LocalManager::bindProxyPort(HttpProxyPort &port)
     mgmt_fatal(0, "[bindProxyPort] Unable to set socket options: %d : %s\n", port.m_port, strerror(errno));
   }
 
+#ifdef SO_REUSEPORT
+  {
+    // Let the ET_NET threads of traffic_server open their own sockets on this port.
+    bool found;
+    RecInt listen_per_thread = REC_readInteger("proxy.config.exec_thread.listen", &found);
+    if (found && listen_per_thread > 0 && setsockopt(port.m_fd, SOL_SOCKET, SO_REUSEPORT, (char *)&one, sizeof(int)) < 0) {
+      mgmt_log("[bindProxyPort] Unable to set socket options: %d : %s\n", port.m_port, strerror(errno));
+    }
+  }
+#endif
+
   if (port.m_inbound_transparent_p) {
 #if TS_USE_TPROXY
     Debug("http_tproxy", "Listen port %d inbound transparency enabled.", port.m_port);
@@ -37,12 +37,14 @@
 #include <cctype>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 // Get some specific stuff from libts, yes, we can do that now that we build inside the core.
 #include "ts/ink_platform.h"
 #include "ts/ink_atomic.h"
 #include "ts/ink_time.h"
 #include "ts/ink_inet.h"
+#include "ts/RegexPrefilter.h"
 
 #ifdef HAVE_PCRE_PCRE_H
 #include <pcre/pcre.h>
@@ -53,8 +55,9 @@
 static const char *PLUGIN_NAME = "regex_remap";
 
 // Constants
-static const int OVECCOUNT = 30; // We support $0 - $9 x2 ints, and this needs to be 1.5x that
-static const int MAX_SUBS  = 32; // No more than 32 substitution variables in the subst string
+static const int OVECCOUNT      = 30; // We support $0 - $9 x2 ints, and this needs to be 1.5x that
+static const int MAX_SUBS       = 32; // No more than 32 substitution variables in the subst string
+static const int MAX_CANDIDATES = 64; // More prefilter candidates than this and all the rules are tried
 
 // Substitutions other than regex matches
 enum ExtraSubstitutions {
@@ -651,6 +654,7 @@ struct RemapInstance {
       query_string(true),
       matrix_params(false),
       host(false),
+      prefilter(false),
       hits(0),
       misses(0),
       filename("unknown")
@@ -664,9 +668,14 @@ struct RemapInstance {
   bool query_string;
   bool matrix_params;
   bool host;
+  bool prefilter;
   int hits;
   int misses;
   std::string filename;
+
+  // With the prefilter enabled, the rules in order, indexed by the prefilter
+  std::vector<RemapRegex *> rules;
+  RegexPrefilter rule_filter;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -758,6 +767,10 @@ TSRemapNewInstance(int argc, char *argv[], void **ih, char * /* errbuf ATS_UNUSE
       ri->host = true;
     } else if (strncmp(argv[i], "no-host", 7) == 0) {
       ri->host = false;
+    } else if (strncmp(argv[i], "prefilter", 9) == 0) {
+      ri->prefilter = true;
+    } else if (strncmp(argv[i], "no-prefilter", 12) == 0) {
+      ri->prefilter = false;
     } else {
       TSError("[%s] invalid option '%s'", PLUGIN_NAME, argv[i]);
     }
@@ -876,6 +889,15 @@ TSRemapNewInstance(int argc, char *argv[], void **ih, char * /* errbuf ATS_UNUSE
     return TS_ERROR;
   }
 
+  if (ri->prefilter) {
+    for (RemapRegex *re = ri->first; re; re = re->next()) {
+      ri->rule_filter.add(re->regex(), ri->rules.size());
+      ri->rules.push_back(re);
+    }
+    ri->rule_filter.build();
+    TSDebug(PLUGIN_NAME, "Prefiltering %zu of %zu regular expressions by a literal", ri->rule_filter.filtered(), ri->rules.size());
+  }
+
   return TS_SUCCESS;
 }
 
@@ -956,6 +978,9 @@ TSRemapDoRemap(void *ih, TSHttpTxn txnp, TSRemapRequestInfo *rri)
   TSRemapStatus retval = TSREMAP_DID_REMAP;
   RemapRegex *re       = ri->first;
   int match_len        = 0;
+  int candidates[MAX_CANDIDATES];
+  int n_candidates = -1; // -1 means try every rule
+  int candidate    = 0;
   char *match_buf;
 
   match_buf = (char *)alloca(req_url.url_len + 32);
@@ -1004,6 +1029,15 @@ TSRemapDoRemap(void *ih, TSHttpTxn txnp, TSRemapRequestInfo *rri)
   match_buf[match_len] = '\0'; // NULL terminate the match string
   TSDebug(PLUGIN_NAME, "Target match string is `%s'", match_buf);
 
+  // Only the rules whose required literal is in the match string can match, skip the others
+  if (ri->prefilter) {
+    n_candidates = ri->rule_filter.candidates(match_buf, match_len, candidates, MAX_CANDIDATES);
+    if (n_candidates >= 0) {
+      re = (n_candidates > 0) ? ri->rules[candidates[0]] : nullptr;
+      TSDebug(PLUGIN_NAME, "Prefilter left %d of %zu rules", n_candidates, ri->rules.size());
+    }
+  }
+
   // Apply the regular expressions, in order. First one wins.
   while (re) {
     // Since we check substitutions on parse time, we don't need to reset ovector
@@ -1101,12 +1135,17 @@ TSRemapDoRemap(void *ih, TSHttpTxn txnp, TSRemapRequestInfo *rri)
     }
 
     // Try the next regex
-    re = re->next();
-    if (re == nullptr) {
-      retval = TSREMAP_NO_REMAP; // No match
-      if (ri->profile) {
-        ink_atomic_increment(&(ri->misses), 1);
-      }
+    if (n_candidates >= 0) {
+      re = (++candidate < n_candidates) ? ri->rules[candidates[candidate]] : nullptr;
+    } else {
+      re = re->next();
+    }
+  }
+
+  if (re == nullptr) {
+    retval = TSREMAP_NO_REMAP; // No match
+    if (ri->profile) {
+      ink_atomic_increment(&(ri->misses), 1);
     }
   }
 
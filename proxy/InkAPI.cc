@@ -2750,7 +2750,7 @@ TSMimeHdrFieldFind(TSMBuffer bufp, TSMLoc hdr_obj, const char *name, int length)
   }
 
   MIMEHdrImpl *mh = _hdr_mloc_to_mime_hdr_impl(hdr_obj);
-  MIMEField *f    = mime_hdr_field_find(mh, name, length);
+  MIMEField *f    = mime_hdr_field_find(mh, name, length, ((HdrHeapSDKHandle *)bufp)->m_heap);
 
   if (f == nullptr) {
     return TS_NULL_MLOC;
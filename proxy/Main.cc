@@ -1605,6 +1605,15 @@ main(int /* argc ATS_UNUSED */, const char **argv)
   Debug("hugepages", "ats_pagesize reporting %zu", ats_pagesize());
   Debug("hugepages", "ats_hugepage_size reporting %zu", ats_hugepage_size());
 
+  // The magazines sit in front of the freelists, so unlike malloc they can be
+  // turned on after the freelists have started allocating.
+  if (!cmd_disable_freelist) {
+    REC_ReadConfigInteger(enabled, "proxy.config.allocator.magazines");
+    if (enabled) {
+      ink_freelist_init_ops(ink_freelist_magazine_ops());
+    }
+  }
+
   if (!num_accept_threads) {
     REC_ReadConfigInteger(num_accept_threads, "proxy.config.accept_threads");
   }
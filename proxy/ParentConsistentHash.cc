@@ -22,7 +22,7 @@
  */
 #include "ParentConsistentHash.h"
 
-ParentConsistentHash::ParentConsistentHash(ParentRecord *parent_record)
+ParentConsistentHash::ParentConsistentHash(ParentRecord *parent_record, ParentRR_t round_robin_type)
 {
   int i;
 
@@ -32,24 +32,26 @@ ParentConsistentHash::ParentConsistentHash(ParentRecord *parent_record)
   ignore_query       = parent_record->ignore_query;
   ink_zero(foundParents);
 
-  chash[PRIMARY] = new ATSConsistentHash();
+  chash[PRIMARY] = (round_robin_type == P_MAGLEV_HASH) ? new ATSMaglevHash() : new ATSConsistentHash();
 
   for (i = 0; i < parent_record->num_parents; i++) {
     chash[PRIMARY]->insert(&(parent_record->parents[i]), parent_record->parents[i].weight, (ATSHash64 *)&hash[PRIMARY]);
   }
+  chash[PRIMARY]->build();
 
   if (parent_record->num_secondary_parents > 0) {
     Debug("parent_select", "ParentConsistentHash(): initializing the secondary parents hash.");
-    chash[SECONDARY] = new ATSConsistentHash();
+    chash[SECONDARY] = (round_robin_type == P_MAGLEV_HASH) ? new ATSMaglevHash() : new ATSConsistentHash();
 
     for (i = 0; i < parent_record->num_secondary_parents; i++) {
       chash[SECONDARY]->insert(&(parent_record->secondary_parents[i]), parent_record->secondary_parents[i].weight,
                                (ATSHash64 *)&hash[SECONDARY]);
     }
+    chash[SECONDARY]->build();
   } else {
     chash[SECONDARY] = nullptr;
   }
-  Debug("parent_select", "Using a consistent hash parent selection strategy.");
+  Debug("parent_select", "Using a %s parent selection strategy.", (round_robin_type == P_MAGLEV_HASH) ? "maglev" : "consistent hash");
 }
 
 ParentConsistentHash::~ParentConsistentHash()
@@ -35,7 +35,8 @@
 
 //
 //  Implementation of round robin based upon consistent hash of the URL,
-//  ParentRR_t = P_CONSISTENT_HASH.
+//  ParentRR_t = P_CONSISTENT_HASH, or a Maglev table lookup of the URL hash,
+//  ParentRR_t = P_MAGLEV_HASH.
 //
 class ParentConsistentHash : public ParentSelectionStrategy
 {
@@ -50,7 +51,7 @@ class ParentConsistentHash : public ParentSelectionStrategy
 public:
   static const int PRIMARY   = 0;
   static const int SECONDARY = 1;
-  ParentConsistentHash(ParentRecord *_parent_record);
+  ParentConsistentHash(ParentRecord *_parent_record, ParentRR_t _round_robin_type = P_CONSISTENT_HASH);
   ~ParentConsistentHash();
   uint64_t getPathHash(HttpRequestData *hrdata, ATSHash64 *h);
   void selectParent(bool firstCall, ParentResult *result, RequestData *rdata, unsigned int fail_threshold, unsigned int retry_time);
@@ -591,6 +591,8 @@ ParentRecord::Init(matcher_line *line_info)
         round_robin = P_CONSISTENT_HASH;
       } else if (strcasecmp(val, "latched") == 0) {
         round_robin = P_LATCHED_ROUND_ROBIN;
+      } else if (strcasecmp(val, "maglev") == 0) {
+        round_robin = P_MAGLEV_HASH;
       } else {
         round_robin = P_NO_ROUND_ROBIN;
         errPtr      = "invalid argument to round_robin directive";
@@ -724,8 +726,9 @@ ParentRecord::Init(matcher_line *line_info)
     selection_strategy = new ParentRoundRobin(this, round_robin);
     break;
   case P_CONSISTENT_HASH:
+  case P_MAGLEV_HASH:
     Debug("parent_select", "allocating ParentConsistentHash() lookup strategy.");
-    selection_strategy = new ParentConsistentHash(this);
+    selection_strategy = new ParentConsistentHash(this, round_robin);
     break;
   default:
     ink_release_assert(0);
@@ -1386,6 +1389,34 @@ EXCLUSIVE_REGRESSION_TEST(PARENTSELECTION)(RegressionTest * /* t ATS_UNUSED */,
   sleep(1);
   RE(verify(result, PARENT_SPECIFIED, "fuzzy", 80), 183);
 
+  // Test 184
+  tbl[0] = '\0';
+  ST(184);
+  T("dest_domain=rabbit.net parent=fuzzy:80|1.0 secondary_parent=furry:80|1.0 round_robin=maglev go_direct=false\n");
+  REBUILD;
+  REINIT;
+  br(request, "i.am.rabbit.net");
+  FP;
+  RE(verify(result, PARENT_SPECIFIED, "fuzzy", 80), 184);
+
+  params->markParentDown(result, fail_threshold, retry_time); // fuzzy is down.
+
+  // Test 185
+  ST(185);
+  REINIT;
+  br(request, "i.am.rabbit.net");
+  FP;
+  RE(verify(result, PARENT_SPECIFIED, "furry", 80), 185);
+
+  params->markParentDown(result, fail_threshold, retry_time); // all are down now.
+
+  // Test 186
+  ST(186);
+  REINIT;
+  br(request, "i.am.rabbit.net");
+  FP;
+  RE(verify(result, PARENT_FAIL, nullptr, 80), 186);
+
   delete request;
   delete result;
   delete params;
@@ -66,6 +66,7 @@ enum ParentRR_t {
   P_HASH_ROUND_ROBIN,
   P_CONSISTENT_HASH,
   P_LATCHED_ROUND_ROBIN,
+  P_MAGLEV_HASH,
 };
 
 enum ParentRetry_t {
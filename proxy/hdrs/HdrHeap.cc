@@ -778,7 +778,9 @@ HdrHeap::marshal(char *buf, int len)
           ink_assert(0);
           goto Failed;
         }
-        // Nothing to do
+        // Raw objects are scratch space (e.g. the MIME field index)
+        //   that doesn't survive marshalling
+        obj->m_type = HDR_HEAP_OBJ_EMPTY;
         break;
       default:
         ink_release_assert(0);
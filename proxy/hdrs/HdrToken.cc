@@ -22,7 +22,6 @@
  */
 
 #include "ts/ink_platform.h"
-#include "ts/HashFNV.h"
 #include "ts/Diags.h"
 #include "ts/ink_memory.h"
 #include <cstdio>
@@ -254,38 +253,52 @@ DFA *hdrtoken_strs_dfa = nullptr;
 
 /***********************************************************************
  *                                                                     *
- *                        H A S H    T A B L E                         *
+ *                     P E R F E C T    H A S H                        *
  *                                                                     *
  ***********************************************************************/
 
-#define HDRTOKEN_HASH_TABLE_SIZE 65536
-#define HDRTOKEN_HASH_TABLE_MASK HDRTOKEN_HASH_TABLE_SIZE - 1
+// The commonly tokenized strings are bucketed by length. The strings of each length get their
+// own power of 2 range of hdrtoken_hash_table and a seed that hashes them to distinct slots in
+// it, so a lookup hashes the string once and compares it to at most one well-known string.
 
-struct HdrTokenHashBucket {
-  const char *wks;
-  uint32_t hash;
+#define HDRTOKEN_MAX_LENGTH 32
+#define HDRTOKEN_HASH_TABLE_SIZE 512
+
+struct HdrTokenLengthBucket {
+  uint32_t seed;
+  uint16_t offset; // first slot of this length in hdrtoken_hash_table
+  uint16_t mask;   // number of slots - 1
 };
 
-HdrTokenHashBucket hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE];
+// Lengths without strings use slot 0, which is always empty.
+static HdrTokenLengthBucket hdrtoken_length_buckets[HDRTOKEN_MAX_LENGTH + 1];
+static int16_t hdrtoken_hash_table[HDRTOKEN_HASH_TABLE_SIZE]; // slot -> wks_idx, -1 if empty
 
 /**
-  basic FNV hash
+  Multiplicative hash over 8 bytes at a time. Setting bit 0x20 of every byte lowercases the
+  letters, the strings are compared case insensitively afterwards anyway.
 **/
-#define TINY_MASK(x) (((uint32_t)1 << (x)) - 1)
-
-inline uint32_t
-hash_to_slot(uint32_t hash)
+static inline uint32_t
+hdrtoken_hash(const char *string, int length, uint32_t seed)
 {
-  return ((hash >> 15) ^ hash) & TINY_MASK(15);
-}
+  const uint64_t fold = 0x2020202020202020ULL;
+  const uint64_t mult = 0x9E3779B97F4A7C15ULL;
+  uint64_t h          = seed;
+  uint64_t w;
+
+  while (length >= 8) {
+    memcpy(&w, string, 8);
+    h = (h ^ (w | fold)) * mult;
+    string += 8;
+    length -= 8;
+  }
+  if (length > 0) {
+    w = 0;
+    memcpy(&w, string, length);
+    h = (h ^ (w | (fold >> (64 - 8 * length)))) * mult;
+  }
 
-inline uint32_t
-hdrtoken_hash(const unsigned char *string, unsigned int length)
-{
-  ATSHash32FNV1a fnv;
-  fnv.update(string, length, ATSHash::nocase());
-  fnv.final();
-  return fnv.get();
+  return h >> 32;
 }
 
 /*-------------------------------------------------------------------------
@@ -360,33 +373,62 @@ static const char *_hdrtoken_commonly_tokenized_strs[] = {
 void
 hdrtoken_hash_init()
 {
-  uint32_t i;
-  int num_collisions;
+  int by_length[HDRTOKEN_MAX_LENGTH + 1][SIZEOF(_hdrtoken_commonly_tokenized_strs)];
+  int count[HDRTOKEN_MAX_LENGTH + 1] = {0};
+  uint32_t used                      = 1; // slot 0 stays empty
 
-  memset(hdrtoken_hash_table, 0, sizeof(hdrtoken_hash_table));
-  num_collisions = 0;
+  for (int16_t &slot : hdrtoken_hash_table) {
+    slot = -1;
+  }
+  memset(hdrtoken_length_buckets, 0, sizeof(hdrtoken_length_buckets));
 
-  for (i = 0; i < (int)SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
+  for (unsigned i = 0; i < SIZEOF(_hdrtoken_commonly_tokenized_strs); i++) {
     // convert the common string to the well-known token
-    unsigned const char *wks;
-    int wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_commonly_tokenized_strs[i], (int)strlen(_hdrtoken_commonly_tokenized_strs[i]),
-                                        (const char **)&wks);
+    int wks_idx = hdrtoken_tokenize_dfa(_hdrtoken_commonly_tokenized_strs[i], (int)strlen(_hdrtoken_commonly_tokenized_strs[i]));
     ink_release_assert(wks_idx >= 0);
 
-    uint32_t hash = hdrtoken_hash(wks, hdrtoken_str_lengths[wks_idx]);
-    uint32_t slot = hash_to_slot(hash);
+    int length = hdrtoken_str_lengths[wks_idx];
+    ink_release_assert(length <= HDRTOKEN_MAX_LENGTH);
+    by_length[length][count[length]++] = wks_idx;
+  }
 
-    if (hdrtoken_hash_table[slot].wks) {
-      printf("ERROR: hdrtoken_hash_table[%u] collision: '%s' replacing '%s'\n", slot, (const char *)wks,
-             hdrtoken_hash_table[slot].wks);
-      ++num_collisions;
+  for (int length = 0; length <= HDRTOKEN_MAX_LENGTH; length++) {
+    if (count[length] == 0) {
+      continue;
     }
-    hdrtoken_hash_table[slot].wks  = (const char *)wks;
-    hdrtoken_hash_table[slot].hash = hash;
-  }
 
-  if (num_collisions > 0) {
-    abort();
+    uint32_t size = 1;
+    while (size < (uint32_t)count[length]) {
+      size *= 2;
+    }
+    ink_release_assert(used + size <= HDRTOKEN_HASH_TABLE_SIZE);
+
+    HdrTokenLengthBucket &bucket = hdrtoken_length_buckets[length];
+    bucket.offset                = used;
+    bucket.mask                  = size - 1;
+
+    // Try seeds until every string of this length gets a slot of its own.
+    for (bucket.seed = 1;; bucket.seed++) {
+      int i;
+      for (i = 0; i < count[length]; i++) {
+        int wks_idx   = by_length[length][i];
+        int16_t &slot = hdrtoken_hash_table[used + (hdrtoken_hash(hdrtoken_strs[wks_idx], length, bucket.seed) & bucket.mask)];
+        if (slot >= 0) {
+          break;
+        }
+        slot = wks_idx;
+      }
+      if (i == count[length]) {
+        break;
+      }
+
+      for (uint32_t s = used; s < used + size; s++) {
+        hdrtoken_hash_table[s] = -1;
+      }
+      ink_release_assert(bucket.seed < (1u << 24));
+    }
+
+    used += size;
   }
 }
 
@@ -539,7 +581,6 @@ int
 hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_out)
 {
   int wks_idx;
-  HdrTokenHashBucket *bucket;
 
   ink_assert(string != nullptr);
 
@@ -551,16 +592,16 @@ hdrtoken_tokenize(const char *string, int string_len, const char **wks_string_ou
     return wks_idx;
   }
 
-  uint32_t hash = hdrtoken_hash((const unsigned char *)string, (unsigned int)string_len);
-  uint32_t slot = hash_to_slot(hash);
+  if (string_len >= 0 && string_len <= HDRTOKEN_MAX_LENGTH) {
+    const HdrTokenLengthBucket &bucket = hdrtoken_length_buckets[string_len];
 
-  bucket = &(hdrtoken_hash_table[slot]);
-  if ((bucket->wks != nullptr) && (bucket->hash == hash) && (hdrtoken_wks_to_length(bucket->wks) == string_len)) {
-    wks_idx = hdrtoken_wks_to_index(bucket->wks);
-    if (wks_string_out) {
-      *wks_string_out = bucket->wks;
+    wks_idx = hdrtoken_hash_table[bucket.offset + (hdrtoken_hash(string, string_len, bucket.seed) & bucket.mask)];
+    if (wks_idx >= 0 && strncasecmp(string, hdrtoken_strs[wks_idx], string_len) == 0) {
+      if (wks_string_out) {
+        *wks_string_out = hdrtoken_strs[wks_idx];
+      }
+      return wks_idx;
     }
-    return wks_idx;
   }
 
   Debug("hdr_token", "Did not find a WKS for '%.*s'", string_len, string);
@@ -28,6 +28,9 @@
 #include <cassert>
 #include <cstdio>
 #include <cstring>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include "MIME.h"
 #include "HdrHeap.h"
 #include "HdrToken.h"
@@ -535,6 +538,236 @@ mime_hdr_reset_accelerators_and_presence_bits(MIMEHdrImpl *mh)
   }
 }
 
+/***********************************************************************
+ *                                                                     *
+ *                   F I E L D    L O O K U P    I N D E X             *
+ *                                                                     *
+ ***********************************************************************/
+
+// Headers too big for the inline field block get a hash table from field
+// name to dup head, so lookups the presence bits and slot accelerators can't
+// answer don't have to walk every field.  The table is a raw object in the
+// header's heap found through the self relative offset in m_field_index.  It
+// is built lazily by the first lookup that passes a writable heap, kept up to
+// date by attach and detach, and never marshalled or copied: the offset is
+// cleared whenever the header is marshalled, unmarshalled or copied onto.
+// A header whose index can't be built is marked MIME_FIELD_INDEX_UNBUILDABLE
+// so lookups don't retry the build every time, until a name is removed.
+
+struct MIMEFieldIndexEntry {
+  uint16_t m_slot; // slot number + 1 of the dup head, 0 if the entry is empty
+  uint16_t m_hash; // low bits of the name hash
+};
+
+struct MIMEFieldIndex : public HdrHeapObjImpl {
+  uint16_t m_mask;  // number of entries - 1
+  uint16_t m_count; // number of entries in use
+  MIMEFieldIndexEntry m_entries[1];
+};
+
+static inline uint32_t
+mime_field_index_hash(const char *name, int length)
+{
+  uint32_t hash = 2166136261U;
+
+  // Field names are tokens, so folding 0x20 in is enough to make this case insensitive.
+  for (int i = 0; i < length; ++i) {
+    hash = (hash ^ (name[i] | 0x20)) * 16777619U;
+  }
+  return hash ^ (hash >> 16);
+}
+
+static inline MIMEFieldIndex *
+mime_hdr_field_index_get(MIMEHdrImpl *mh)
+{
+  if (mh->m_field_index == 0 || mh->m_field_index == MIME_FIELD_INDEX_UNBUILDABLE) {
+    return nullptr;
+  }
+  return reinterpret_cast<MIMEFieldIndex *>(reinterpret_cast<char *>(mh) + mh->m_field_index);
+}
+
+// Free the index of @a mh, if it has one, so its heap space isn't leaked.  Attach and detach
+// don't get the heap, and all HdrHeap::deallocate_obj does is mark the object empty, so do
+// the same here when @a heap is null.  Also forgets that the index couldn't be built.
+static void
+mime_hdr_field_index_drop(MIMEHdrImpl *mh, HdrHeap *heap = nullptr)
+{
+  MIMEFieldIndex *index = mime_hdr_field_index_get(mh);
+
+  if (index) {
+    if (heap) {
+      heap->deallocate_obj(index);
+    } else {
+      index->m_type = HDR_HEAP_OBJ_EMPTY;
+    }
+  }
+  mh->m_field_index = 0;
+}
+
+static void
+mime_field_index_insert(MIMEFieldIndex *index, int slotnum, uint32_t hash)
+{
+  uint32_t i = hash & index->m_mask;
+
+  while (index->m_entries[i].m_slot) {
+    i = (i + 1) & index->m_mask;
+  }
+  index->m_entries[i].m_slot = slotnum + 1;
+  index->m_entries[i].m_hash = hash;
+  ++index->m_count;
+}
+
+static MIMEFieldIndexEntry *
+mime_field_index_entry(MIMEHdrImpl *mh, MIMEFieldIndex *index, MIMEField *field)
+{
+  uint32_t hash = mime_field_index_hash(field->m_ptr_name, field->m_len_name);
+  int slotnum   = mime_hdr_field_slotnum(mh, field);
+
+  for (uint32_t i = hash & index->m_mask; index->m_entries[i].m_slot; i = (i + 1) & index->m_mask) {
+    if (index->m_entries[i].m_slot == slotnum + 1) {
+      return &index->m_entries[i];
+    }
+  }
+  return nullptr;
+}
+
+// Build the index for a header with more fields than the inline block holds, or mark the header
+// MIME_FIELD_INDEX_UNBUILDABLE if it doesn't fit.
+static MIMEFieldIndex *
+mime_hdr_field_index_build(HdrHeap *heap, MIMEHdrImpl *mh)
+{
+  MIMEFieldIndex *index;
+  int count = 0, slots = 0;
+  uint32_t size;
+
+  for (MIMEFieldBlockImpl *fblock = &(mh->m_first_fblock); fblock != nullptr; fblock = fblock->m_next) {
+    for (MIMEField *field = fblock->m_field_slots, *limit = field + fblock->m_freetop; field < limit; ++field) {
+      count += field->is_live() && field->is_dup_head();
+    }
+    slots += MIME_FIELD_BLOCK_SLOTS;
+  }
+
+  // Keep the table at most half full, and give up if it won't fit in a single heap allocation.
+  for (size = MIME_FIELD_BLOCK_SLOTS * 2; size < (uint32_t)count * 2; size *= 2) {
+  }
+  if (slots >= UINT16_MAX || sizeof(MIMEFieldIndex) + (size - 1) * sizeof(MIMEFieldIndexEntry) > HDR_MAX_ALLOC_SIZE) {
+    mh->m_field_index = MIME_FIELD_INDEX_UNBUILDABLE;
+    return nullptr;
+  }
+
+  index = (MIMEFieldIndex *)heap->allocate_obj(sizeof(MIMEFieldIndex) + (size - 1) * sizeof(MIMEFieldIndexEntry), HDR_HEAP_OBJ_RAW);
+  ptrdiff_t offset = reinterpret_cast<char *>(index) - reinterpret_cast<char *>(mh);
+  if (offset != static_cast<int32_t>(offset)) {
+    heap->deallocate_obj(index);
+    mh->m_field_index = MIME_FIELD_INDEX_UNBUILDABLE;
+    return nullptr;
+  }
+
+  index->m_mask  = size - 1;
+  index->m_count = 0;
+  memset(index->m_entries, 0, size * sizeof(MIMEFieldIndexEntry));
+
+  slots = 0;
+  for (MIMEFieldBlockImpl *fblock = &(mh->m_first_fblock); fblock != nullptr; fblock = fblock->m_next) {
+    for (unsigned int i = 0; i < fblock->m_freetop; ++i) {
+      MIMEField *field = &(fblock->m_field_slots[i]);
+      if (field->is_live() && field->is_dup_head()) {
+        mime_field_index_insert(index, slots + i, mime_field_index_hash(field->m_ptr_name, field->m_len_name));
+      }
+    }
+    slots += MIME_FIELD_BLOCK_SLOTS;
+  }
+
+  mh->m_field_index = offset;
+  return index;
+}
+
+static MIMEField *
+mime_hdr_field_index_find(MIMEHdrImpl *mh, MIMEFieldIndex *index, const char *field_name_str, int field_name_len, int wks_idx)
+{
+  uint32_t hash = mime_field_index_hash(field_name_str, field_name_len);
+
+  for (uint32_t i = hash & index->m_mask; index->m_entries[i].m_slot; i = (i + 1) & index->m_mask) {
+    if (index->m_entries[i].m_hash == static_cast<uint16_t>(hash)) {
+      MIMEField *field = _mime_hdr_field_list_search_by_slotnum(mh, index->m_entries[i].m_slot - 1);
+      if (wks_idx >= 0) {
+        if (field->m_wks_idx == wks_idx) {
+          return field;
+        }
+      } else if (field->m_len_name == field_name_len && strncasecmp(field->m_ptr_name, field_name_str, field_name_len) == 0) {
+        return field;
+      }
+    }
+  }
+  return nullptr;
+}
+
+// The index of @a mh, built first if the header is big enough and @a heap allows it.
+static inline MIMEFieldIndex *
+mime_hdr_field_index_for_lookup(MIMEHdrImpl *mh, HdrHeap *heap)
+{
+  MIMEFieldIndex *index = mime_hdr_field_index_get(mh);
+
+  if (index == nullptr && mh->m_field_index == 0 && heap && heap->m_writeable && mh->m_first_fblock.m_next) {
+    index = mime_hdr_field_index_build(heap, mh);
+  }
+  return index;
+}
+
+// @a field became the dup head of a name that wasn't in the header before.
+static void
+mime_hdr_field_index_add(MIMEHdrImpl *mh, MIMEField *field)
+{
+  MIMEFieldIndex *index = mime_hdr_field_index_get(mh);
+  int slotnum;
+
+  if (index) {
+    slotnum = mime_hdr_field_slotnum(mh, field);
+    // Past three quarters full, or out of slot numbers, drop the index and let the next lookup build a bigger one.
+    if ((index->m_count + 1) * 4 > (index->m_mask + 1) * 3 || slotnum >= UINT16_MAX - 1) {
+      mime_hdr_field_index_drop(mh);
+    } else {
+      mime_field_index_insert(index, slotnum, mime_field_index_hash(field->m_ptr_name, field->m_len_name));
+    }
+  }
+}
+
+// The dup head @a field was replaced by @a new_head, or removed if that is null.
+static void
+mime_hdr_field_index_replace(MIMEHdrImpl *mh, MIMEField *field, MIMEField *new_head)
+{
+  MIMEFieldIndex *index = mime_hdr_field_index_get(mh);
+  MIMEFieldIndexEntry *entry;
+
+  if (index == nullptr) {
+    // With a name gone the index may fit now.
+    if (new_head == nullptr) {
+      mh->m_field_index = 0;
+    }
+    return;
+  }
+  entry = mime_field_index_entry(mh, index, field);
+  ink_assert(entry != nullptr);
+  if (entry == nullptr) {
+    mime_hdr_field_index_drop(mh);
+  } else if (new_head) {
+    entry->m_slot = mime_hdr_field_slotnum(mh, new_head) + 1;
+  } else {
+    // Shift the following entries back into the hole so no probe sequence is cut short.
+    uint32_t hole = entry - index->m_entries;
+
+    for (uint32_t i = (hole + 1) & index->m_mask; index->m_entries[i].m_slot; i = (i + 1) & index->m_mask) {
+      uint32_t home = index->m_entries[i].m_hash & index->m_mask;
+      if (((i - home) & index->m_mask) >= ((i - hole) & index->m_mask)) {
+        index->m_entries[hole] = index->m_entries[i];
+        hole                   = i;
+      }
+    }
+    index->m_entries[hole].m_slot = 0;
+    --index->m_count;
+  }
+}
+
 int
 checksum_block(const char *s, int len)
 {
@@ -1036,6 +1269,7 @@ mime_hdr_cooked_stuff_init(MIMEHdrImpl *mh, MIMEField *changing_field_or_null)
 void
 mime_hdr_init(MIMEHdrImpl *mh)
 {
+  mh->m_field_index = 0;
   mime_hdr_init_accelerators_and_presence_bits(mh);
 
   mime_hdr_cooked_stuff_init(mh, nullptr);
@@ -1081,6 +1315,7 @@ void
 mime_hdr_destroy(HdrHeap *heap, MIMEHdrImpl *mh)
 {
   mime_hdr_destroy_field_block_list(heap, mh->m_first_fblock.m_next);
+  mime_hdr_field_index_drop(mh, heap);
 
   // INKqa11458: if we deallocate mh here and call TSMLocRelease
   // again, the plugin fails in assert. We leave deallocating to
@@ -1102,6 +1337,7 @@ mime_hdr_copy_onto(MIMEHdrImpl *s_mh, HdrHeap *s_heap, MIMEHdrImpl *d_mh, HdrHea
   if (d_mh->m_first_fblock.m_next) {
     mime_hdr_destroy_field_block_list(d_heap, d_mh->m_first_fblock.m_next);
   }
+  mime_hdr_field_index_drop(d_mh, d_heap);
 
   ink_assert(((char *)&(s_mh->m_first_fblock.m_field_slots[MIME_FIELD_BLOCK_SLOTS]) - (char *)s_mh) == sizeof(struct MIMEHdrImpl));
 
@@ -1111,6 +1347,7 @@ mime_hdr_copy_onto(MIMEHdrImpl *s_mh, HdrHeap *s_heap, MIMEHdrImpl *d_mh, HdrHea
 
   // copies useful part of enclosed first block too
   memcpy(d_mh, s_mh, bytes_below_top);
+  d_mh->m_field_index = 0; // the index stays with the source heap
 
   if (d_mh->m_first_fblock.m_next == nullptr) // common case: no other block
   {
@@ -1213,6 +1450,7 @@ void
 mime_hdr_fields_clear(HdrHeap *heap, MIMEHdrImpl *mh)
 {
   mime_hdr_destroy_field_block_list(heap, mh->m_first_fblock.m_next);
+  mime_hdr_field_index_drop(mh, heap);
   mime_hdr_init(mh);
 }
 
@@ -1293,13 +1531,20 @@ _mime_hdr_field_list_search_by_slotnum(MIMEHdrImpl *mh, int slotnum)
 }
 
 MIMEField *
-mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len)
+mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len, HdrHeap *heap)
 {
   HdrTokenHeapPrefix *token_info;
-  const bool is_wks = hdrtoken_is_wks(field_name_str);
+  MIMEFieldIndex *index;
+  bool is_wks = hdrtoken_is_wks(field_name_str);
 
   ink_assert(field_name_len >= 0);
 
+  // A name passed as a plain string can still be a well-known one, and then the presence bits
+  // and slot accelerators answer without comparing it to every field.
+  if (!is_wks) {
+    is_wks = hdrtoken_tokenize(field_name_str, field_name_len, &field_name_str) >= 0;
+  }
+
 ////////////////////////////////////////////
 // do presence check and slot accelerator //
 ////////////////////////////////////////////
@@ -1341,7 +1586,12 @@ mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_
     // search by well-known string index or by case-insensitive string match //
     ///////////////////////////////////////////////////////////////////////////
 
-    MIMEField *f = _mime_hdr_field_list_search_by_wks(mh, token_info->wks_idx);
+    MIMEField *f;
+    if ((index = mime_hdr_field_index_for_lookup(mh, heap)) != nullptr) {
+      f = mime_hdr_field_index_find(mh, index, field_name_str, field_name_len, token_info->wks_idx);
+    } else {
+      f = _mime_hdr_field_list_search_by_wks(mh, token_info->wks_idx);
+    }
     ink_assert((f == nullptr) || f->is_live());
 #if TRACK_FIELD_FIND_CALLS
     Debug("http", "mime_hdr_field_find(hdr 0x%X, field %.*s): %s (due to WKS list walk)", mh, field_name_len, field_name_str,
@@ -1349,7 +1599,12 @@ mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_
 #endif
     return f;
   } else {
-    MIMEField *f = _mime_hdr_field_list_search_by_string(mh, field_name_str, field_name_len);
+    MIMEField *f;
+    if ((index = mime_hdr_field_index_for_lookup(mh, heap)) != nullptr) {
+      f = mime_hdr_field_index_find(mh, index, field_name_str, field_name_len, -1);
+    } else {
+      f = _mime_hdr_field_list_search_by_string(mh, field_name_str, field_name_len);
+    }
 
     ink_assert((f == nullptr) || f->is_live());
 #if TRACK_FIELD_FIND_CALLS
@@ -1472,7 +1727,10 @@ mime_hdr_field_attach(MIMEHdrImpl *mh, MIMEField *field, int check_for_dups, MIM
   if (check_for_dups || (prev_dup && (!prev_dup->is_dup_head()))) {
     int length;
     const char *name = mime_field_name_get(field, &length);
-    prev_dup         = mime_hdr_field_find(mh, name, length);
+    if (field->m_wks_idx >= 0) {
+      name = hdrtoken_index_to_wks(field->m_wks_idx); // already tokenized, e.g. by the parser
+    }
+    prev_dup = mime_hdr_field_find(mh, name, length);
     ink_assert((prev_dup == nullptr) || (prev_dup->is_dup_head()));
   }
 
@@ -1533,6 +1791,7 @@ mime_hdr_field_attach(MIMEHdrImpl *mh, MIMEField *field, int check_for_dups, MIM
       field->m_next_dup = prev_dup;
       prev_dup->m_flags = (prev_dup->m_flags & ~MIME_FIELD_SLOT_FLAGS_DUP_HEAD);
       mime_hdr_set_accelerators_and_presence_bits(mh, field);
+      mime_hdr_field_index_replace(mh, prev_dup, field);
     } else // patch us after prev, and before next
     {
       ink_assert(prev_slotnum < field_slotnum);
@@ -1545,6 +1804,7 @@ mime_hdr_field_attach(MIMEHdrImpl *mh, MIMEField *field, int check_for_dups, MIM
   } else {
     field->m_flags = (field->m_flags | MIME_FIELD_SLOT_FLAGS_DUP_HEAD);
     mime_hdr_set_accelerators_and_presence_bits(mh, field);
+    mime_hdr_field_index_add(mh, field);
   }
 
   // Now keep the cooked cache consistent
@@ -1587,6 +1847,7 @@ mime_hdr_field_detach(MIMEHdrImpl *mh, MIMEField *field, bool detach_all_dups)
       next_dup->m_flags |= MIME_FIELD_SLOT_FLAGS_DUP_HEAD;
       mime_hdr_set_accelerators_and_presence_bits(mh, next_dup);
     }
+    mime_hdr_field_index_replace(mh, field, next_dup);
   } else // need to walk list to find and patch out from predecessor
   {
     int name_length;
@@ -1739,6 +2000,7 @@ mime_field_name_set(HdrHeap *heap, MIMEHdrImpl * /* mh ATS_UNUSED */, MIMEField
 
   field->m_wks_idx = name_wks_idx_or_neg1;
   mime_str_u16_set(heap, name, length, &(field->m_ptr_name), &(field->m_len_name), must_copy_string);
+  field->m_n_v_raw_printable = 0;
 
   if ((name_wks_idx_or_neg1 == MIME_WKSIDX_CACHE_CONTROL) || (name_wks_idx_or_neg1 == MIME_WKSIDX_PRAGMA)) {
     field->m_flags |= MIME_FIELD_SLOT_FLAGS_COOKED;
@@ -2366,6 +2628,59 @@ mime_scanner_append(MIMEScanner *scanner, const char *data, int data_size)
   scanner->m_line_length += data_size;
 }
 
+// Find the first LF in [s, e), setting @a nul if there is a '\0' before it. Every byte of a
+// header goes through here, so look at 32 or 16 bytes at a time when AVX2 or SSE2 is available.
+// The ':' is not searched here as well: it is nearly always in the first few bytes of the line,
+// so the parser's memchr for it is cheaper than a third compare on every block of every line.
+static inline const char *
+mime_scan_line(const char *s, const char *e, bool *nul)
+{
+#if defined(__AVX2__)
+  const __m256i lf32   = _mm256_set1_epi8(ParseRules::CHAR_LF);
+  const __m256i zero32 = _mm256_setzero_si256();
+
+  while (e - s >= 32) {
+    __m256i v         = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s));
+    uint32_t lf_mask  = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf32));
+    uint32_t nul_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero32));
+
+    if (lf_mask) {
+      int i = __builtin_ctz(lf_mask);
+      *nul |= (nul_mask & ((1u << i) - 1)) != 0;
+      return s + i;
+    }
+    *nul |= nul_mask != 0;
+    s += 32;
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i lf   = _mm_set1_epi8(ParseRules::CHAR_LF);
+  const __m128i zero = _mm_setzero_si128();
+
+  while (e - s >= 16) {
+    __m128i v         = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+    uint32_t lf_mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(v, lf));
+    uint32_t nul_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+
+    if (lf_mask) {
+      int i = __builtin_ctz(lf_mask);
+      *nul |= (nul_mask & ((1u << i) - 1)) != 0;
+      return s + i;
+    }
+    *nul |= nul_mask != 0;
+    s += 16;
+  }
+#endif
+
+  for (; s < e; ++s) {
+    if (ParseRules::is_lf(*s)) {
+      return s;
+    }
+    *nul |= *s == '\0';
+  }
+  return nullptr;
+}
+
 ParseResult
 mime_scanner_get(MIMEScanner *S, const char **raw_input_s, const char *raw_input_e, const char **output_s, const char **output_e,
                  bool *output_shares_raw_input,
@@ -2374,6 +2689,7 @@ mime_scanner_get(MIMEScanner *S, const char **raw_input_s, const char *raw_input
 {
   const char *raw_input_c, *lf_ptr;
   ParseResult zret = PARSE_RESULT_CONT;
+  bool nul         = false;
   // Need this for handling dangling CR.
   static const char RAW_CR = ParseRules::CHAR_CR;
 
@@ -2419,7 +2735,7 @@ mime_scanner_get(MIMEScanner *S, const char **raw_input_s, const char *raw_input
       }
       break;
     case MIME_PARSE_INSIDE:
-      lf_ptr = static_cast<const char *>(memchr(raw_input_c, ParseRules::CHAR_LF, runway));
+      lf_ptr = mime_scan_line(raw_input_c, raw_input_e, &nul);
       if (lf_ptr) {
         raw_input_c = lf_ptr + 1;
         if (MIME_SCANNER_TYPE_LINE == raw_input_scan_type) {
@@ -2504,8 +2820,9 @@ mime_scanner_get(MIMEScanner *S, const char **raw_input_s, const char *raw_input
     }
   }
 
-  // Make sure there are no '\0' in the input scanned so far
-  if (zret != PARSE_RESULT_ERROR && memchr(*raw_input_s, '\0', raw_input_c - *raw_input_s) != nullptr) {
+  // Make sure there are no '\0' in the input scanned so far. The other states only consume CR and LF,
+  // so the line scan has seen every other byte.
+  if (zret != PARSE_RESULT_ERROR && nul) {
     zret = PARSE_RESULT_ERROR;
   }
 
@@ -2724,48 +3041,46 @@ mime_hdr_print(HdrHeap * /* heap ATS_UNUSED */, MIMEHdrImpl *mh, char *buf_start
   MIMEField *field;
   uint32_t index;
 
-#define SIMPLE_MIME_HDR_PRINT
-#ifdef SIMPLE_MIME_HDR_PRINT
+  // Fields that haven't changed since they were parsed are printed from the original bytes, and a
+  // run of them that still sits back to back in the string heap (like most of a cached response)
+  // goes out in one copy.  Only the fields added or changed since break the run.
+  const char *run_start = nullptr;
+  int run_length        = 0;
+
   for (fblock = &(mh->m_first_fblock); fblock != nullptr; fblock = fblock->m_next) {
     for (index = 0; index < fblock->m_freetop; index++) {
       field = &(fblock->m_field_slots[index]);
-      if (field->is_live()) {
+      if (!field->is_live()) {
+        continue;
+      }
+      if (field->m_n_v_raw_printable && field->m_ptr_name[0] != '@') {
+        int length = field->m_len_name + field->m_len_value + field->m_n_v_raw_printable_pad;
+        if (run_length > 0 && field->m_ptr_name == run_start + run_length) {
+          run_length += length;
+          continue;
+        }
+        if (run_length > 0 &&
+            !mime_mem_print(run_start, run_length, buf_start, buf_length, buf_index_inout, buf_chars_to_skip_inout)) {
+          return 0;
+        }
+        run_start  = field->m_ptr_name;
+        run_length = length;
+      } else {
+        if (run_length > 0 &&
+            !mime_mem_print(run_start, run_length, buf_start, buf_length, buf_index_inout, buf_chars_to_skip_inout)) {
+          return 0;
+        }
+        run_length = 0;
         if (!mime_field_print(field, buf_start, buf_length, buf_index_inout, buf_chars_to_skip_inout)) {
           return 0;
         }
       }
     }
   }
-#else
-  // FIX: if not raw_printable, need to print with mime_field_print,
-  //      not mime_mem_print
-  for (fblock = &(mh->m_first_fblock); fblock != NULL; fblock = fblock->m_next) {
-    const char *contig_start = NULL;
-    int this_length, contig_length = 0;
-    for (index = 0; index < fblock->m_freetop; index++) {
-      field       = &(fblock->m_field_slots[index]);
-      this_length = field->m_len_name + field->m_len_value + field->m_n_v_raw_printable_pad;
-      if (field->is_live()) {
-        if ((field->m_ptr_name == contig_start + contig_length) && field->m_n_v_raw_printable &&
-            ((buf_index_inout == NULL) || (contig_length + this_length <= buf_length - *buf_index_inout))) {
-          contig_length += this_length;
-        } else {
-          if (contig_length > 0) {
-            if (!mime_mem_print(contig_start, contig_length, buf_start, buf_length, buf_index_inout, buf_chars_to_skip_inout))
-              return 0;
-          }
-          contig_start  = field->m_ptr_name;
-          contig_length = this_length;
-        }
-      }
-    }
 
-    if (contig_length > 0) {
-      if (!mime_mem_print(contig_start, contig_length, buf_start, buf_length, buf_index_inout, buf_chars_to_skip_inout))
-        return 0;
-    }
+  if (run_length > 0 && !mime_mem_print(run_start, run_length, buf_start, buf_length, buf_index_inout, buf_chars_to_skip_inout)) {
+    return 0;
   }
-#endif
 
   if (!mime_mem_print("\r\n", 2, buf_start, buf_length, buf_index_inout, buf_chars_to_skip_inout)) {
     return 0;
@@ -3689,12 +4004,22 @@ MIMEFieldBlockImpl::move_strings(HdrStrHeap *new_heap)
     MIMEField *field = &(m_field_slots[index]);
 
     if (field->is_live() || field->is_detached()) {
-      // FIX ME - Should do the field in one shot and preserve
-      //   raw_printable if it's set
-      field->m_n_v_raw_printable = 0;
+      int length = field->m_len_name + field->m_len_value + field->m_n_v_raw_printable_pad;
+
+      // Move a raw printable field in one piece so it stays raw printable, and next to
+      //   the raw printable fields moved before and after it.
+      if (field->m_n_v_raw_printable && field->m_ptr_value >= field->m_ptr_name &&
+          field->m_ptr_value + field->m_len_value <= field->m_ptr_name + length) {
+        ptrdiff_t value_offset = field->m_ptr_value - field->m_ptr_name;
 
-      HDR_MOVE_STR(field->m_ptr_name, field->m_len_name);
-      HDR_MOVE_STR(field->m_ptr_value, field->m_len_value);
+        HDR_MOVE_STR(field->m_ptr_name, length);
+        field->m_ptr_value = field->m_ptr_name ? field->m_ptr_name + value_offset : nullptr;
+      } else {
+        field->m_n_v_raw_printable = 0;
+
+        HDR_MOVE_STR(field->m_ptr_name, field->m_len_name);
+        HDR_MOVE_STR(field->m_ptr_value, field->m_len_value);
+      }
     }
   }
 }
@@ -3710,6 +4035,9 @@ MIMEFieldBlockImpl::strings_length()
     if (field->m_readiness == MIME_FIELD_SLOT_READINESS_LIVE || field->m_readiness == MIME_FIELD_SLOT_READINESS_DETACHED) {
       ret += field->m_len_name;
       ret += field->m_len_value;
+      if (field->m_n_v_raw_printable) {
+        ret += field->m_n_v_raw_printable_pad; // moved along with the name and value
+      }
     }
   }
   return ret;
@@ -3742,6 +4070,7 @@ MIMEHdrImpl::marshal(MarshalXlate *ptr_xlate, int num_ptr, MarshalXlate *str_xla
 {
   // printf("MIMEHdrImpl:marshal  num_ptr = %d  num_str = %d\n", num_ptr, num_str);
   HDR_MARSHAL_PTR(m_fblock_list_tail, MIMEFieldBlockImpl, ptr_xlate, num_ptr);
+  m_field_index = 0;
   return m_first_fblock.marshal(ptr_xlate, num_ptr, str_xlate, num_str);
 }
 
@@ -3749,6 +4078,7 @@ void
 MIMEHdrImpl::unmarshal(intptr_t offset)
 {
   HDR_UNMARSHAL_PTR(m_fblock_list_tail, MIMEFieldBlockImpl, offset);
+  m_field_index = 0;
   m_first_fblock.unmarshal(offset);
 }
 
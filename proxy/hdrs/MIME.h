@@ -82,6 +82,8 @@ enum MimeParseState {
 #define MIME_FIELD_SLOT_FLAGS_COOKED (1 << 1)
 
 #define MIME_FIELD_BLOCK_SLOTS 16
+// m_field_index of a header whose field index didn't fit; objects are aligned, so no real offset is -1.
+#define MIME_FIELD_INDEX_UNBUILDABLE -1
 
 #define MIME_FIELD_SLOTNUM_BITS 4
 #define MIME_FIELD_SLOTNUM_MASK ((1 << MIME_FIELD_SLOTNUM_BITS) - 1)
@@ -247,7 +249,9 @@ struct MIMECooked {
  ***********************************************************************/
 
 struct MIMEHdrImpl : public HdrHeapObjImpl {
-  // HdrHeapObjImpl is 4 bytes, so this will result in 4 bytes padding
+  // HdrHeapObjImpl is 4 bytes, the field index offset fills the padding
+  // before the presence bits so the marshalled layout doesn't change.
+  int32_t m_field_index; // offset of the MIMEFieldIndex from this header, 0 if none, MIME_FIELD_INDEX_UNBUILDABLE if too big
   uint64_t m_presence_bits;
   uint32_t m_slot_accelerators[4];
 
@@ -636,7 +640,7 @@ void mime_hdr_fields_clear(HdrHeap *heap, MIMEHdrImpl *mh);
 MIMEField *_mime_hdr_field_list_search_by_wks(MIMEHdrImpl *mh, int wks_idx);
 MIMEField *_mime_hdr_field_list_search_by_string(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len);
 MIMEField *_mime_hdr_field_list_search_by_slotnum(MIMEHdrImpl *mh, int slotnum);
-inkcoreapi MIMEField *mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len);
+inkcoreapi MIMEField *mime_hdr_field_find(MIMEHdrImpl *mh, const char *field_name_str, int field_name_len, HdrHeap *heap = nullptr);
 
 MIMEField *mime_hdr_field_get(MIMEHdrImpl *mh, int idx);
 MIMEField *mime_hdr_field_get_slotnum(MIMEHdrImpl *mh, int slotnum);
@@ -1115,14 +1119,14 @@ inline MIMEField *
 MIMEHdr::field_find(const char *name, int length)
 {
   //    ink_assert(valid());
-  return mime_hdr_field_find(m_mime, name, length);
+  return mime_hdr_field_find(m_mime, name, length, m_heap);
 }
 
 inline const MIMEField *
 MIMEHdr::field_find(const char *name, int length) const
 {
   //    ink_assert(valid());
-  MIMEField *retval = mime_hdr_field_find(const_cast<MIMEHdr *>(this)->m_mime, name, length);
+  MIMEField *retval = mime_hdr_field_find(const_cast<MIMEHdr *>(this)->m_mime, name, length, m_heap);
   return retval;
 }
 
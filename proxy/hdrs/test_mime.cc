@@ -21,9 +21,14 @@
   limitations under the License.
  */
 
+#include <cstdio>
+#include <cstring>
+#include <string>
 #include <ts/TestBox.h>
 #include "I_EventSystem.h"
 #include "MIME.h"
+#include "HdrHeap.h"
+#include "HdrToken.h"
 
 REGRESSION_TEST(MIME)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
 {
@@ -52,6 +57,357 @@ REGRESSION_TEST(MIME)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatu
   hdr.destroy();
 }
 
+REGRESSION_TEST(MIME_parse)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  // Lines long enough for the vectorized line scan, fed to the parser in two pieces split at every byte.
+  const char *input = "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/60.0\r\n"
+                      "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,*/*;q=0.8\r\n"
+                      "X-Folded: part1\r\n"
+                      "\tpart2\r\n"
+                      "Host: www.example.com\r\n"
+                      "\r\n";
+  int input_length = strlen(input);
+
+  for (int split = 0; split <= input_length; ++split) {
+    char buf[256];
+    const char *start = buf;
+    const char *end   = buf + split;
+    MIMEParser parser;
+    MIMEHdr hdr;
+    int length;
+
+    memcpy(buf, input, input_length);
+    hdr.create(nullptr);
+    mime_parser_init(&parser);
+
+    int result = hdr.parse(&parser, &start, end, true, false);
+    if (result == PARSE_RESULT_CONT) {
+      end    = buf + input_length;
+      result = hdr.parse(&parser, &start, end, true, true);
+    }
+    box.check(result == PARSE_RESULT_DONE, "Split at %d: result is %d but should be %d", split, result, PARSE_RESULT_DONE);
+    box.check(hdr.fields_count() == 4, "Split at %d: %d fields but there should be 4", split, hdr.fields_count());
+
+    const char *host = hdr.value_get("Host", 4, &length);
+    box.check(host && length == 15 && memcmp(host, "www.example.com", 15) == 0, "Split at %d: wrong Host", split);
+
+    mime_parser_clear(&parser);
+    hdr.destroy();
+  }
+
+  // A '\0' anywhere in a line is an error, whichever part of the scan finds it.
+  for (int position = 8; position < 80; ++position) {
+    char buf[128];
+    const char *start = buf;
+    MIMEParser parser;
+    MIMEHdr hdr;
+
+    memset(buf, 'x', sizeof(buf));
+    memcpy(buf, "X-Long: ", 8);
+    memcpy(buf + 96, "\r\n\r\n", 4);
+    buf[position] = '\0';
+    hdr.create(nullptr);
+    mime_parser_init(&parser);
+
+    int result = hdr.parse(&parser, &start, buf + 100, false, true);
+    box.check(result == PARSE_RESULT_ERROR, "NUL at %d: result is %d but should be %d", position, result, PARSE_RESULT_ERROR);
+
+    mime_parser_clear(&parser);
+    hdr.destroy();
+  }
+}
+
+REGRESSION_TEST(HdrToken_tokenize)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  for (int i = 0; i < hdrtoken_num_wks; i++) {
+    char buf[64];
+    int length = hdrtoken_index_to_length(i);
+
+    // Copies, so they aren't recognized by their address in the well-known string heap.
+    for (int c = 0; c < length; c++) {
+      buf[c] = toupper(hdrtoken_index_to_wks(i)[c]);
+    }
+    box.check(hdrtoken_tokenize(buf, length) == i, "'%.*s' should be %d", length, buf, i);
+    for (int c = 0; c < length; c++) {
+      buf[c] = tolower(buf[c]);
+    }
+    const char *wks = nullptr;
+    box.check(hdrtoken_tokenize(buf, length, &wks) == i && wks == hdrtoken_index_to_wks(i), "'%.*s' should be %d", length, buf, i);
+
+    // Near misses are either unknown or another well-known string.
+    buf[length - 1] ^= 0x1;
+    int idx = hdrtoken_tokenize(buf, length);
+    box.check(idx == -1 || (hdrtoken_index_to_length(idx) == length && strncasecmp(hdrtoken_index_to_wks(idx), buf, length) == 0),
+              "'%.*s' is not %d", length, buf, idx);
+    buf[length - 1] ^= 0x1;
+    box.check(hdrtoken_tokenize(buf, length - 1) != i, "'%.*s' is not %d", length - 1, buf, i);
+  }
+
+  box.check(hdrtoken_tokenize("X-Custom-Header", 15) == -1, "X-Custom-Header is not well-known");
+  box.check(hdrtoken_tokenize("", 0) == -1, "The empty string is not well-known");
+}
+
+// The first live field named @a name, the way the field list was searched before the index.
+static MIMEField *
+field_list_search(MIMEHdrImpl *mh, const char *name, int length)
+{
+  for (MIMEFieldBlockImpl *fblock = &(mh->m_first_fblock); fblock != nullptr; fblock = fblock->m_next) {
+    for (unsigned i = 0; i < fblock->m_freetop; ++i) {
+      MIMEField *field = &(fblock->m_field_slots[i]);
+      if (field->is_live() && field->m_len_name == length && strncasecmp(field->m_ptr_name, name, length) == 0) {
+        return field;
+      }
+    }
+  }
+  return nullptr;
+}
+
+REGRESSION_TEST(MIME_field_index)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  // Well-known names with and without slot accelerators, and names that aren't well-known at all.
+  static const char *wks_names[] = {"Via", "Warning", "Set-Cookie", "Vary", "Age", "Server", "Content-Type", "Link"};
+  char names[80][16];
+  int lengths[80];
+  MIMEHdr hdr;
+  uint32_t rng = 1;
+
+  for (int i = 0; i < 80; ++i) {
+    if (i < static_cast<int>(sizeof(wks_names) / sizeof(*wks_names))) {
+      strcpy(names[i], wks_names[i]);
+    } else {
+      snprintf(names[i], sizeof(names[i]), "X-Field-%d", i);
+    }
+    lengths[i] = strlen(names[i]);
+  }
+
+  hdr.create(nullptr);
+  for (int i = 0; i < 60; ++i) {
+    hdr.value_set(names[i], lengths[i], "value", 5);
+  }
+
+  // Create, duplicate, detach, re-attach and delete fields, checking every name after each change.
+  for (int round = 0; round < 2000; ++round) {
+    rng              = rng * 1103515245 + 12345;
+    int n            = (rng >> 8) % 80;
+    MIMEField *field = hdr.field_find(names[n], lengths[n]);
+    int32_t offset   = hdr.m_mime->m_field_index;
+
+    switch ((rng >> 20) % 4) {
+    case 0:
+      hdr.field_attach(hdr.field_create(names[n], lengths[n]));
+      break;
+    case 1:
+      if (field) {
+        hdr.field_delete(field, (rng >> 24) & 1);
+      }
+      break;
+    case 2:
+      if (field) {
+        hdr.field_detach(field, false);
+        hdr.field_attach(field);
+      }
+      break;
+    default:
+      hdr.value_set(names[n], lengths[n], "other", 5);
+      break;
+    }
+
+    // An index that was dropped must have been given back to the heap.
+    if (offset && offset != MIME_FIELD_INDEX_UNBUILDABLE && hdr.m_mime->m_field_index != offset) {
+      HdrHeapObjImpl *old = reinterpret_cast<HdrHeapObjImpl *>(reinterpret_cast<char *>(hdr.m_mime) + offset);
+      box.check(old->m_type == HDR_HEAP_OBJ_EMPTY, "Round %d: the dropped field index wasn't deallocated", round);
+    }
+
+    for (int i = 0; i < 80; ++i) {
+      MIMEField *expected = field_list_search(hdr.m_mime, names[i], lengths[i]);
+      MIMEField *found    = hdr.field_find(names[i], lengths[i]);
+      if (found != expected) {
+        box.check(false, "Round %d: field_find(%s) is %p but should be %p", round, names[i], found, expected);
+        round = 2000;
+        break;
+      }
+    }
+  }
+  box.check(hdr.m_mime->m_field_index != 0, "A header with %d fields has no field index", hdr.fields_count());
+
+  // The index isn't marshalled, the unmarshalled header is searched field by field.
+  int length = hdr.m_heap->marshal_length();
+  char *buf  = static_cast<char *>(ats_malloc(length));
+  HdrHeapObjImpl *obj;
+
+  box.check(hdr.m_heap->marshal(buf, length) > 0, "Marshalling failed");
+  box.check(reinterpret_cast<HdrHeap *>(buf)->unmarshal(length, HDR_HEAP_OBJ_MIME_HEADER, &obj, nullptr) > 0,
+            "Unmarshalling failed");
+  MIMEHdrImpl *mh = reinterpret_cast<MIMEHdrImpl *>(obj);
+  box.check(mh->m_field_index == 0, "The field index survived marshalling");
+  for (int i = 0; i < 80; ++i) {
+    bool expected = field_list_search(hdr.m_mime, names[i], lengths[i]) != nullptr;
+    box.check((mime_hdr_field_find(mh, names[i], lengths[i]) != nullptr) == expected, "Unmarshalled field_find(%s) is wrong",
+              names[i]);
+  }
+
+  // Adding names until the index is too full drops it, and it is given back to the heap.  The
+  // headers get one big heap block so the index is always near enough to build.
+  MIMEHdr grow;
+  int32_t offset;
+
+  grow.create(new_HdrHeap(32 * 1024));
+  for (int i = 0; i < 20; ++i) {
+    grow.value_set(names[i], lengths[i], "value", 5);
+  }
+  grow.field_find(names[19], lengths[19]);
+  offset = grow.m_mime->m_field_index;
+  box.check(offset != 0, "A header with 20 fields has no field index");
+  for (int i = 20; i < 80 && grow.m_mime->m_field_index == offset; ++i) {
+    grow.field_attach(grow.field_create(names[i], lengths[i]));
+  }
+  box.check(grow.m_mime->m_field_index != offset, "Adding 60 names didn't drop the field index");
+  box.check(reinterpret_cast<HdrHeapObjImpl *>(reinterpret_cast<char *>(grow.m_mime) + offset)->m_type == HDR_HEAP_OBJ_EMPTY,
+            "The dropped field index wasn't deallocated");
+
+  // Likewise copying onto a header gives back the index it had.
+  MIMEHdr copy;
+
+  copy.create(new_HdrHeap(32 * 1024));
+  for (int i = 0; i < 20; ++i) {
+    copy.value_set(names[i], lengths[i], "value", 5);
+  }
+  copy.field_find(names[19], lengths[19]);
+  offset = copy.m_mime->m_field_index;
+  box.check(offset != 0, "A header with 20 fields has no field index");
+  copy.copy(&hdr);
+  box.check(reinterpret_cast<HdrHeapObjImpl *>(reinterpret_cast<char *>(copy.m_mime) + offset)->m_type == HDR_HEAP_OBJ_EMPTY,
+            "The field index of the copy destination wasn't deallocated");
+
+  // And so does clearing the fields of a header.  Via would be found through its slot accelerator, without the index.
+  grow.field_find(names[19], lengths[19]);
+  offset = grow.m_mime->m_field_index;
+  box.check(offset != 0, "A header with %d fields has no field index", grow.fields_count());
+  grow.fields_clear();
+  box.check(grow.m_mime->m_field_index == 0, "Clearing the fields kept the field index");
+  box.check(reinterpret_cast<HdrHeapObjImpl *>(reinterpret_cast<char *>(grow.m_mime) + offset)->m_type == HDR_HEAP_OBJ_EMPTY,
+            "The field index of the cleared header wasn't deallocated");
+
+  // A header with too many names for the index is marked so lookups don't retry the build, until a name is removed.
+  MIMEHdr many;
+  char many_names[160][16];
+
+  many.create(new_HdrHeap(32 * 1024));
+  for (int i = 0; i < 160; ++i) {
+    snprintf(many_names[i], sizeof(many_names[i]), "X-Many-%d", i);
+    many.value_set(many_names[i], strlen(many_names[i]), "value", 5);
+  }
+  box.check(many.field_find(many_names[159], strlen(many_names[159])) != nullptr, "field_find(%s) failed", many_names[159]);
+  box.check(many.m_mime->m_field_index == MIME_FIELD_INDEX_UNBUILDABLE, "A header with 160 names isn't marked unindexable");
+  for (int i = 0; i < 100; ++i) {
+    many.field_delete(many_names[i], strlen(many_names[i]));
+  }
+  box.check(many.m_mime->m_field_index != MIME_FIELD_INDEX_UNBUILDABLE, "Removing names didn't clear the unindexable mark");
+  box.check(many.field_find(many_names[159], strlen(many_names[159])) != nullptr, "field_find(%s) failed", many_names[159]);
+  box.check(many.field_find(many_names[0], strlen(many_names[0])) == nullptr, "field_find(%s) found a deleted field", many_names[0]);
+  box.check(many.m_mime->m_field_index != 0 && many.m_mime->m_field_index != MIME_FIELD_INDEX_UNBUILDABLE,
+            "A header with 60 names has no field index");
+
+  ats_free(buf);
+  grow.destroy();
+  copy.destroy();
+  many.destroy();
+  hdr.destroy();
+}
+
+// Print @a hdr the way HttpSM::write_header_into_buffer does, @a block_size bytes at a time.
+static std::string
+print_in_blocks(MIMEHdr &hdr, int block_size)
+{
+  std::string result;
+  char block[4096];
+  int dumpoffset = 0, done;
+
+  do {
+    int bufindex = 0, skip = dumpoffset;
+    done         = hdr.print(block, block_size, &bufindex, &skip);
+    result.append(block, bufindex);
+    dumpoffset += bufindex;
+  } while (!done);
+  return result;
+}
+
+REGRESSION_TEST(MIME_print)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  const char *input = "Server: ATS\r\n"
+                      "Date: Mon, 16 Oct 2017 10:00:00 GMT\r\n"
+                      "Content-Type:text/html\r\n"
+                      "@Internal: not printed\r\n"
+                      "Cache-Control: max-age=600\r\n"
+                      "X-Padded: value   \r\n"
+                      "Age: 0\r\n"
+                      "Content-Length: 1024\r\n"
+                      "\r\n";
+  const char *start = input;
+  MIMEParser parser;
+  MIMEHdr hdr;
+  MIMEField *field;
+  std::string expected;
+
+  hdr.create(nullptr);
+  mime_parser_init(&parser);
+  box.check(hdr.parse(&parser, &start, input + strlen(input), false, true) == PARSE_RESULT_DONE, "Parsing failed");
+  mime_parser_clear(&parser);
+
+  // Untouched, the header prints as it was parsed, whatever the buffer size.
+  expected = std::string(input);
+  expected.erase(expected.find("@Internal"), strlen("@Internal: not printed\r\n"));
+  for (int block_size = 1; block_size <= 256; ++block_size) {
+    if (print_in_blocks(hdr, block_size) != expected) {
+      box.check(false, "Printed in blocks of %d: '%s'", block_size, print_in_blocks(hdr, block_size).c_str());
+      break;
+    }
+  }
+
+  // Changed, removed, renamed and added fields break up the runs of raw fields.
+  hdr.value_set("Age", 3, "42", 2);
+  hdr.field_delete("Cache-Control", 13);
+  field = hdr.field_find("X-Padded", 8);
+  hdr.field_detach(field);
+  field->name_set(hdr.m_heap, hdr.m_mime, "X-Renamed-Field", 15);
+  hdr.field_attach(field);
+  hdr.value_set("Via", 3, "http/1.1 cache", 14);
+  expected = "Server: ATS\r\n"
+             "Date: Mon, 16 Oct 2017 10:00:00 GMT\r\n"
+             "Content-Type:text/html\r\n"
+             "X-Renamed-Field: value\r\n"
+             "Age: 42\r\n"
+             "Content-Length: 1024\r\n"
+             "Via: http/1.1 cache\r\n"
+             "\r\n";
+  for (int block_size = 1; block_size <= 256; ++block_size) {
+    if (print_in_blocks(hdr, block_size) != expected) {
+      box.check(false, "Changed, printed in blocks of %d: '%s'", block_size, print_in_blocks(hdr, block_size).c_str());
+      break;
+    }
+  }
+
+  // Fields stay raw printable when their strings are moved to a new heap.
+  hdr.m_heap->coalesce_str_heaps();
+  field = hdr.field_find("Server", 6);
+  box.check(field && field->m_n_v_raw_printable, "Server is no longer raw printable after coalescing");
+  box.check(print_in_blocks(hdr, 4096) == expected, "Coalesced: '%s'", print_in_blocks(hdr, 4096).c_str());
+
+  hdr.destroy();
+}
+
 int
 main(int argc, const char **argv)
 {
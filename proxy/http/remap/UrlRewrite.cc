@@ -70,6 +70,8 @@ UrlRewrite::UrlRewrite()
 
   forward_mappings.hash_lookup = reverse_mappings.hash_lookup = permanent_redirects.hash_lookup = temporary_redirects.hash_lookup =
     forward_mappings_with_recv_port.hash_lookup                                                 = nullptr;
+  forward_mappings.regex_prefilter = reverse_mappings.regex_prefilter = permanent_redirects.regex_prefilter =
+    temporary_redirects.regex_prefilter = forward_mappings_with_recv_port.regex_prefilter = nullptr;
 
   config_file_path = RecConfigReadConfigPath("proxy.config.url_remap.filename", "remap.config");
   if (!config_file_path) {
@@ -727,9 +729,43 @@ UrlRewrite::BuildTable(const char *path)
     forward_mappings_with_recv_port.hash_lookup = ink_hash_table_destroy(forward_mappings_with_recv_port.hash_lookup);
   }
 
+  _buildRegexPrefilter(forward_mappings);
+  _buildRegexPrefilter(reverse_mappings);
+  _buildRegexPrefilter(permanent_redirects);
+  _buildRegexPrefilter(temporary_redirects);
+  _buildRegexPrefilter(forward_mappings_with_recv_port);
+
   return 0;
 }
 
+/**
+  Indexes the regex mappings of @a store by the literal each regex requires, so a lookup
+  only runs the regexes that can match the request host.
+
+*/
+void
+UrlRewrite::_buildRegexPrefilter(MappingsStore &store)
+{
+  if (store.regex_list.empty()) {
+    return;
+  }
+
+  store.regex_prefilter = new RegexPrefilter();
+  forl_LL(RegexMapping, list_iter, store.regex_list)
+  {
+    int host_len;
+    const char *host = list_iter->url_map->fromURL.host_get(&host_len);
+    std::string pattern(host, host_len);
+
+    store.regex_prefilter->add(pattern.c_str(), store.regex_index.size());
+    store.regex_index.push_back(list_iter);
+  }
+  store.regex_prefilter->build();
+
+  Debug("url_rewrite_regex", "%zu of %zu regex mappings are prefiltered by a literal", store.regex_prefilter->filtered(),
+        store.regex_index.size());
+}
+
 /**
   Inserts arg mapping in h_table with key src_host chaining the mapping
   of existing entries bound to src_host if necessary.
@@ -796,7 +832,7 @@ UrlRewrite::_mappingLookup(MappingsStore &mappings, URL *request_url, int reques
     mapping_container.set(mapping);
     retval = true;
   }
-  if (_regexMappingLookup(mappings.regex_list, request_url, request_port, request_host_lower, request_host_len, rank_ceiling,
+  if (_regexMappingLookup(mappings, request_url, request_port, request_host_lower, request_host_len, rank_ceiling,
                           mapping_container)) {
     Debug("url_rewrite", "Using regex mapping with rank %d", (mapping_container.getMapping())->getRank());
     retval = true;
@@ -853,7 +889,7 @@ lOverFlow:
 }
 
 bool
-UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, URL *request_url, int request_port, const char *request_host,
+UrlRewrite::_regexMappingLookup(MappingsStore &mappings, URL *request_url, int request_port, const char *request_host,
                                 int request_host_len, int rank_ceiling, UrlMappingContainer &mapping_container)
 {
   bool retval = false;
@@ -878,10 +914,20 @@ UrlRewrite::_regexMappingLookup(RegexMappingList &regex_mappings, URL *request_u
     request_scheme_len = hdrtoken_wks_to_length(request_scheme);
   }
 
-  // Loop over the entire linked list, or until we're satisfied
-  forl_LL(RegexMapping, list_iter, regex_mappings)
-  {
-    int reg_map_rank = list_iter->url_map->getRank();
+  // Only the regexes whose required literal is in the host can match. Without a
+  // prefilter, or with too many candidates, fall back to trying all of them.
+  int candidates[MAX_REGEX_CANDIDATES];
+  int n_candidates = -1;
+
+  if (mappings.regex_prefilter) {
+    n_candidates = mappings.regex_prefilter->candidates(request_host, request_host_len, candidates, countof(candidates));
+  }
+  int n_regexes = (n_candidates >= 0) ? n_candidates : static_cast<int>(mappings.regex_index.size());
+
+  // Loop over the candidates in rank order, or until we're satisfied
+  for (int i = 0; i < n_regexes; ++i) {
+    RegexMapping *list_iter = mappings.regex_index[(n_candidates >= 0) ? candidates[i] : i];
+    int reg_map_rank        = list_iter->url_map->getRank();
 
     if (reg_map_rank > rank_ceiling) {
       break;
@@ -28,6 +28,9 @@
 #include "UrlMapping.h"
 #include "HttpTransact.h"
 #include "ts/Regex.h"
+#include "ts/RegexPrefilter.h"
+
+#include <vector>
 
 #define URL_REMAP_FILTER_NONE 0x00000000
 #define URL_REMAP_FILTER_REFERER 0x00000001      /* enable "referer" header validation */
@@ -70,6 +73,8 @@ public:
   //  private:
 
   static const int MAX_REGEX_SUBS = 10;
+  // More prefilter candidates than this and all the regex mappings are tried
+  static const int MAX_REGEX_CANDIDATES = 64;
 
   struct RegexMapping {
     url_mapping *url_map;
@@ -98,6 +103,9 @@ public:
   struct MappingsStore {
     InkHashTable *hash_lookup;
     RegexMappingList regex_list;
+    // regex_list in rank order, indexed by the prefilter once the table is built
+    std::vector<RegexMapping *> regex_index;
+    RegexPrefilter *regex_prefilter;
     bool
     empty()
     {
@@ -114,6 +122,9 @@ public:
   {
     _destroyTable(store.hash_lookup);
     _destroyList(store.regex_list);
+    store.regex_index.clear();
+    delete store.regex_prefilter;
+    store.regex_prefilter = nullptr;
   }
 
   bool InsertForwardMapping(mapping_type maptype, url_mapping *mapping, const char *src_host);
@@ -181,12 +192,13 @@ private:
   bool _mappingLookup(MappingsStore &mappings, URL *request_url, int request_port, const char *request_host, int request_host_len,
                       UrlMappingContainer &mapping_container);
   url_mapping *_tableLookup(InkHashTable *h_table, URL *request_url, int request_port, char *request_host, int request_host_len);
-  bool _regexMappingLookup(RegexMappingList &regex_mappings, URL *request_url, int request_port, const char *request_host,
+  bool _regexMappingLookup(MappingsStore &mappings, URL *request_url, int request_port, const char *request_host,
                            int request_host_len, int rank_ceiling, UrlMappingContainer &mapping_container);
   int _expandSubstitutions(int *matches_info, const RegexMapping *reg_map, const char *matched_string, char *dest_buf,
                            int dest_buf_size);
   void _destroyTable(InkHashTable *h_table);
   void _destroyList(RegexMappingList &regexes);
+  void _buildRegexPrefilter(MappingsStore &store);
   inline bool _addToStore(MappingsStore &store, url_mapping *new_mapping, RegexMapping *reg_map, const char *src_host,
                           bool is_cur_mapping_regex, int &count);
 };
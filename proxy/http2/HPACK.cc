@@ -24,6 +24,8 @@
 #include "HPACK.h"
 #include "HuffmanCodec.h"
 
+#include <algorithm>
+
 // [RFC 7541] 4.1. Calculating Table Size
 // The size of an entry is the sum of its name's length in octets (as defined in Section 5.2),
 // its value's length in octets, and 32.
@@ -166,6 +168,96 @@ static const StaticTable STATIC_TABLE[] = {{"", ""},
                                            {"via", ""},
                                            {"www-authenticate", ""}};
 
+static const uint32_t HPACK_HASH_BASIS = 2166136261u;
+
+// FNV-1a over the lower cased name, header field names are case insensitive.
+static inline uint32_t
+hpack_name_hash(const char *name, int name_len, uint32_t hash = HPACK_HASH_BASIS)
+{
+  for (int i = 0; i < name_len; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(ParseRules::ink_tolower(name[i]))) * 16777619u;
+  }
+  return hash;
+}
+
+static inline uint32_t
+hpack_field_hash(uint32_t name_hash, const char *value, int value_len)
+{
+  uint32_t hash = name_hash;
+
+  for (int i = 0; i < value_len; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(value[i])) * 16777619u;
+  }
+  return hash;
+}
+
+// Perfect hash of the static table names. The seed is searched for once at startup, so that every
+// name gets its own slot. Entries sharing a name are adjacent in the table, the slot holds the first.
+class HpackStaticIndex
+{
+public:
+  HpackStaticIndex()
+  {
+    for (_seed = 0;; ++_seed) {
+      ink_release_assert(_seed < 1 << 16);
+      memset(_slots, 0, sizeof(_slots));
+
+      bool collision = false;
+      for (int index = 1; index < TS_HPACK_STATIC_TABLE_ENTRY_NUM && !collision; ++index) {
+        uint8_t &slot = _slots[_slot(STATIC_TABLE[index].name, STATIC_TABLE[index].name_size)];
+
+        if (slot == 0) {
+          slot = index;
+        } else {
+          collision = strcmp(STATIC_TABLE[slot].name, STATIC_TABLE[index].name) != 0;
+        }
+      }
+      if (!collision) {
+        break;
+      }
+    }
+  }
+
+  HpackLookupResult
+  lookup(const char *name, int name_len, const char *value, int value_len) const
+  {
+    HpackLookupResult result;
+    int index = _slots[_slot(name, name_len)];
+
+    if (index == 0 || ptr_len_casecmp(name, name_len, STATIC_TABLE[index].name, STATIC_TABLE[index].name_size) != 0) {
+      return result;
+    }
+
+    result.index      = index;
+    result.index_type = HpackIndex::STATIC;
+    result.match_type = HpackMatch::NAME;
+    for (int i = index; i < TS_HPACK_STATIC_TABLE_ENTRY_NUM && strcmp(STATIC_TABLE[i].name, STATIC_TABLE[index].name) == 0; ++i) {
+      if (value_len == STATIC_TABLE[i].value_size && memcmp(value, STATIC_TABLE[i].value, value_len) == 0) {
+        result.index      = i;
+        result.match_type = HpackMatch::EXACT;
+        break;
+      }
+    }
+    return result;
+  }
+
+private:
+  static const int SLOT_BITS = 8;
+  static const int SLOTS     = 1 << SLOT_BITS;
+
+  // The low bits of FNV-1a only depend on the low bits of the input, use the high ones.
+  int
+  _slot(const char *name, int name_len) const
+  {
+    return hpack_name_hash(name, name_len, HPACK_HASH_BASIS + _seed * 0x9e3779b9u) >> (32 - SLOT_BITS);
+  }
+
+  uint32_t _seed;
+  uint8_t _slots[SLOTS];
+};
+
+static const HpackStaticIndex STATIC_INDEX;
+
 /******************
  * Local functions
  ******************/
@@ -218,44 +310,15 @@ HpackIndexingTable::lookup(const MIMEFieldWrapper &field) const
 HpackLookupResult
 HpackIndexingTable::lookup(const char *name, int name_len, const char *value, int value_len) const
 {
-  HpackLookupResult result;
-  const int entry_num = TS_HPACK_STATIC_TABLE_ENTRY_NUM + _dynamic_table->length();
-
-  for (int index = 1; index < entry_num; ++index) {
-    const char *table_name, *table_value;
-    int table_name_len = 0, table_value_len = 0;
-
-    if (index < TS_HPACK_STATIC_TABLE_ENTRY_NUM) {
-      // static table
-      table_name      = STATIC_TABLE[index].name;
-      table_value     = STATIC_TABLE[index].value;
-      table_name_len  = STATIC_TABLE[index].name_size;
-      table_value_len = STATIC_TABLE[index].value_size;
-    } else {
-      // dynamic table
-      const MIMEField *m_field = _dynamic_table->get_header_field(index - TS_HPACK_STATIC_TABLE_ENTRY_NUM);
+  // The lowest index wins, but an exact match anywhere is better than a name match.
+  HpackLookupResult result = STATIC_INDEX.lookup(name, name_len, value, value_len);
 
-      table_name  = m_field->name_get(&table_name_len);
-      table_value = m_field->value_get(&table_value_len);
-    }
+  if (result.match_type != HpackMatch::EXACT) {
+    HpackLookupResult dynamic = _dynamic_table->lookup(name, name_len, value, value_len);
 
-    // Check whether name (and value) are matched
-    if (ptr_len_casecmp(name, name_len, table_name, table_name_len) == 0) {
-      if ((value_len == table_value_len) && (memcmp(value, table_value, value_len) == 0)) {
-        result.index      = index;
-        result.match_type = HpackMatch::EXACT;
-        break;
-      } else if (!result.index) {
-        result.index      = index;
-        result.match_type = HpackMatch::NAME;
-      }
-    }
-  }
-  if (result.match_type != HpackMatch::NONE) {
-    if (result.index < TS_HPACK_STATIC_TABLE_ENTRY_NUM) {
-      result.index_type = HpackIndex::STATIC;
-    } else {
-      result.index_type = HpackIndex::DYNAMIC;
+    if (dynamic.match_type == HpackMatch::EXACT || (dynamic.match_type == HpackMatch::NAME && !result.index)) {
+      result = dynamic;
+      result.index += TS_HPACK_STATIC_TABLE_ENTRY_NUM;
     }
   }
 
@@ -276,12 +339,10 @@ HpackIndexingTable::get_header_field(uint32_t index, MIMEFieldWrapper &field) co
     field.value_set(STATIC_TABLE[index].value, STATIC_TABLE[index].value_size);
   } else if (index < TS_HPACK_STATIC_TABLE_ENTRY_NUM + _dynamic_table->length()) {
     // dynamic table
-    const MIMEField *m_field = _dynamic_table->get_header_field(index - TS_HPACK_STATIC_TABLE_ENTRY_NUM);
-
+    const char *name, *value;
     int name_len, value_len;
-    const char *name  = m_field->name_get(&name_len);
-    const char *value = m_field->value_get(&value_len);
 
+    _dynamic_table->get_header_field(index - TS_HPACK_STATIC_TABLE_ENTRY_NUM, &name, &name_len, &value, &value_len);
     field.name_set(name, name_len);
     field.value_set(value, value_len);
   } else {
@@ -318,10 +379,24 @@ HpackIndexingTable::update_maximum_size(uint32_t new_size)
   return _dynamic_table->update_maximum_size(new_size);
 }
 
-const MIMEField *
-HpackDynamicTable::get_header_field(uint32_t index) const
+HpackDynamicTable::~HpackDynamicTable()
 {
-  return _headers.get(index);
+  ats_free(_data);
+  ats_free(_entries);
+  ats_free(_name_buckets);
+  ats_free(_field_buckets);
+}
+
+void
+HpackDynamicTable::get_header_field(uint32_t index, const char **name, int *name_len, const char **value, int *value_len) const
+{
+  ink_assert(index < _count);
+  const Entry &entry = _entry(index);
+
+  *name      = _data + entry.offset;
+  *name_len  = entry.name_len;
+  *value     = *name + entry.name_len;
+  *value_len = entry.value_len;
 }
 
 void
@@ -337,31 +412,187 @@ HpackDynamicTable::add_header_field(const MIMEField *field)
     // It is not an error to attempt to add an entry that is larger than
     // the maximum size; an attempt to add an entry larger than the entire
     // table causes the table to be emptied of all existing entries.
-    _headers.clear();
-    _mhdr->fields_clear();
-    _current_size = 0;
+    while (_count) {
+      _evict_last();
+    }
   } else {
     _current_size += header_size;
     while (_current_size > _maximum_size) {
-      int last_name_len, last_value_len;
-      MIMEField *last_field = _headers.last();
+      _evict_last();
+    }
+
+    if (_count == _entries_capacity) {
+      _grow_entries();
+    }
+
+    char *data   = _reserve(name_len + value_len);
+    Entry &entry = _entries[(_first + _count) & (_entries_capacity - 1)];
+
+    memcpy(data, name, name_len);
+    memcpy(data + name_len, value, value_len);
+    entry.offset     = data - _data;
+    entry.name_len   = name_len;
+    entry.value_len  = value_len;
+    entry.name_hash  = hpack_name_hash(name, name_len);
+    entry.field_hash = hpack_field_hash(entry.name_hash, value, value_len);
+
+    uint32_t &name_bucket  = _name_buckets[entry.name_hash & (_entries_capacity - 1)];
+    uint32_t &field_bucket = _field_buckets[entry.field_hash & (_entries_capacity - 1)];
+
+    entry.name_next  = name_bucket;
+    entry.field_next = field_bucket;
+    name_bucket      = _inserted;
+    field_bucket     = _inserted;
+    ++_inserted;
+    ++_count;
+  }
+}
+
+HpackLookupResult
+HpackDynamicTable::lookup(const char *name, int name_len, const char *value, int value_len) const
+{
+  HpackLookupResult result;
+
+  if (_count == 0) {
+    return result;
+  }
+
+  // Chains are newest first, so the first match has the lowest index. An evicted entry ends the
+  // chain, everything after it is older.
+  uint32_t name_hash  = hpack_name_hash(name, name_len);
+  uint32_t field_hash = hpack_field_hash(name_hash, value, value_len);
+
+  for (int i = _index(_field_buckets[field_hash & (_entries_capacity - 1)]), prev = -1; i > prev;
+       prev = i, i = _index(_entry(i).field_next)) {
+    const Entry &entry = _entry(i);
+
+    if (entry.field_hash == field_hash && static_cast<int>(entry.value_len) == value_len &&
+        ptr_len_casecmp(name, name_len, _data + entry.offset, entry.name_len) == 0 &&
+        memcmp(value, _data + entry.offset + entry.name_len, value_len) == 0) {
+      result.index      = i;
+      result.index_type = HpackIndex::DYNAMIC;
+      result.match_type = HpackMatch::EXACT;
+      return result;
+    }
+  }
+
+  for (int i = _index(_name_buckets[name_hash & (_entries_capacity - 1)]), prev = -1; i > prev;
+       prev = i, i = _index(_entry(i).name_next)) {
+    const Entry &entry = _entry(i);
+
+    if (entry.name_hash == name_hash && ptr_len_casecmp(name, name_len, _data + entry.offset, entry.name_len) == 0) {
+      result.index      = i;
+      result.index_type = HpackIndex::DYNAMIC;
+      result.match_type = HpackMatch::NAME;
+      return result;
+    }
+  }
+
+  return result;
+}
+
+// Find room for @a len bytes after the newest entry, compacting or growing the ring if they don't fit.
+char *
+HpackDynamicTable::_reserve(uint32_t len)
+{
+  if (_data_used == 0) {
+    _data_head = 0;
+  }
 
-      last_field->name_get(&last_name_len);
-      last_field->value_get(&last_value_len);
-      _current_size -= ADDITIONAL_OCTETS + last_name_len + last_value_len;
+  uint32_t tail = _data_used ? _entry(_count - 1).offset : 0;
 
-      _headers.remove_index(_headers.length() - 1);
-      _mhdr->field_delete(last_field, false);
+  if (_data_used == 0 || _data_head > tail) {
+    if (_data_capacity - _data_head < len) {
+      if (tail >= len) {
+        _data_head = 0; // wrap, the end of the ring stays unused until the oldest entries are gone
+      } else {
+        // The accounting overhead of the entries makes sure all the data fits in _maximum_size.
+        _resize_data(std::min(_maximum_size, std::max(std::max(_data_capacity * 2, _data_used + len), 128u)));
+      }
     }
+  } else if (tail - _data_head < len) {
+    _resize_data(std::min(_maximum_size, std::max(std::max(_data_capacity * 2, _data_used + len), 128u)));
+  }
+
+  char *data = _data + _data_head;
+  _data_head += len;
+  _data_used += len;
+  return data;
+}
+
+// Move the data to a ring of @a capacity bytes, oldest entry first.
+void
+HpackDynamicTable::_resize_data(uint32_t capacity)
+{
+  char *data      = static_cast<char *>(ats_malloc(capacity));
+  uint32_t offset = 0;
+
+  ink_release_assert(capacity >= _data_used);
+  for (int i = _count - 1; i >= 0; --i) {
+    Entry &entry  = _entry(i);
+    uint32_t size = entry.name_len + entry.value_len;
+
+    memcpy(data + offset, _data + entry.offset, size);
+    entry.offset = offset;
+    offset += size;
+  }
+
+  ats_free(_data);
+  _data          = data;
+  _data_capacity = capacity;
+  _data_head     = offset;
+}
 
-    MIMEField *new_field = _mhdr->field_create(name, name_len);
-    new_field->value_set(_mhdr->m_heap, _mhdr->m_mime, value, value_len);
-    _mhdr->field_attach(new_field);
-    // XXX Because entire Vec instance is copied, Its too expensive!
-    _headers.insert(0, new_field);
+// Double the entry ring, and rehash into as many buckets.
+void
+HpackDynamicTable::_grow_entries()
+{
+  uint32_t capacity = std::max(_entries_capacity * 2, 16u);
+  Entry *entries    = static_cast<Entry *>(ats_malloc(capacity * sizeof(Entry)));
+
+  for (uint32_t i = 0; i < _count; ++i) {
+    entries[i] = _entries[(_first + i) & (_entries_capacity - 1)];
+  }
+  ats_free(_entries);
+  _entries          = entries;
+  _entries_capacity = capacity;
+  _first            = 0;
+
+  ats_free(_name_buckets);
+  ats_free(_field_buckets);
+  _name_buckets  = static_cast<uint32_t *>(ats_malloc(capacity * sizeof(uint32_t)));
+  _field_buckets = static_cast<uint32_t *>(ats_malloc(capacity * sizeof(uint32_t)));
+
+  // The number of an evicted entry is an empty bucket.
+  uint32_t evicted = _inserted - _count - 1;
+  for (uint32_t i = 0; i < capacity; ++i) {
+    _name_buckets[i]  = evicted;
+    _field_buckets[i] = evicted;
+  }
+  for (uint32_t i = 0; i < _count; ++i) {
+    Entry &entry           = _entries[i];
+    uint32_t &name_bucket  = _name_buckets[entry.name_hash & (capacity - 1)];
+    uint32_t &field_bucket = _field_buckets[entry.field_hash & (capacity - 1)];
+
+    entry.name_next  = name_bucket;
+    entry.field_next = field_bucket;
+    name_bucket      = _inserted - _count + i;
+    field_bucket     = _inserted - _count + i;
   }
 }
 
+// Drop the oldest entry. Its number stays in the chains, where it reads as the end.
+void
+HpackDynamicTable::_evict_last()
+{
+  const Entry &entry = _entries[_first];
+
+  _current_size -= ADDITIONAL_OCTETS + entry.name_len + entry.value_len;
+  _data_used -= entry.name_len + entry.value_len;
+  _first = (_first + 1) & (_entries_capacity - 1);
+  --_count;
+}
+
 uint32_t
 HpackDynamicTable::maximum_size() const
 {
@@ -385,28 +616,23 @@ bool
 HpackDynamicTable::update_maximum_size(uint32_t new_size)
 {
   while (_current_size > new_size) {
-    if (_headers.n <= 0) {
+    if (_count == 0) {
       return false;
     }
-    int last_name_len, last_value_len;
-    MIMEField *last_field = _headers.last();
-
-    last_field->name_get(&last_name_len);
-    last_field->value_get(&last_value_len);
-    _current_size -= ADDITIONAL_OCTETS + last_name_len + last_value_len;
-
-    _headers.remove_index(_headers.length() - 1);
-    _mhdr->field_delete(last_field, false);
+    _evict_last();
   }
 
   _maximum_size = new_size;
+  if (_data_capacity > _maximum_size) {
+    _resize_data(_maximum_size);
+  }
   return true;
 }
 
 uint32_t
 HpackDynamicTable::length() const
 {
-  return _headers.length();
+  return _count;
 }
 
 //
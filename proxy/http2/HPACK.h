@@ -102,25 +102,19 @@ private:
 };
 
 // [RFC 7541] 2.3.2. Dynamic Table
+//
+// The names and values live back to back in one byte ring, with a ring of entries pointing into it,
+// so adding and evicting entries doesn't allocate. Both rings grow on demand up to what the maximum
+// size of the table can hold.
 class HpackDynamicTable
 {
 public:
-  HpackDynamicTable(uint32_t size) : _current_size(0), _maximum_size(size)
-  {
-    _mhdr = new MIMEHdr();
-    _mhdr->create();
-  }
-
-  ~HpackDynamicTable()
-  {
-    _headers.clear();
-    _mhdr->fields_clear();
-    _mhdr->destroy();
-    delete _mhdr;
-  }
+  HpackDynamicTable(uint32_t size) : _maximum_size(size) {}
+  ~HpackDynamicTable();
 
-  const MIMEField *get_header_field(uint32_t index) const;
+  void get_header_field(uint32_t index, const char **name, int *name_len, const char **value, int *value_len) const;
   void add_header_field(const MIMEField *field);
+  HpackLookupResult lookup(const char *name, int name_len, const char *value, int value_len) const;
 
   uint32_t maximum_size() const;
   uint32_t size() const;
@@ -129,11 +123,53 @@ public:
   uint32_t length() const;
 
 private:
-  uint32_t _current_size;
+  // Entries are numbered in the order they are added. Entry number n is at index _inserted - 1 - n.
+  struct Entry {
+    uint32_t offset; // of the name in _data, the value follows it
+    uint32_t name_len;
+    uint32_t value_len;
+    uint32_t name_hash;
+    uint32_t field_hash; // of the name and the value
+    uint32_t name_next;  // number of the next older entry in the same name bucket
+    uint32_t field_next; // number of the next older entry in the same field bucket
+  };
+
+  Entry &
+  _entry(uint32_t index) const
+  {
+    return _entries[(_first + _count - 1 - index) & (_entries_capacity - 1)];
+  }
+
+  // The index of entry @a number, or -1 if it has been evicted.
+  int
+  _index(uint32_t number) const
+  {
+    uint32_t index = _inserted - 1 - number;
+    return index < _count ? index : -1;
+  }
+
+  char *_reserve(uint32_t len);
+  void _resize_data(uint32_t capacity);
+  void _grow_entries();
+  void _evict_last();
+
+  uint32_t _current_size = 0;
   uint32_t _maximum_size;
 
-  MIMEHdr *_mhdr;
-  Vec<MIMEField *> _headers;
+  char *_data             = nullptr;
+  uint32_t _data_capacity = 0;
+  uint32_t _data_head     = 0; // where the next entry goes
+  uint32_t _data_used     = 0; // by the names and values of the entries
+
+  Entry *_entries            = nullptr;
+  uint32_t _entries_capacity = 0; // a power of 2
+  uint32_t _first            = 0; // oldest entry
+  uint32_t _count            = 0;
+  uint32_t _inserted         = 0;
+
+  // Chains of entries with the same hash, newest first, as many buckets as _entries_capacity.
+  uint32_t *_name_buckets  = nullptr;
+  uint32_t *_field_buckets = nullptr;
 };
 
 // [RFC 7541] 2.3. Indexing Table
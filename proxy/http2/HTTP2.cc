@@ -63,6 +63,8 @@ static const char *const HTTP2_STAT_SESSION_DIE_ACTIVE_NAME      = "proxy.proces
 static const char *const HTTP2_STAT_SESSION_DIE_INACTIVE_NAME    = "proxy.process.http2.session_die_inactive";
 static const char *const HTTP2_STAT_SESSION_DIE_EOS_NAME         = "proxy.process.http2.session_die_eos";
 static const char *const HTTP2_STAT_SESSION_DIE_ERROR_NAME       = "proxy.process.http2.session_die_error";
+static const char *const HTTP2_STAT_WRITE_BATCH_COUNT_NAME       = "proxy.process.http2.write_batches";
+static const char *const HTTP2_STAT_WRITE_BATCH_FRAMES_NAME      = "proxy.process.http2.write_batch_frames";
 
 union byte_pointer {
   byte_pointer(void *p) : ptr(p) {}
@@ -728,6 +730,8 @@ uint32_t Http2::accept_no_activity_timeout = 120;
 uint32_t Http2::no_activity_timeout_in     = 120;
 uint32_t Http2::active_timeout_in          = 0;
 uint32_t Http2::push_diary_size            = 256;
+uint32_t Http2::write_batch_max_bytes      = 65536;
+uint32_t Http2::write_batch_timeout        = 0;
 
 void
 Http2::init()
@@ -745,6 +749,8 @@ Http2::init()
   REC_EstablishStaticConfigInt32U(no_activity_timeout_in, "proxy.config.http2.no_activity_timeout_in");
   REC_EstablishStaticConfigInt32U(active_timeout_in, "proxy.config.http2.active_timeout_in");
   REC_EstablishStaticConfigInt32U(push_diary_size, "proxy.config.http2.push_diary_size");
+  REC_EstablishStaticConfigInt32U(write_batch_max_bytes, "proxy.config.http2.write_batch_max_bytes");
+  REC_EstablishStaticConfigInt32U(write_batch_timeout, "proxy.config.http2.write_batch_timeout");
 
   // If any settings is broken, ATS should not start
   ink_release_assert(http2_settings_parameter_is_valid({HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, max_concurrent_streams_in}));
@@ -790,6 +796,10 @@ Http2::init()
                      static_cast<int>(HTTP2_STAT_SESSION_DIE_INACTIVE), RecRawStatSyncSum);
   RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_SESSION_DIE_ERROR_NAME, RECD_INT, RECP_PERSISTENT,
                      static_cast<int>(HTTP2_STAT_SESSION_DIE_ERROR), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_WRITE_BATCH_COUNT_NAME, RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_WRITE_BATCH_COUNT), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, HTTP2_STAT_WRITE_BATCH_FRAMES_NAME, RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_WRITE_BATCH_FRAMES), RecRawStatSyncSum);
 }
 
 #if TS_HAS_TESTS
@@ -85,6 +85,8 @@ enum {
   HTTP2_STAT_SESSION_DIE_INACTIVE,
   HTTP2_STAT_SESSION_DIE_EOS,
   HTTP2_STAT_SESSION_DIE_ERROR,
+  HTTP2_STAT_WRITE_BATCH_COUNT,  // Number of times the frames sent so far were written out
+  HTTP2_STAT_WRITE_BATCH_FRAMES, // Number of frames in those writes
 
   HTTP2_N_STATS // Terminal counter, NOT A STAT INDEX.
 };
@@ -379,6 +381,8 @@ public:
   static uint32_t no_activity_timeout_in;
   static uint32_t active_timeout_in;
   static uint32_t push_diary_size;
+  static uint32_t write_batch_max_bytes;
+  static uint32_t write_batch_timeout;
 
   static void init();
 };
@@ -76,6 +76,13 @@ Http2ClientSession::destroy()
 void
 Http2ClientSession::free()
 {
+  // A pending flush would reenable the write VIO of the closed VC. Cancel it first, so the deferred
+  // (kill_me) return below does not skip it either.
+  if (write_flush_event) {
+    write_flush_event->cancel();
+    write_flush_event = nullptr;
+  }
+
   if (h2_pushed_urls) {
     this->h2_pushed_urls = ink_hash_table_destroy(this->h2_pushed_urls);
   }
@@ -265,6 +272,9 @@ Http2ClientSession::do_io_close(int alerrno)
   // Don't send the SSN_CLOSE_HOOK until we got rid of all the streams
   // And handled all the TXN_CLOSE_HOOK's
   if (client_vc) {
+    // Don't leave the last frames, e.g. a GOAWAY, waiting for the flush event
+    write_reenable();
+
     // Copy aside the client address before releasing the vc
     cached_client_addr.assign(client_vc->get_remote_addr());
     cached_local_addr.assign(client_vc->get_local_addr());
@@ -281,6 +291,51 @@ Http2ClientSession::reenable(VIO *vio)
   this->client_vc->reenable(vio);
 }
 
+// Write a frame out to the client. The write VIO is reenabled once the batch reaches
+// proxy.config.http2.write_batch_max_bytes, or else at the end of this event loop iteration (or after
+// proxy.config.http2.write_batch_timeout), so frames sent by several streams go out in one write.
+void
+Http2ClientSession::xmit(Http2Frame &frame)
+{
+  total_write_len += frame.size();
+  write_vio->nbytes = total_write_len;
+  frame.xmit(this->write_buffer);
+
+  ++write_batch_frames;
+  write_batch_bytes += frame.size();
+
+  if (write_batch_bytes >= Http2::write_batch_max_bytes) {
+    write_reenable();
+  } else if (write_flush_event == nullptr) {
+    if (Http2::write_batch_timeout == 0) {
+      write_flush_event = this_ethread()->schedule_imm_local(this, HTTP2_SESSION_EVENT_FLUSH);
+    } else {
+      write_flush_event =
+        this_ethread()->schedule_in_local(this, HRTIME_USECONDS(Http2::write_batch_timeout), HTTP2_SESSION_EVENT_FLUSH);
+    }
+  }
+}
+
+void
+Http2ClientSession::write_reenable()
+{
+  if (write_flush_event) {
+    write_flush_event->cancel();
+    write_flush_event = nullptr;
+  }
+
+  if (write_batch_frames == 0) {
+    return;
+  }
+
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_WRITE_BATCH_COUNT, this_ethread());
+  HTTP2_SUM_THREAD_DYN_STAT(HTTP2_STAT_WRITE_BATCH_FRAMES, this_ethread(), write_batch_frames);
+  write_batch_frames = 0;
+  write_batch_bytes  = 0;
+
+  write_vio->reenable();
+}
+
 void
 Http2ClientSession::set_half_close_local_flag(bool flag)
 {
@@ -315,14 +370,17 @@ Http2ClientSession::main_event_handler(int event, void *edata)
 
   case HTTP2_SESSION_EVENT_XMIT: {
     Http2Frame *frame = (Http2Frame *)edata;
-    total_write_len += frame->size();
-    write_vio->nbytes = total_write_len;
-    frame->xmit(this->write_buffer);
-    write_reenable();
+    this->xmit(*frame);
     retval = 0;
     break;
   }
 
+  case HTTP2_SESSION_EVENT_FLUSH:
+    write_flush_event = nullptr;
+    write_reenable();
+    retval = 0;
+    break;
+
   case VC_EVENT_ACTIVE_TIMEOUT:
   case VC_EVENT_INACTIVITY_TIMEOUT:
   case VC_EVENT_ERROR:
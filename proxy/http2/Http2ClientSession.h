@@ -36,6 +36,7 @@
 // HTTP2_SESSION_EVENT_FINI   Http2ClientSession *  HTTP/2 session is ended
 // HTTP2_SESSION_EVENT_RECV   Http2Frame *          Received a frame
 // HTTP2_SESSION_EVENT_XMIT   Http2Frame *          Send this frame
+// HTTP2_SESSION_EVENT_FLUSH  Event *               Write out the frames sent so far
 
 #define HTTP2_SESSION_EVENT_INIT (HTTP2_SESSION_EVENTS_START + 1)
 #define HTTP2_SESSION_EVENT_FINI (HTTP2_SESSION_EVENTS_START + 2)
@@ -43,6 +44,7 @@
 #define HTTP2_SESSION_EVENT_XMIT (HTTP2_SESSION_EVENTS_START + 4)
 #define HTTP2_SESSION_EVENT_SHUTDOWN_INIT (HTTP2_SESSION_EVENTS_START + 5)
 #define HTTP2_SESSION_EVENT_SHUTDOWN_CONT (HTTP2_SESSION_EVENTS_START + 6)
+#define HTTP2_SESSION_EVENT_FLUSH (HTTP2_SESSION_EVENTS_START + 7)
 
 size_t const HTTP2_HEADER_BUFFER_SIZE_INDEX = CLIENT_CONNECTION_FIRST_READ_BUFFER_SIZE_INDEX;
 
@@ -209,11 +211,7 @@ public:
     return client_vc ? client_vc->get_local_addr() : &cached_local_addr.sa;
   }
 
-  void
-  write_reenable()
-  {
-    write_vio->reenable();
-  }
+  void write_reenable();
 
   void set_upgrade_context(HTTPHdr *h);
 
@@ -329,6 +327,8 @@ private:
   // if there are multiple frames ready on the wire
   int state_process_frame_read(int event, VIO *vio, bool inside_frame);
 
+  void xmit(Http2Frame &frame);
+
   int64_t total_write_len        = 0;
   SessionHandler session_handler = nullptr;
   NetVConnection *client_vc      = nullptr;
@@ -350,6 +350,11 @@ private:
   bool half_close_local = false;
   int recursion         = 0;
 
+  // Frames are written to write_buffer right away, but the write VIO is only reenabled once per batch
+  Event *write_flush_event    = nullptr;
+  uint32_t write_batch_frames = 0;
+  uint32_t write_batch_bytes  = 0;
+
   InkHashTable *h2_pushed_urls = nullptr;
   uint32_t h2_pushed_urls_size = 0;
 };
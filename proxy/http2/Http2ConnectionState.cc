@@ -48,6 +48,9 @@ static const int buffer_size_index[HTTP2_FRAME_TYPE_MAX] = {
   BUFFER_SIZE_INDEX_16K, // HTTP2_FRAME_TYPE_CONTINUATION
 };
 
+// Maximum number of DATA frames sent by one HTTP2_SESSION_EVENT_XMIT event
+static const int HTTP2_DATA_FRAMES_PER_XMIT = 16;
+
 inline static unsigned
 read_rcv_buffer(char *buf, size_t bufsize, unsigned &nbytes, const Http2Frame &frame)
 {
@@ -877,8 +880,8 @@ Http2ConnectionState::main_event_handler(int event, void *edata)
 
   case HTTP2_SESSION_EVENT_XMIT: {
     SCOPED_MUTEX_LOCK(lock, this->mutex, this_ethread());
-    send_data_frames_depends_on_priority();
     _scheduled = false;
+    send_data_frames_depends_on_priority();
   } break;
 
   // Parse received HTTP/2 frames
@@ -1204,43 +1207,50 @@ Http2ConnectionState::schedule_stream(Http2Stream *stream)
 void
 Http2ConnectionState::send_data_frames_depends_on_priority()
 {
-  Http2DependencyTree::Node *node = dependency_tree->top();
+  // Send a batch of frames per event, the scheduling is still done frame by frame in the dependency tree. Going back to the
+  // event loop in between lets other connections on this thread make progress.
+  for (int i = 0; i < HTTP2_DATA_FRAMES_PER_XMIT; ++i) {
+    Http2DependencyTree::Node *node = dependency_tree->top();
 
-  // No node to send or no connection level window left
-  if (node == nullptr || client_rwnd <= 0) {
-    return;
-  }
+    // No node to send, no connection level window left, or the session is gone
+    if (node == nullptr || client_rwnd <= 0 || ua_session == nullptr) {
+      return;
+    }
 
-  Http2Stream *stream = static_cast<Http2Stream *>(node->t);
-  ink_release_assert(stream != nullptr);
-  DebugHttp2Stream(ua_session, stream->get_id(), "top node, point=%d", node->point);
+    Http2Stream *stream = static_cast<Http2Stream *>(node->t);
+    ink_release_assert(stream != nullptr);
+    DebugHttp2Stream(ua_session, stream->get_id(), "top node, point=%d", node->point);
 
-  size_t len                       = 0;
-  Http2SendADataFrameResult result = send_a_data_frame(stream, len);
+    size_t len                       = 0;
+    Http2SendADataFrameResult result = send_a_data_frame(stream, len);
 
-  switch (result) {
-  case HTTP2_SEND_A_DATA_FRAME_NO_ERROR: {
-    // No response body to send
-    if (len == 0 && !stream->is_body_done()) {
+    switch (result) {
+    case HTTP2_SEND_A_DATA_FRAME_NO_ERROR: {
+      // No response body to send
+      if (len == 0 && !stream->is_body_done()) {
+        dependency_tree->deactivate(node, len);
+      } else {
+        dependency_tree->update(node, len);
+      }
+      break;
+    }
+    case HTTP2_SEND_A_DATA_FRAME_DONE: {
       dependency_tree->deactivate(node, len);
-    } else {
-      dependency_tree->update(node, len);
+      delete_stream(stream);
+      break;
+    }
+    default:
+      // When no stream level window left, deactivate node once and wait window_update frame
+      dependency_tree->deactivate(node, len);
+      break;
     }
-    break;
-  }
-  case HTTP2_SEND_A_DATA_FRAME_DONE: {
-    dependency_tree->deactivate(node, len);
-    delete_stream(stream);
-    break;
-  }
-  default:
-    // When no stream level window left, deactivate node once and wait window_update frame
-    dependency_tree->deactivate(node, len);
-    break;
   }
 
-  this_ethread()->schedule_imm_local((Continuation *)this, HTTP2_SESSION_EVENT_XMIT);
-  return;
+  // schedule_stream() may already have queued an XMIT while this batch ran
+  if (!_scheduled && dependency_tree->top() != nullptr && client_rwnd > 0 && ua_session != nullptr) {
+    _scheduled = true;
+    this_ethread()->schedule_imm_local((Continuation *)this, HTTP2_SESSION_EVENT_XMIT);
+  }
 }
 
 Http2SendADataFrameResult
@@ -29,7 +29,8 @@
 
 #include "ts/List.h"
 #include "ts/Diags.h"
-#include "ts/PriorityQueue.h"
+#include "ts/Allocator.h"
+#include "ts/Vec.h"
 
 #include "HTTP2.h"
 
@@ -39,38 +40,48 @@ const static uint32_t HTTP2_DEPENDENCY_TREE_MAX_DEPTH = 256;
 
 namespace Http2DependencyTree
 {
-class Node
+class Node;
+
+/**
+   Binary min-heap of the children of a node that have something to send, ordered by point.
+
+   The heap is intrusive, each node keeps its own position in its parent's heap, so it can be
+   updated or erased without searching and without allocating an entry per node.
+ */
+class NodeQueue
 {
 public:
-  Node(void *t = nullptr) : t(t)
+  bool
+  empty() const
   {
-    entry = new PriorityQueueEntry<Node *>(this);
-    queue = new PriorityQueue<Node *>();
+    return _heap.length() == 0;
   }
 
-  Node(uint32_t i, uint32_t w, uint32_t p, Node *n, void *t = nullptr) : id(i), weight(w), point(p), t(t), parent(n)
+  Node *
+  top() const
   {
-    entry = new PriorityQueueEntry<Node *>(this);
-    queue = new PriorityQueue<Node *>();
+    return empty() ? nullptr : _heap[0];
   }
 
-  ~Node()
-  {
-    delete entry;
-    delete queue;
-
-    // delete all child nodes
-    if (!children.empty()) {
-      Node *node = children.head;
-      Node *next = nullptr;
-      while (node) {
-        next = node->link.next;
-        children.remove(node);
-        delete node;
-        node = next;
-      }
-    }
-  }
+  bool in(const Node *node) const;
+  void push(Node *node);
+  void pop();
+  void erase(Node *node);
+  void update(Node *node, bool increased);
+
+private:
+  void _swap(uint32_t i, uint32_t j);
+  void _bubble_up(uint32_t index);
+  void _bubble_down(uint32_t index);
+
+  Vec<Node *> _heap;
+};
+
+class Node
+{
+public:
+  Node(void *t = nullptr) : t(t) {}
+  Node(uint32_t i, uint32_t w, uint32_t p, Node *n, void *t = nullptr) : id(i), weight(w), point(p), t(t), parent(n) {}
 
   LINK(Node, link);
 
@@ -99,16 +110,128 @@ public:
   void *t         = nullptr;
   Node *parent    = nullptr;
   DLL<Node> children;
-  PriorityQueueEntry<Node *> *entry;
-  PriorityQueue<Node *> *queue;
+  NodeQueue queue;
+
+  uint32_t queue_index = 0;       ///< Position in the queue of the parent, when queued.
+  Node *hash_next      = nullptr; ///< Next node in the same bucket of the tree's id index.
 };
 
+extern ClassAllocator<Node> http2DependencyTreeNodeAllocator;
+
+inline bool
+NodeQueue::in(const Node *node) const
+{
+  return node->queue_index < _heap.length() && _heap[node->queue_index] == node;
+}
+
+inline void
+NodeQueue::push(Node *node)
+{
+  node->queue_index = _heap.length();
+  _heap.push_back(node);
+  _bubble_up(node->queue_index);
+}
+
+inline void
+NodeQueue::pop()
+{
+  if (!empty()) {
+    erase(_heap[0]);
+  }
+}
+
+inline void
+NodeQueue::erase(Node *node)
+{
+  // The node might not be in this queue, e.g. when deactivating a node that was never activated.
+  if (!in(node)) {
+    return;
+  }
+
+  uint32_t index = node->queue_index;
+  uint32_t last  = _heap.length() - 1;
+
+  if (index != last) {
+    _swap(index, last);
+    _heap.pop();
+    _bubble_down(index);
+    _bubble_up(index);
+  } else {
+    _heap.pop();
+  }
+}
+
+inline void
+NodeQueue::update(Node *node, bool increased)
+{
+  if (increased) {
+    _bubble_down(node->queue_index);
+  } else {
+    _bubble_up(node->queue_index);
+  }
+}
+
+inline void
+NodeQueue::_swap(uint32_t i, uint32_t j)
+{
+  Node *tmp = _heap[i];
+  _heap[i]  = _heap[j];
+  _heap[j]  = tmp;
+
+  _heap[i]->queue_index = i;
+  _heap[j]->queue_index = j;
+}
+
+inline void
+NodeQueue::_bubble_up(uint32_t index)
+{
+  while (index != 0) {
+    uint32_t parent = (index - 1) / 2;
+    if (!(*_heap[index] < *_heap[parent])) {
+      break;
+    }
+    _swap(parent, index);
+    index = parent;
+  }
+}
+
+inline void
+NodeQueue::_bubble_down(uint32_t index)
+{
+  uint32_t length = _heap.length();
+
+  while (true) {
+    uint32_t left = index * 2 + 1, right = index * 2 + 2, smaller;
+
+    if (left >= length) {
+      break;
+    } else if (right >= length) {
+      smaller = left;
+    } else {
+      smaller = (*_heap[left] < *_heap[right]) ? left : right;
+    }
+
+    if (!(*_heap[smaller] < *_heap[index])) {
+      break;
+    }
+    _swap(smaller, index);
+    index = smaller;
+  }
+}
+
 template <typename T> class Tree
 {
 public:
-  Tree(uint32_t max_concurrent_streams) : _max_depth(MIN(max_concurrent_streams, HTTP2_DEPENDENCY_TREE_MAX_DEPTH)) {}
+  Tree(uint32_t max_concurrent_streams) : _max_depth(MIN(max_concurrent_streams, HTTP2_DEPENDENCY_TREE_MAX_DEPTH))
+  {
+    _root = _alloc_node(HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY, HTTP2_PRIORITY_DEFAULT_WEIGHT, 0, nullptr, this);
+  }
 
-  ~Tree() { delete _root; }
+  ~Tree()
+  {
+    _free_subtree(_root);
+    ats_free(_buckets);
+  }
   Node *find(uint32_t id);
   Node *find_shadow(uint32_t id);
   Node *add(uint32_t parent_id, uint32_t id, uint32_t weight, bool exclusive, T t);
@@ -122,50 +245,115 @@ public:
   uint32_t size() const;
 
 private:
-  Node *_find(Node *node, uint32_t id, uint32_t depth = 1);
+  Node *_find(uint32_t id);
   Node *_top(Node *node);
   void _change_parent(Node *new_parent, Node *node, bool exclusive);
 
-  Node *_root = new Node(this);
+  Node *_alloc_node(uint32_t id, uint32_t weight, uint32_t point, Node *parent, void *t);
+  void _free_node(Node *node);
+  void _free_subtree(Node *node);
+
+  Node *_root = nullptr;
   uint32_t _max_depth;
   uint32_t _node_count = 0;
+
+  // Hash index of all the nodes by id, chained through Node::hash_next. The number of buckets is a
+  // power of 2 and grows with the number of nodes.
+  Node **_buckets        = nullptr;
+  uint32_t _bucket_count = 0;
+  uint32_t _indexed      = 0;
 };
 
 template <typename T>
 Node *
-Tree<T>::_find(Node *node, uint32_t id, uint32_t depth)
+Tree<T>::_alloc_node(uint32_t id, uint32_t weight, uint32_t point, Node *parent, void *t)
 {
-  if (node->id == id) {
-    return node;
-  }
+  Node *node = new (http2DependencyTreeNodeAllocator.alloc()) Node(id, weight, point, parent, t);
 
-  if (node->children.empty() || depth >= _max_depth) {
-    return nullptr;
+  if (_indexed >= _bucket_count) {
+    uint32_t count = _bucket_count ? _bucket_count * 2 : 16;
+    Node **buckets = static_cast<Node **>(ats_calloc(count, sizeof(Node *)));
+
+    for (uint32_t i = 0; i < _bucket_count; ++i) {
+      while (Node *n = _buckets[i]) {
+        _buckets[i]                  = n->hash_next;
+        n->hash_next                 = buckets[n->id & (count - 1)];
+        buckets[n->id & (count - 1)] = n;
+      }
+    }
+    ats_free(_buckets);
+    _buckets      = buckets;
+    _bucket_count = count;
   }
 
-  Node *result = nullptr;
-  for (Node *n = node->children.head; n; n = n->link.next) {
-    result = _find(n, id, ++depth);
-    if (result != nullptr) {
+  Node *&bucket   = _buckets[id & (_bucket_count - 1)];
+  node->hash_next = bucket;
+  bucket          = node;
+  ++_indexed;
+
+  return node;
+}
+
+template <typename T>
+void
+Tree<T>::_free_node(Node *node)
+{
+  for (Node **n = &_buckets[node->id & (_bucket_count - 1)]; *n; n = &(*n)->hash_next) {
+    if (*n == node) {
+      *n = node->hash_next;
+      --_indexed;
       break;
     }
   }
 
-  return result;
+  node->~Node();
+  http2DependencyTreeNodeAllocator.free(node);
+}
+
+template <typename T>
+void
+Tree<T>::_free_subtree(Node *node)
+{
+  while (Node *child = node->children.pop()) {
+    _free_subtree(child);
+  }
+  _free_node(node);
+}
+
+// Nodes deeper than _max_depth can't be found, a dependency on them starts again from the root.
+template <typename T>
+Node *
+Tree<T>::_find(uint32_t id)
+{
+  for (Node *node = _buckets[id & (_bucket_count - 1)]; node; node = node->hash_next) {
+    if (node->id != id) {
+      continue;
+    }
+
+    uint32_t depth = 1;
+    for (Node *n = node->parent; n != nullptr && depth <= _max_depth; n = n->parent) {
+      ++depth;
+    }
+    if (depth <= _max_depth) {
+      return node;
+    }
+  }
+
+  return nullptr;
 }
 
 template <typename T>
 Node *
 Tree<T>::find_shadow(uint32_t id)
 {
-  return _find(_root, id);
+  return _find(id);
 }
 
 template <typename T>
 Node *
 Tree<T>::find(uint32_t id)
 {
-  Node *n = _find(_root, id);
+  Node *n = _find(id);
   return n == nullptr ? nullptr : (n->is_shadow() ? nullptr : n);
 }
 
@@ -187,13 +375,13 @@ Tree<T>::add(uint32_t parent_id, uint32_t id, uint32_t weight, bool exclusive, T
   }
 
   // Use stream id as initial point
-  node = new Node(id, weight, id, parent, t);
+  node = _alloc_node(id, weight, id, parent, t);
 
   if (exclusive) {
     while (Node *child = parent->children.pop()) {
       if (child->queued) {
-        parent->queue->erase(child->entry);
-        node->queue->push(child->entry);
+        parent->queue.erase(child);
+        node->queue.push(child);
       }
       node->children.push(child);
       child->parent = node;
@@ -201,8 +389,8 @@ Tree<T>::add(uint32_t parent_id, uint32_t id, uint32_t weight, bool exclusive, T
   }
 
   parent->children.push(node);
-  if (!node->queue->empty()) {
-    parent->queue->push(node->entry);
+  if (!node->queue.empty()) {
+    parent->queue.push(node);
     node->queued = true;
   }
 
@@ -221,13 +409,13 @@ Tree<T>::remove(Node *node)
   Node *parent = node->parent;
   parent->children.remove(node);
   if (node->queued) {
-    parent->queue->erase(node->entry);
+    parent->queue.erase(node);
   }
 
   // Push queue entries
-  while (!node->queue->empty()) {
-    parent->queue->push(node->queue->top());
-    node->queue->pop();
+  while (Node *child = node->queue.top()) {
+    node->queue.pop();
+    parent->queue.push(child);
   }
 
   // Push children
@@ -238,12 +426,12 @@ Tree<T>::remove(Node *node)
   }
 
   // delete the shadow parent
-  if (parent->is_shadow() && parent->children.empty() && parent->queue->empty()) {
+  if (parent->is_shadow() && parent->children.empty() && parent->queue.empty()) {
     remove(parent);
   }
 
   --_node_count;
-  delete node;
+  _free_node(node);
 }
 
 template <typename T>
@@ -282,7 +470,7 @@ Tree<T>::reprioritize(Node *node, uint32_t new_parent_id, bool exclusive)
   _change_parent(node, new_parent, exclusive);
 
   // delete the shadow node
-  if (node->is_shadow() && node->children.empty() && node->queue->empty()) {
+  if (node->is_shadow() && node->children.empty() && node->queue.empty()) {
     remove(node);
   }
 }
@@ -295,12 +483,12 @@ Tree<T>::_change_parent(Node *node, Node *new_parent, bool exclusive)
   ink_release_assert(node->parent != nullptr);
   node->parent->children.remove(node);
   if (node->queued) {
-    node->parent->queue->erase(node->entry);
+    node->parent->queue.erase(node);
     node->queued = false;
 
     Node *current = node->parent;
-    while (current->queue->empty() && !current->active && current->parent != nullptr) {
-      current->parent->queue->erase(current->entry);
+    while (current->queue.empty() && !current->active && current->parent != nullptr) {
+      current->parent->queue.erase(current);
       current->queued = false;
       current         = current->parent;
     }
@@ -310,8 +498,8 @@ Tree<T>::_change_parent(Node *node, Node *new_parent, bool exclusive)
   if (exclusive) {
     while (Node *child = new_parent->children.pop()) {
       if (child->queued) {
-        child->parent->queue->erase(child->entry);
-        node->queue->push(child->entry);
+        child->parent->queue.erase(child);
+        node->queue.push(child);
       }
 
       node->children.push(child);
@@ -322,10 +510,10 @@ Tree<T>::_change_parent(Node *node, Node *new_parent, bool exclusive)
   new_parent->children.push(node);
   node->parent = new_parent;
 
-  if (node->active || !node->queue->empty()) {
+  if (node->active || !node->queue.empty()) {
     Node *current = node;
     while (current->parent != nullptr && !current->queued) {
-      current->parent->queue->push(current->entry);
+      current->parent->queue.push(current);
       current->queued = true;
       current         = current->parent;
     }
@@ -341,8 +529,8 @@ Tree<T>::_top(Node *node)
   while (child != nullptr) {
     if (child->active) {
       return child;
-    } else if (!child->queue->empty()) {
-      child = child->queue->top()->node;
+    } else if (!child->queue.empty()) {
+      child = child->queue.top();
     } else {
       return nullptr;
     }
@@ -365,7 +553,7 @@ Tree<T>::activate(Node *node)
   node->active = true;
 
   while (node->parent != nullptr && !node->queued) {
-    node->parent->queue->push(node->entry);
+    node->parent->queue.push(node);
     node->queued = true;
     node         = node->parent;
   }
@@ -377,8 +565,8 @@ Tree<T>::deactivate(Node *node, uint32_t sent)
 {
   node->active = false;
 
-  while (node->queue->empty() && node->parent != nullptr) {
-    node->parent->queue->erase(node->entry);
+  while (node->queue.empty() && node->parent != nullptr) {
+    node->parent->queue.erase(node);
     node->queued = false;
 
     node = node->parent;
@@ -395,9 +583,9 @@ Tree<T>::update(Node *node, uint32_t sent)
     node->point += sent * K / (node->weight + 1);
 
     if (node->queued) {
-      node->parent->queue->update(node->entry, true);
+      node->parent->queue.update(node, true);
     } else {
-      node->parent->queue->push(node->entry);
+      node->parent->queue.push(node);
       node->queued = true;
     }
 
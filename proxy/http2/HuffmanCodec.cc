@@ -25,6 +25,7 @@
 #include "ts/ink_platform.h"
 #include "ts/ink_memory.h"
 #include "ts/ink_defs.h"
+#include "ts/ink_assert.h"
 
 struct huffman_entry {
   uint32_t code_as_hex;
@@ -70,124 +71,129 @@ static const huffman_entry huffman_table[] = {
   {0x7ffffe8, 27}, {0x7ffffe9, 27},  {0x7ffffea, 27}, {0x7ffffeb, 27},  {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
   {0x7ffffee, 27}, {0x7ffffef, 27},  {0x7fffff0, 27}, {0x3ffffee, 26},  {0x3fffffff, 30}};
 
-typedef struct node {
-  node *left, *right;
-  char ascii_code;
-  bool leaf_node;
-} Node;
 
-Node *HUFFMAN_TREE_ROOT;
+// The decoder consumes 4 bits at a time. A state is an internal node of the Huffman tree, and the
+// transition for each nibble gives the next state and the symbol completed on the way, if any. No
+// code is shorter than 5 bits, so a nibble completes at most one symbol.
+static const int HUFFMAN_STATES = 256; // internal nodes of a tree with 257 leaves
+static const int HUFFMAN_EOS    = 256; // the last symbol
 
-static Node *
-make_huffman_tree_node()
-{
-  Node *n       = static_cast<Node *>(ats_malloc(sizeof(Node)));
-  n->left       = nullptr;
-  n->right      = nullptr;
-  n->ascii_code = '\0';
-  n->leaf_node  = false;
-  return n;
-}
+struct huffman_transition {
+  uint8_t state;
+  uint8_t emit; // 1 if symbol was completed
+  uint8_t symbol;
+  uint8_t eos; // 1 if EOS was completed, which is a decoding error (RFC 7541 5.2)
+};
+
+static huffman_transition huffman_decode_table[HUFFMAN_STATES][16];
 
-static Node *
-make_huffman_tree()
+// Whether the string can end in this state, i.e. the bits since the last symbol are valid padding:
+// fewer than 8 bits, all of them 1 (the most significant bits of EOS).
+static bool huffman_decode_accept[HUFFMAN_STATES];
+
+static bool huffman_decode_table_ready = false;
+
+static void
+make_huffman_decode_table()
 {
-  Node *root = make_huffman_tree_node();
-  Node *current;
-  uint32_t bit_len;
-  // insert leafs for each ascii code
+  // Build the tree in a flat array, children >= 0 are internal nodes and < 0 are ~symbol.
+  int child[HUFFMAN_STATES][2];
+  int depth[HUFFMAN_STATES];
+  bool all_ones[HUFFMAN_STATES];
+  int n_nodes = 1;
+
+  memset(child, 0, sizeof(child));
+  depth[0]    = 0;
+  all_ones[0] = true;
+
   for (unsigned i = 0; i < countof(huffman_table); i++) {
-    bit_len = huffman_table[i].bit_len;
-    current = root;
-    while (bit_len > 0) {
-      if (huffman_table[i].code_as_hex & (1 << (bit_len - 1))) {
-        if (!current->right) {
-          current->right = make_huffman_tree_node();
-        }
-        current = current->right;
+    int node = 0;
+    for (int bit_len = huffman_table[i].bit_len; bit_len > 0; --bit_len) {
+      int bit = (huffman_table[i].code_as_hex >> (bit_len - 1)) & 1;
+
+      if (bit_len == 1) {
+        child[node][bit] = ~static_cast<int>(i);
       } else {
-        if (!current->left) {
-          current->left = make_huffman_tree_node();
+        if (child[node][bit] == 0) {
+          ink_release_assert(n_nodes < HUFFMAN_STATES);
+          child[node][bit]  = n_nodes;
+          depth[n_nodes]    = depth[node] + 1;
+          all_ones[n_nodes] = all_ones[node] && bit;
+          ++n_nodes;
         }
-        current = current->left;
+        node = child[node][bit];
       }
-      bit_len--;
     }
-    current->ascii_code = i;
-    current->leaf_node  = true;
   }
-  return root;
-}
 
-static void
-free_huffman_tree(Node *node)
-{
-  if (node->left) {
-    free_huffman_tree(node->left);
-  }
-  if (node->right) {
-    free_huffman_tree(node->right);
+  for (int state = 0; state < HUFFMAN_STATES; ++state) {
+    huffman_decode_accept[state] = state == 0 || (all_ones[state] && depth[state] < 8);
+
+    for (int nibble = 0; nibble < 16; ++nibble) {
+      huffman_transition &t = huffman_decode_table[state][nibble];
+      int node              = state;
+
+      t.emit   = 0;
+      t.symbol = 0;
+      t.eos    = 0;
+      for (int shift = 3; shift >= 0; --shift) {
+        node = child[node][(nibble >> shift) & 1];
+        if (node < 0) {
+          if (~node == HUFFMAN_EOS) {
+            t.eos = 1;
+          } else {
+            t.emit   = 1;
+            t.symbol = static_cast<uint8_t>(~node);
+          }
+          node = 0;
+        }
+      }
+      t.state = node;
+    }
   }
-
-  ats_free(node);
 }
 
 void
 hpack_huffman_init()
 {
-  if (!HUFFMAN_TREE_ROOT) {
-    HUFFMAN_TREE_ROOT = make_huffman_tree();
+  if (!huffman_decode_table_ready) {
+    make_huffman_decode_table();
+    huffman_decode_table_ready = true;
   }
 }
 
 void
 hpack_huffman_fin()
 {
-  if (HUFFMAN_TREE_ROOT) {
-    free_huffman_tree(HUFFMAN_TREE_ROOT);
-  }
+  // The decode table is static, there is nothing to release.
 }
 
 int64_t
 huffman_decode(char *dst_start, const uint8_t *src, uint32_t src_len)
 {
-  char *dst_end             = dst_start;
-  uint8_t shift             = 7;
-  Node *current             = HUFFMAN_TREE_ROOT;
-  int byte_boundary_crossed = 0;
-  bool includes_zero        = false;
-
-  while (src_len) {
-    if (*src & (1 << shift)) {
-      current = current->right;
-    } else {
-      current       = current->left;
-      includes_zero = true;
-    }
+  char *dst_end      = dst_start;
+  const uint8_t *end = src + src_len;
+  uint8_t state      = 0;
+
+  ink_assert(huffman_decode_table_ready);
 
-    if (current->leaf_node == true) {
-      *dst_end = current->ascii_code;
-      ++dst_end;
-      current               = HUFFMAN_TREE_ROOT;
-      byte_boundary_crossed = 0;
-      includes_zero         = false;
+  for (; src < end; ++src) {
+    const huffman_transition &high = huffman_decode_table[state][*src >> 4];
+    if (high.emit) {
+      *dst_end++ = high.symbol;
     }
-    if (shift) {
-      --shift;
-    } else {
-      shift = 7;
-      ++src;
-      --src_len;
-      ++byte_boundary_crossed;
+
+    const huffman_transition &low = huffman_decode_table[high.state][*src & 0xf];
+    if (low.emit) {
+      *dst_end++ = low.symbol;
     }
-    if (byte_boundary_crossed > 3) {
+    if (unlikely(high.eos | low.eos)) {
       return -1;
     }
+    state = low.state;
   }
-  if (byte_boundary_crossed > 1) {
-    return -1;
-  }
-  if (includes_zero) {
+
+  if (!huffman_decode_accept[state]) {
     return -1;
   }
 
@@ -207,36 +213,29 @@ int64_t
 huffman_encode(uint8_t *dst_start, const uint8_t *src, uint32_t src_len)
 {
   uint8_t *dst = dst_start;
-  // NOTE: The maximum length of Huffman Code is 30, thus using uint32_t as buffer.
-  uint32_t buf         = 0;
-  uint32_t remain_bits = 32;
+  // NOTE: The maximum length of Huffman Code is 30, so less than 32 pending bits plus one code
+  // always fit in 64 bits. Whole 32 bit words are written out as soon as they are complete.
+  uint64_t buf  = 0;
+  uint32_t bits = 0;
 
   for (uint32_t i = 0; i < src_len; ++i) {
-    const uint32_t hex     = huffman_table[src[i]].code_as_hex;
-    const uint32_t bit_len = huffman_table[src[i]].bit_len;
-
-    if (remain_bits > bit_len) {
-      remain_bits = remain_bits - bit_len;
-      buf |= hex << remain_bits;
-    } else if (remain_bits == bit_len) {
-      buf |= hex;
-      dst         = huffman_encode_append(dst, buf);
-      remain_bits = 32;
-      buf         = 0;
-    } else {
-      buf |= hex >> (bit_len - remain_bits);
-      dst         = huffman_encode_append(dst, buf);
-      remain_bits = (32 - (bit_len - remain_bits));
-      buf         = hex << remain_bits;
+    const huffman_entry &code = huffman_table[src[i]];
+
+    buf = (buf << code.bit_len) | code.code_as_hex;
+    bits += code.bit_len;
+    if (bits >= 32) {
+      bits -= 32;
+      dst = huffman_encode_append(dst, static_cast<uint32_t>(buf >> bits));
     }
   }
 
-  dst = huffman_encode_append(dst, buf, remain_bits / 8);
-
   // NOTE: Add padding w/ EOS
-  uint32_t pad_len = remain_bits % 8;
-  if (pad_len) {
-    *(dst - 1) |= 0xff >> (8 - pad_len);
+  uint32_t pad_len = (8 - bits % 8) % 8;
+  buf              = (buf << pad_len) | ((1u << pad_len) - 1);
+  bits += pad_len;
+
+  if (bits) {
+    dst = huffman_encode_append(dst, static_cast<uint32_t>(buf << (32 - bits)), 4 - bits / 8);
   }
 
   return dst - dst_start;
@@ -25,6 +25,9 @@
 #include "HuffmanCodec.h"
 #include "ts/TestBox.h"
 
+#include <deque>
+#include <string>
+
 // Constants for regression test
 const static int DYNAMIC_TABLE_SIZE_FOR_REGRESSION_TEST = 256;
 const static int BUFSIZE_FOR_REGRESSION_TEST            = 128;
@@ -449,6 +452,116 @@ REGRESSION_TEST(HPACK_Encode)(RegressionTest *t, int, int *pstatus)
   }
 }
 
+REGRESSION_TEST(HPACK_Lookup)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  HpackIndexingTable indexing_table(4096);
+  indexing_table.update_maximum_size(128);
+  ats_scoped_obj<HTTPHdr> headers(new HTTPHdr);
+  headers->create(HTTP_TYPE_RESPONSE);
+
+  auto add = [&](const char *name, const char *value) {
+    MIMEField *field = mime_field_create(headers->m_heap, headers->m_http->m_fields_impl);
+    field->name_set(headers->m_heap, headers->m_http->m_fields_impl, name, strlen(name));
+    field->value_set(headers->m_heap, headers->m_http->m_fields_impl, value, strlen(value));
+    indexing_table.add_header_field(field);
+  };
+  auto check = [&](const char *name, const char *value, int index, HpackIndex index_type, HpackMatch match_type) {
+    HpackLookupResult result = indexing_table.lookup(name, strlen(name), value, strlen(value));
+    box.check(result.index == index && result.index_type == index_type && result.match_type == match_type,
+              "%s: %s was found at %d, expecting %d", name, value, result.index, index);
+  };
+
+  check(":method", "GET", 2, HpackIndex::STATIC, HpackMatch::EXACT);
+  check(":method", "PUT", 2, HpackIndex::STATIC, HpackMatch::NAME);
+  check(":status", "404", 13, HpackIndex::STATIC, HpackMatch::EXACT);
+  check("Content-Type", "text/html", 31, HpackIndex::STATIC, HpackMatch::NAME);
+  check("x-custom", "a", 0, HpackIndex::NONE, HpackMatch::NONE);
+
+  add("x-custom", "a");
+  add("x-custom", "b");
+  check("x-custom", "b", 62, HpackIndex::DYNAMIC, HpackMatch::EXACT);
+  check("X-Custom", "a", 63, HpackIndex::DYNAMIC, HpackMatch::EXACT);
+  check("x-custom", "c", 62, HpackIndex::DYNAMIC, HpackMatch::NAME);
+
+  // Evicts "x-custom: a"
+  add("content-type", "text/html");
+  check("content-type", "text/html", 62, HpackIndex::DYNAMIC, HpackMatch::EXACT);
+  check("content-type", "text/plain", 31, HpackIndex::STATIC, HpackMatch::NAME);
+  check("x-custom", "a", 63, HpackIndex::DYNAMIC, HpackMatch::NAME);
+  check("x-custom", "b", 63, HpackIndex::DYNAMIC, HpackMatch::EXACT);
+
+  indexing_table.update_maximum_size(0);
+  check("x-custom", "b", 0, HpackIndex::NONE, HpackMatch::NONE);
+  check("content-type", "text/html", 31, HpackIndex::STATIC, HpackMatch::NAME);
+}
+
+REGRESSION_TEST(HPACK_DynamicTable)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  const uint32_t table_sizes[] = {512, 300, 150, 4096, 0, 700};
+  HpackIndexingTable indexing_table(table_sizes[0]);
+  std::deque<std::pair<std::string, std::string>> expected; // newest first
+  uint32_t expected_size = 0;
+
+  ats_scoped_obj<HTTPHdr> headers(new HTTPHdr);
+  headers->create(HTTP_TYPE_RESPONSE);
+  MIMEField *field = mime_field_create(headers->m_heap, headers->m_http->m_fields_impl);
+  MIMEFieldWrapper header(field, headers->m_heap, headers->m_http->m_fields_impl);
+
+  auto evict = [&](uint32_t maximum_size) {
+    while (expected_size > maximum_size) {
+      expected_size -= 32 + expected.back().first.size() + expected.back().second.size();
+      expected.pop_back();
+    }
+  };
+
+  // Entries of many sizes, so that the data wraps around, gets compacted and resized.
+  for (int i = 0; i < 3000; ++i) {
+    uint32_t maximum_size = table_sizes[(i / 300) % countof(table_sizes)];
+    if (i % 300 == 0) {
+      evict(maximum_size);
+      indexing_table.update_maximum_size(maximum_size);
+    }
+
+    std::string name  = "x-test-" + std::to_string(i % 37);
+    std::string value = std::string((i * 7) % 180, 'a' + i % 26);
+    field->name_set(headers->m_heap, headers->m_http->m_fields_impl, name.data(), name.size());
+    field->value_set(headers->m_heap, headers->m_http->m_fields_impl, value.data(), value.size());
+    indexing_table.add_header_field(field);
+
+    uint32_t entry_size = 32 + name.size() + value.size();
+    if (entry_size > maximum_size) {
+      evict(0);
+    } else {
+      evict(maximum_size - entry_size);
+      expected.emplace_front(name, value);
+      expected_size += entry_size;
+
+      HpackLookupResult result = indexing_table.lookup(name.data(), name.size(), value.data(), value.size());
+      box.check(result.index == 62 && result.match_type == HpackMatch::EXACT, "newest entry was found at %d", result.index);
+    }
+
+    box.check(indexing_table.size() == expected_size, "dynamic table is unexpected size: %d, expecting %d", indexing_table.size(),
+              expected_size);
+    for (unsigned j = 0; j < expected.size(); ++j) {
+      int name_len, value_len;
+
+      box.check(indexing_table.get_header_field(62 + j, header) == 0, "entry %u is missing", j);
+      const char *entry_name  = header.name_get(&name_len);
+      const char *entry_value = header.value_get(&value_len);
+      box.check(std::string(entry_name, name_len) == expected[j].first && std::string(entry_value, value_len) == expected[j].second,
+                "entry %u is unexpected", j);
+    }
+    box.check(indexing_table.get_header_field(62 + expected.size(), header) == HPACK_ERROR_COMPRESSION_ERROR,
+              "dynamic table has more entries than expected");
+  }
+}
+
 REGRESSION_TEST(HPACK_DecodeInteger)(RegressionTest *t, int, int *pstatus)
 {
   TestBox box(t, pstatus);
@@ -21,6 +21,8 @@
     limitations under the License.
 */
 
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <cstring>
 #include <sstream>
@@ -600,13 +602,13 @@ REGRESSION_TEST(Http2DependencyTree_reprioritize_2)(RegressionTest *t, int /* at
   Node *node_d = tree->find(7);
 
   tree->activate(node_b);
-  box.check(node_x->queue->in(node_a->entry), "A should be in x's queue");
+  box.check(node_x->queue.in(node_a), "A should be in x's queue");
 
   tree->reprioritize(1, 7, true);
 
-  box.check(!node_x->queue->in(node_a->entry), "A should not be in x's queue");
-  box.check(node_x->queue->in(node_d->entry), "D should be in x's queue");
-  box.check(node_d->queue->in(node_a->entry), "A should be in d's queue");
+  box.check(!node_x->queue.in(node_a), "A should not be in x's queue");
+  box.check(node_x->queue.in(node_d), "D should be in x's queue");
+  box.check(node_d->queue.in(node_a), "A should be in d's queue");
 
   delete tree;
 }
@@ -648,11 +650,11 @@ REGRESSION_TEST(Http2DependencyTree_reprioritize_3)(RegressionTest *t, int /* at
   tree->activate(node_f);
   tree->reprioritize(1, 7, true);
 
-  box.check(node_a->queue->in(node_f->entry), "F should be in A's queue");
-  box.check(node_d->queue->in(node_a->entry), "A should be in D's queue");
-  box.check(node_x->queue->in(node_d->entry), "D should be in x's queue");
-  box.check(!node_a->queue->in(node_c->entry), "C should not be in A's queue");
-  box.check(node_c->queue->empty(), "C's queue should be empty");
+  box.check(node_a->queue.in(node_f), "F should be in A's queue");
+  box.check(node_d->queue.in(node_a), "A should be in D's queue");
+  box.check(node_x->queue.in(node_d), "D should be in x's queue");
+  box.check(!node_a->queue.in(node_c), "C should not be in A's queue");
+  box.check(node_c->queue.empty(), "C's queue should be empty");
 
   delete tree;
 }
@@ -767,11 +769,60 @@ REGRESSION_TEST(Http2DependencyTree_max_depth)(RegressionTest *t, int /* atype A
   delete tree;
 }
 
+// Not run by default, use "test_Http2DependencyTree --benchmark".
+static void
+benchmark()
+{
+  string data("data");
+
+  for (uint32_t n : {100, 1000, 10000}) {
+    for (bool chain : {false, true}) {
+      // Chrome makes every stream depend on the previous one, others use mostly flat trees.
+      Tree *tree = new Tree(n);
+      Node **nodes = new Node *[n];
+
+      auto start = chrono::steady_clock::now();
+      for (uint32_t i = 0; i < n; ++i) {
+        uint32_t id = i * 2 + 1;
+        nodes[i]    = tree->add(chain && i ? id - 2 : 0, id, 1 + i % 256, false, &data);
+      }
+      double add = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / n;
+
+      for (uint32_t i = 0; i < n; ++i) {
+        tree->activate(nodes[i]);
+      }
+
+      const uint32_t frames = 100000;
+      start                 = chrono::steady_clock::now();
+      for (uint32_t i = 0; i < frames; ++i) {
+        tree->update(tree->top(), 16384);
+      }
+      double send = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / frames;
+
+      start = chrono::steady_clock::now();
+      for (uint32_t i = 0; i < n; ++i) {
+        tree->deactivate(nodes[i], 0);
+        tree->remove(nodes[i]);
+      }
+      double remove = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / n;
+
+      printf("%5u streams, %s: add %.0f ns, top + update %.0f ns, deactivate + remove %.0f ns\n", n, chain ? "chain" : "flat ", add,
+             send, remove);
+      delete[] nodes;
+      delete tree;
+    }
+  }
+}
+
 int
-main(int /* argc ATS_UNUSED */, const char ** /* argv ATS_UNUSED */)
+main(int argc, const char **argv)
 {
   const char *name = "Http2DependencyTree";
   RegressionTest::run(name, REGRESSION_TEST_QUICK);
 
+  if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+    benchmark();
+  }
+
   return RegressionTest::final_status == REGRESSION_TEST_PASSED ? 0 : 1;
 }
@@ -25,7 +25,9 @@
 #include <cstdlib>
 #include <iostream>
 #include <cassert>
+#include <chrono>
 #include <cstring>
+#include <cstdio>
 
 using namespace std;
 
@@ -134,7 +136,12 @@ values_test()
     encoded_mapped.y[2] = encoded.y[1];
     encoded_mapped.y[3] = encoded.y[0];
 
-    int bytes        = huffman_decode(dst_start, encoded_mapped.y, encoded_size);
+    int bytes = huffman_decode(dst_start, encoded_mapped.y, encoded_size);
+    if (i / 2 == 256) {
+      // EOS in a string is a decoding error
+      assert(bytes == -1);
+      continue;
+    }
     char ascii_value = i / 2;
     assert(dst_start[0] == ascii_value);
     assert(bytes == 1);
@@ -171,8 +178,89 @@ encode_test()
   }
 }
 
+void
+roundtrip_test()
+{
+  uint8_t src[256];
+  uint8_t encoded[sizeof(src) * 4];
+  char decoded[sizeof(encoded) * 2];
+
+  for (int i = 0; i < 1000; i++) {
+    uint32_t src_len = lrand48() % sizeof(src);
+    for (uint32_t j = 0; j < src_len; j++) {
+      // coverity[dont_call]
+      src[j] = lrand48();
+    }
+
+    int64_t encoded_len = huffman_encode(encoded, src, src_len);
+    int64_t decoded_len = huffman_decode(decoded, encoded, encoded_len);
+
+    assert(decoded_len == src_len);
+    assert(memcmp(decoded, src, src_len) == 0);
+  }
+}
+
+void
+padding_test()
+{
+  char dst[4];
+
+  // '0' is 00000, followed by three bits of padding
+  assert(huffman_decode(dst, (const uint8_t *)"\x07", 1) == 1);
+  // The padding must be the most significant bits of EOS
+  assert(huffman_decode(dst, (const uint8_t *)"\x06", 1) == -1);
+  // and shorter than 8 bits
+  assert(huffman_decode(dst, (const uint8_t *)"\x07\xff", 2) == -1);
+}
+
+void
+eos_test()
+{
+  char dst[8];
+
+  // EOS followed by two bits of padding
+  assert(huffman_decode(dst, (const uint8_t *)"\xff\xff\xff\xff", 4) == -1);
+  // 'a' is 00011, followed by EOS and five bits of padding
+  assert(huffman_decode(dst, (const uint8_t *)"\x1f\xff\xff\xff\xff", 5) == -1);
+  // EOS in the middle of a string, 'a' EOS 'a'
+  assert(huffman_decode(dst, (const uint8_t *)"\x1f\xff\xff\xff\xe3", 5) == -1);
+}
+
+// Not run by default, use "test_Huffmancode --benchmark".
+void
+benchmark()
+{
+  const int iterations = 20000;
+  char cookie[4096];
+  int cookie_len = 0;
+
+  while (cookie_len < static_cast<int>(sizeof(cookie)) - 64) {
+    cookie_len += snprintf(cookie + cookie_len, sizeof(cookie) - cookie_len, "_session_%ld=%lx%lx; ", lrand48() % 100, lrand48(),
+                           lrand48());
+  }
+
+  uint8_t encoded[sizeof(cookie) * 4];
+  char decoded[sizeof(encoded) * 2];
+  int64_t encoded_len = huffman_encode(encoded, (const uint8_t *)cookie, cookie_len);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    huffman_decode(decoded, encoded, encoded_len);
+  }
+  double decode_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    huffman_encode(encoded, (const uint8_t *)cookie, cookie_len);
+  }
+  double encode_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%d byte cookie: decode %.1f MB/s, encode %.1f MB/s\n", cookie_len, cookie_len * iterations / decode_time / 1e6,
+         cookie_len * iterations / encode_time / 1e6);
+}
+
 int
-main()
+main(int argc, char *argv[])
 {
   hpack_huffman_init();
 
@@ -180,6 +268,13 @@ main()
     random_test();
   }
   values_test();
+  roundtrip_test();
+  padding_test();
+  eos_test();
+
+  if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+    benchmark();
+  }
 
   hpack_huffman_fin();
 
@@ -42,6 +42,7 @@
 #include "LogObject.h"
 #include "LogConfig.h"
 #include "LogBuffer.h"
+#include "LogColumnBlock.h"
 #include "LogUtils.h"
 #include "LogSock.h"
 #include "Log.h"
@@ -116,6 +117,69 @@ follow_rotate(const char *input_file, ino_t old_inode_num)
   }
 }
 
+// Read the columnar block whose first 8 bytes are in @a start, and write
+// its entries out as ascii.
+static int
+process_column_block(int in_fd, int out_fd, const char *start, unsigned start_size)
+{
+  LogColumnBlockHeader block_header;
+  char *block;
+  int nread;
+
+  memcpy(&block_header, start, start_size);
+  nread = read(in_fd, reinterpret_cast<char *>(&block_header) + start_size, sizeof(block_header) - start_size);
+  if (nread != static_cast<int>(sizeof(block_header) - start_size)) {
+    if (follow_flag) {
+      return 0;
+    }
+
+    fprintf(stderr, "Bad LogColumnBlockHeader read!\n");
+    return 1;
+  }
+
+  // Check the size before allocating, a corrupt header could ask for up to 4GB.
+  if (block_header.byte_count <= sizeof(block_header) || block_header.byte_count > LogColumnBlock::MAX_BLOCK_BYTES ||
+      block_header.buffer_count > LogColumnBlock::MAX_BUFFER_BYTES) {
+    fprintf(stderr, "Bad LogColumnBlock size!\n");
+    return 1;
+  }
+
+  int block_bytes = block_header.byte_count - sizeof(block_header);
+  block           = static_cast<char *>(ats_malloc(block_header.byte_count));
+  memcpy(block, &block_header, sizeof(block_header));
+
+  // Read the rest of the block (allowing for "partial" reads)
+  nread = 0;
+  while (nread < block_bytes) {
+    int rc = read(in_fd, block + sizeof(block_header) + nread, block_bytes - nread);
+
+    if ((rc <= 0) && (!follow_flag)) {
+      fprintf(stderr, "Bad LogColumnBlock read!\n");
+      ats_free(block);
+      return 1;
+    }
+
+    if (rc > 0) {
+      nread += rc;
+    }
+  }
+
+  LogBufferHeader *header = LogColumnBlock::decode(block, block_header.byte_count);
+  ats_free(block);
+
+  if (header == nullptr) {
+    fprintf(stderr, "Bad LogColumnBlock!\n");
+    return 1;
+  }
+
+  if (header->fmt_fieldlist()) {
+    LogFile::write_ascii_logbuffer(header, out_fd, ".", NULL);
+  }
+  ats_free(header);
+
+  return 0;
+}
+
 static int
 process_file(int in_fd, int out_fd)
 {
@@ -141,6 +205,14 @@ process_file(int in_fd, int out_fd)
       return 0;
     }
 
+    // columnar log files hold compressed blocks rather than logbuffers
+    //
+    if (nread == static_cast<int>(first_read_size) && header->cookie == LOG_COLUMN_BLOCK_COOKIE) {
+      if (process_column_block(in_fd, out_fd, buffer, first_read_size) != 0) {
+        return 1;
+      }
+      continue;
+    }
     // ensure that this is a valid logbuffer header
     //
     if (header->cookie != LOG_SEGMENT_COOKIE) {
@@ -295,8 +367,9 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
   int error = NO_ERROR;
 
   if (n_file_arguments) {
-    int bin_ext_len   = strlen(LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION);
-    int ascii_ext_len = strlen(LOG_FILE_ASCII_OBJECT_FILENAME_EXTENSION);
+    int bin_ext_len      = strlen(LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION);
+    int columnar_ext_len = strlen(LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION);
+    int ascii_ext_len    = strlen(LOG_FILE_ASCII_OBJECT_FILENAME_EXTENSION);
 
     for (unsigned i = 0; i < n_file_arguments; ++i) {
       int in_fd = open(file_arguments[i], O_RDONLY);
@@ -316,13 +389,17 @@ main(int /* argc ATS_UNUSED */, const char *argv[])
         posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 #endif
         if (auto_filenames) {
-          // change .blog to .log
+          // change .blog or .clog to .log
           //
           int n = strlen(file_arguments[i]);
           int copy_len =
             (n >= bin_ext_len ?
                (strcmp(&file_arguments[i][n - bin_ext_len], LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION) == 0 ? n - bin_ext_len : n) :
                n);
+          if (copy_len == n && n >= columnar_ext_len &&
+              strcmp(&file_arguments[i][n - columnar_ext_len], LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION) == 0) {
+            copy_len = n - columnar_ext_len;
+          }
 
           char *out_filename = (char *)ats_malloc(copy_len + ascii_ext_len + 1);
 
@@ -55,6 +55,9 @@
 
 #include "ts/ink_apidefs.h"
 
+#include <algorithm>
+#include <vector>
+
 #define PERIODIC_TASKS_INTERVAL_FALLBACK 5
 
 // Log global objects
@@ -1249,14 +1252,20 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
   ink_hrtime now, last_time = 0;
   int len, total_bytes;
   SLL<LogFlushData, LogFlushData::Link_link> link, invert_link;
+  std::vector<LogFlushData *> ready;
+  std::vector<LogFile *> waiting; // files holding back data, see LogFile::order_flush_data()
   ProxyMutex *mutex = this_thread()->mutex.get();
 
+  // how often to check on the data held back, well below the time the files wait for missing buffers
+  const int FLUSH_ORDER_POLL_MSEC = 1000;
+
   Log::flush_notify->lock();
 
   while (true) {
-    if (unlikely(shutdown_event_system == true)) {
-      return nullptr;
-    }
+    // on shutdown, write what is queued one last time
+    //
+    bool shutdown = shutdown_event_system;
+
     fdata = (LogFlushData *)ink_atomiclist_popall(flush_data_list);
 
     // invert the list
@@ -1266,13 +1275,43 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
       invert_link.push(fdata);
     }
 
-    // process each flush data
+    // put the data of each file back in order
     //
+    now = Thread::get_hrtime();
     while ((fdata = invert_link.pop())) {
+      LogFile *logfile = fdata->m_logfile.get();
+
+      if (logfile->order_flush_data(fdata, now, ready) && std::find(waiting.begin(), waiting.end(), logfile) == waiting.end()) {
+        waiting.push_back(logfile);
+      }
+    }
+    // the data held back keeps the files alive, forget about them once
+    // they are not holding back anything; on shutdown, stop waiting for
+    // the missing buffers altogether
+    waiting.erase(std::remove_if(waiting.begin(), waiting.end(),
+                                 [&](LogFile *logfile) {
+                                   if (shutdown) {
+                                     logfile->drain_flush_data(ready);
+                                     return true;
+                                   }
+                                   return !logfile->expire_flush_data(now, ready);
+                                 }),
+                  waiting.end());
+
+    // process each flush data
+    //
+    for (size_t i = 0; i < ready.size(); ++i) {
+      fdata             = ready[i];
       char *buf         = nullptr;
       int bytes_written = 0;
       LogFile *logfile  = fdata->m_logfile.get();
 
+      if (fdata->m_data == nullptr) {
+        // nothing to write for this buffer
+        delete fdata;
+        continue;
+      }
+
       if (logfile->m_file_format == LOG_FILE_BINARY) {
         logbuffer                      = (LogBuffer *)fdata->m_data;
         LogBufferHeader *buffer_header = logbuffer->header();
@@ -1280,7 +1319,8 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
         buf         = (char *)buffer_header;
         total_bytes = buffer_header->byte_count;
 
-      } else if (logfile->m_file_format == LOG_FILE_ASCII || logfile->m_file_format == LOG_FILE_PIPE) {
+      } else if (logfile->m_file_format == LOG_FILE_ASCII || logfile->m_file_format == LOG_FILE_PIPE ||
+                 logfile->m_file_format == LOG_FILE_COLUMNAR) {
         buf         = (char *)fdata->m_data;
         total_bytes = fdata->m_len;
 
@@ -1336,6 +1376,11 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
 
       delete fdata;
     }
+    ready.clear();
+
+    if (unlikely(shutdown)) {
+      break;
+    }
 
     // Time to work on periodic events??
     //
@@ -1348,12 +1393,16 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
 
     // wait for more work; a spurious wake-up is ok since we'll just
     // check the queue and find there is nothing to do, then wait
-    // again.
+    // again. While files hold data back, wake up anyway to give up on
+    // the buffers that don't show up.
     //
-    Log::flush_notify->wait();
+    if (waiting.empty()) {
+      Log::flush_notify->wait();
+    } else {
+      Log::flush_notify->timedwait(FLUSH_ORDER_POLL_MSEC);
+    }
   }
 
-  /* NOTREACHED */
   Log::flush_notify->unlock();
   return nullptr;
 }
@@ -1498,9 +1547,15 @@ Log::match_logobject(LogBufferHeader *header)
     LogFormat fmt("__collation_format__", header->fmt_fieldlist(), header->fmt_printf());
 
     if (fmt.valid()) {
-      LogFileFormat file_format = header->log_object_flags & LogObject::BINARY ?
-                                    LOG_FILE_BINARY :
-                                    (header->log_object_flags & LogObject::WRITES_TO_PIPE ? LOG_FILE_PIPE : LOG_FILE_ASCII);
+      LogFileFormat file_format = LOG_FILE_ASCII;
+
+      if (header->log_object_flags & LogObject::COLUMNAR) {
+        file_format = LOG_FILE_COLUMNAR;
+      } else if (header->log_object_flags & LogObject::BINARY) {
+        file_format = LOG_FILE_BINARY;
+      } else if (header->log_object_flags & LogObject::WRITES_TO_PIPE) {
+        file_format = LOG_FILE_PIPE;
+      }
 
       obj = new LogObject(&fmt, Log::config->logfile_dir, header->log_filename(), file_format, nullptr,
                           (Log::RollingEnabledValues)Log::config->rolling_enabled, Log::config->collation_preproc_threads,
@@ -82,6 +82,8 @@ public:
   LogBuffer *logbuffer = nullptr;
   void *m_data;
   int m_len;
+  uint64_t m_seq = 0;    // LogBuffer::m_flush_seq of the buffer the data comes from
+  bool m_last    = true; // last piece of data of that buffer
 
   LogFlushData(LogFile *logfile, void *data, int len = -1) : m_logfile(logfile), m_data(data), m_len(len) {}
   ~LogFlushData()
@@ -89,10 +91,13 @@ public:
     switch (m_logfile->m_file_format) {
     case LOG_FILE_BINARY:
       logbuffer = (LogBuffer *)m_data;
-      LogBuffer::destroy(logbuffer);
+      if (logbuffer) {
+        LogBuffer::destroy(logbuffer);
+      }
       break;
     case LOG_FILE_ASCII:
     case LOG_FILE_PIPE:
+    case LOG_FILE_COLUMNAR:
       free(m_data);
       break;
     case N_LOGFILE_TYPES:
@@ -877,6 +877,19 @@ LogAccess::unmarshal_int(char **buf)
   number.
   -------------------------------------------------------------------------*/
 
+// The two digits of each number from 0 to 99, so that unmarshal_itoa()
+// only divides once for every two digits.
+static const char itoa_digit_pairs[] = "00010203040506070809"
+                                       "10111213141516171819"
+                                       "20212223242526272829"
+                                       "30313233343536373839"
+                                       "40414243444546474849"
+                                       "50515253545556575859"
+                                       "60616263646566676869"
+                                       "70717273747576777879"
+                                       "80818283848586878889"
+                                       "90919293949596979899";
+
 int
 LogAccess::unmarshal_itoa(int64_t val, char *dest, int field_width, char leading_char)
 {
@@ -892,9 +905,20 @@ LogAccess::unmarshal_itoa(int64_t val, char *dest, int field_width, char leading
     return (int)(dest - p);
   }
 
-  while (val) {
-    *p-- = '0' + (val % 10);
-    val /= 10;
+  uint64_t v = val;
+
+  while (v >= 100) {
+    const char *pair = &itoa_digit_pairs[(v % 100) * 2];
+    v /= 100;
+    *p-- = pair[1];
+    *p-- = pair[0];
+  }
+  if (v >= 10) {
+    const char *pair = &itoa_digit_pairs[v * 2];
+    *p--             = pair[1];
+    *p--             = pair[0];
+  } else {
+    *p-- = '0' + v;
   }
   while (dest - p < field_width) {
     *p-- = leading_char;
@@ -1029,10 +1053,29 @@ LogAccess::unmarshal_ttmsf(char **buf, char *dest, int len)
   ink_assert(*buf != nullptr);
   ink_assert(dest != nullptr);
 
-  int64_t val = unmarshal_int(buf);
-  double secs = (double)val / 1000;
-  int val_len = snprintf(dest, len, "%.3f", secs);
-  return val_len;
+  // This is "%.3f" of val / 1000, the squid timestamp, without the
+  // floating point and printf.
+  char val_buf[32];
+  int64_t val   = unmarshal_int(buf);
+  uint64_t msec = val < 0 ? -(uint64_t)val : val;
+  char *p       = val_buf + sizeof(val_buf) - 1;
+
+  for (int i = 0; i < 3; i++) {
+    *p-- = '0' + msec % 10;
+    msec /= 10;
+  }
+  *p-- = '.';
+  p -= unmarshal_itoa(msec, p);
+  if (val < 0) {
+    *p-- = '-';
+  }
+
+  int val_len = (int)(val_buf + sizeof(val_buf) - 1 - p);
+  if (val_len < len) {
+    memcpy(dest, p + 1, val_len);
+    return val_len;
+  }
+  return -1;
 }
 
 int
@@ -1488,3 +1531,62 @@ resolve_logfield_string(LogAccess *context, const char *format_str)
 
   return result;
 }
+
+#if TS_HAS_TESTS
+#include "ts/TestBox.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+// Format @a val with unmarshal_int_to_str() or unmarshal_ttmsf() as the ASCII log would.
+static std::string
+unmarshal_test_int(int64_t val, int (*unmarshal)(char **, char *, int))
+{
+  alignas(int64_t) char marshaled[INK_MIN_ALIGN];
+  char dest[64];
+  char *p = marshaled;
+
+  LogAccess::marshal_int(marshaled, val);
+  int len = unmarshal(&p, dest, sizeof(dest));
+  return len < 0 ? "<error>" : std::string(dest, len);
+}
+
+REGRESSION_TEST(LogAccess_Unmarshal_int)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  std::mt19937_64 rng(21);
+  std::vector<int64_t> values = {0, 1, 9, 10, 99, 100, 999, 1000, 1001, 12345, INT64_MAX, -1, -999, -1000, -1001, INT64_MIN};
+
+  box = REGRESSION_TEST_PASSED;
+
+  for (int i = 0; i < 10000; ++i) {
+    values.push_back(rng() >> (rng() % 64));
+    values.push_back(-(int64_t)(rng() >> (rng() % 64 + 1)));
+    values.push_back(1500000000000 + (int64_t)(rng() % 1000000000)); // ms timestamps
+  }
+
+  for (int64_t val : values) {
+    char expected[64];
+
+    // Negative numbers are logged as 0.
+    snprintf(expected, sizeof(expected), "%" PRId64, val < 0 ? 0 : val);
+    std::string got = unmarshal_test_int(val, &LogAccess::unmarshal_int_to_str);
+    box.check(got == expected, "unmarshal_int_to_str(%" PRId64 ") = '%s', expected '%s'", val, got.c_str(), expected);
+
+    if (val > -((int64_t)1 << 50) && val < ((int64_t)1 << 50)) {
+      snprintf(expected, sizeof(expected), "%.3f", (double)val / 1000);
+      got = unmarshal_test_int(val, &LogAccess::unmarshal_ttmsf);
+      box.check(got == expected, "unmarshal_ttmsf(%" PRId64 ") = '%s', expected '%s'", val, got.c_str(), expected);
+    }
+  }
+
+  alignas(int64_t) char marshaled[INK_MIN_ALIGN];
+  char dest[8];
+  char *p = marshaled;
+
+  LogAccess::marshal_int(marshaled, 1234567890123);
+  box.check(LogAccess::unmarshal_ttmsf(&p, dest, sizeof(dest)) == -1, "unmarshal_ttmsf() overflowed a short buffer");
+}
+
+#endif
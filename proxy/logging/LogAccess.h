@@ -157,7 +157,7 @@ class LogAccess
 public:
   inkcoreapi
   LogAccess()
-    : initialized(false)
+    : initialized(false), field_cache(nullptr)
   {
   }
 
@@ -361,6 +361,7 @@ public:
   inkcoreapi static int marshal_ip(char *dest, sockaddr const *ip);
 
   bool initialized;
+  LogFieldCache *field_cache; // fields already marshalled for other log objects, if any
 
   // noncopyable
   // -- member functions that are not allowed --
@@ -376,6 +376,12 @@ create_binary_log_object(lua_State *L)
   return create_log_object(L, "log.binary", LOG_FILE_BINARY);
 }
 
+static int
+create_columnar_log_object(lua_State *L)
+{
+  return create_log_object(L, "log.columnar", LOG_FILE_COLUMNAR);
+}
+
 static int
 create_ascii_log_object(lua_State *L)
 {
@@ -399,6 +405,7 @@ MakeLogBindings(BindingInstance &binding, LogConfig *conf)
   binding.bind_function("log.ascii", create_ascii_log_object);
   binding.bind_function("log.pipe", create_pipe_log_object);
   binding.bind_function("log.binary", create_binary_log_object);
+  binding.bind_function("log.columnar", create_columnar_log_object);
 
   binding.bind_function("format", create_format_object);
 
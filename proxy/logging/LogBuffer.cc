@@ -53,9 +53,25 @@ enum {
   FIELDLIST_CACHE_SIZE = 256,
 };
 
+// The cache is shared by the preproc threads. Entries are only added,
+// under fieldlist_cache_mutex, and become visible to the lookups without
+// the lock when fieldlist_cache_entries is incremented.
 FieldListCacheElement fieldlist_cache[FIELDLIST_CACHE_SIZE];
-int fieldlist_cache_entries = 0;
-vint32 LogBuffer::M_ID      = 0;
+vint32 fieldlist_cache_entries         = 0;
+static ink_mutex fieldlist_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+vint32 LogBuffer::M_ID                 = 0;
+
+static LogFieldList *
+fieldlist_cache_find(const char *symbol_str, int from, int to)
+{
+  for (int i = from; i < to; i++) {
+    if (strcmp(symbol_str, fieldlist_cache[i].symbol_str) == 0) {
+      Debug("log-fieldlist", "Fieldlist for %s found in cache, #%d", symbol_str, i);
+      return fieldlist_cache[i].fieldlist;
+    }
+  }
+  return nullptr;
+}
 
 /*-------------------------------------------------------------------------
   The following LogBufferHeader routines are used to grab strings out from
@@ -113,7 +129,7 @@ LogBufferHeader::log_filename()
 }
 
 LogBuffer::LogBuffer(LogObject *owner, size_t size, size_t buf_align, size_t write_align)
-  : m_size(size), m_buf_align(buf_align), m_write_align(write_align), m_owner(owner), m_references(0)
+  : m_size(size), m_buf_align(buf_align), m_write_align(write_align), m_owner(owner), m_references(0), m_flush_seq(0)
 {
   size_t hdr_size;
 
@@ -155,7 +171,8 @@ LogBuffer::LogBuffer(LogObject *owner, LogBufferHeader *header)
     m_expiration_time(0),
     m_owner(owner),
     m_header(header),
-    m_references(0)
+    m_references(0),
+    m_flush_seq(0)
 {
   // This constructor does not allocate a buffer because it gets it as
   // an argument. We set m_unaligned_buffer to NULL, which means that
@@ -202,7 +219,7 @@ LogBuffer::~LogBuffer()
   -------------------------------------------------------------------------*/
 
 LogBuffer::LB_ResultCode
-LogBuffer::checkout_write(size_t *write_offset, size_t write_size)
+LogBuffer::checkout_write(size_t *write_offset, size_t write_size, unsigned *cas_failures)
 {
   // checkout_write should not be called if m_unaligned_buffer was
   // not allocated, which means that the actual buffer data was given
@@ -275,6 +292,9 @@ LogBuffer::checkout_write(size_t *write_offset, size_t write_size)
       }
     }
     ret_val = LB_BUSY;
+    if (cas_failures) {
+      ++*cas_failures;
+    }
   } while (--retries);
 
   // add the entry header to the buffer if this was a real checkout and
@@ -585,33 +605,34 @@ LogBuffer::to_ascii(LogEntryHeader *entry, LogFormatType type, char *buf, int bu
   // these stored plans.
   //
 
-  int i;
-  LogFieldList *fieldlist = nullptr;
+  int entries             = fieldlist_cache_entries;
+  LogFieldList *fieldlist = fieldlist_cache_find(symbol_str, 0, entries);
   bool delete_fieldlist_p = false; // need to free the fieldlist?
 
-  for (i = 0; i < fieldlist_cache_entries; i++) {
-    if (strcmp(symbol_str, fieldlist_cache[i].symbol_str) == 0) {
-      Debug("log-fieldlist", "Fieldlist for %s found in cache, #%d", symbol_str, i);
-      fieldlist = fieldlist_cache[i].fieldlist;
-      break;
-    }
-  }
-
   if (!fieldlist) {
-    Debug("log-fieldlist", "Fieldlist for %s not found; creating ...", symbol_str);
-    fieldlist = new LogFieldList;
-    ink_assert(fieldlist != nullptr);
-    bool contains_aggregates = false;
-    LogFormat::parse_symbol_string(symbol_str, fieldlist, &contains_aggregates);
-
-    if (fieldlist_cache_entries < FIELDLIST_CACHE_SIZE) {
-      Debug("log-fieldlist", "Fieldlist cached as entry %d", fieldlist_cache_entries);
-      fieldlist_cache[fieldlist_cache_entries].fieldlist  = fieldlist;
-      fieldlist_cache[fieldlist_cache_entries].symbol_str = ats_strdup(symbol_str);
-      fieldlist_cache_entries++;
-    } else {
-      delete_fieldlist_p = true;
+    ink_mutex_acquire(&fieldlist_cache_mutex);
+
+    // another thread may have added it in the meantime
+    fieldlist = fieldlist_cache_find(symbol_str, entries, fieldlist_cache_entries);
+    if (!fieldlist) {
+      Debug("log-fieldlist", "Fieldlist for %s not found; creating ...", symbol_str);
+      fieldlist = new LogFieldList;
+      ink_assert(fieldlist != nullptr);
+      bool contains_aggregates = false;
+      LogFormat::parse_symbol_string(symbol_str, fieldlist, &contains_aggregates);
+
+      if (fieldlist_cache_entries < FIELDLIST_CACHE_SIZE) {
+        Debug("log-fieldlist", "Fieldlist cached as entry %d", fieldlist_cache_entries);
+        fieldlist_cache[fieldlist_cache_entries].fieldlist  = fieldlist;
+        fieldlist_cache[fieldlist_cache_entries].symbol_str = ats_strdup(symbol_str);
+        INK_WRITE_MEMORY_BARRIER;
+        fieldlist_cache_entries++;
+      } else {
+        delete_fieldlist_p = true;
+      }
     }
+
+    ink_mutex_release(&fieldlist_cache_mutex);
   }
 
   LogFieldList *alt_fieldlist = nullptr;
@@ -149,7 +149,7 @@ public:
     return (ink_atomic_cas(&m_state.ival, old_state.ival, new_state.ival));
   }
 
-  LB_ResultCode checkout_write(size_t *write_offset, size_t write_size);
+  LB_ResultCode checkout_write(size_t *write_offset, size_t write_size, unsigned *cas_failures = nullptr);
   LB_ResultCode checkin_write(size_t write_offset);
   void force_full();
 
@@ -224,6 +224,7 @@ private:
 public:
   volatile LB_State m_state; // buffer state
   volatile int m_references; // oustanding checkout_write references.
+  uint64_t m_flush_seq;      // order in which the owner queued the buffer for flushing, 0 if unordered
 
   // noncopyable
   // -- member functions that are not allowed --
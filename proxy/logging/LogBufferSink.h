@@ -45,6 +45,15 @@ public:
   // return 0 if success, -1 on error.
   //
   virtual int preproc_and_try_delete(LogBuffer *buffer) = 0;
+
+  //
+  // The preproc_drop() function is called instead for a buffer that is
+  // dropped, before it is deleted.
+  //
+  virtual void
+  preproc_drop(LogBuffer * /* buffer ATS_UNUSED */)
+  {
+  }
   virtual ~LogBufferSink(){};
 };
 
@@ -0,0 +1,490 @@
+/** @file
+
+  Columnar, compressed encoding of LogBuffers for binary log files.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  @section description
+  Once decompressed, a block is laid out as follows, all integers in host
+  order:
+
+    the LogBufferHeader and its strings, up to data_offset
+    int64_t timestamp delta, for each entry
+    int32_t timestamp_usec, for each entry
+    uint32_t number of columns
+    for each column: uint32_t encoding, uint32_t length, length bytes
+
+  where the columns are, depending on their encoding:
+
+    COLUMN_RAW         uint32_t size of each value, then the values
+    COLUMN_STRING      the strings, nul terminated
+    COLUMN_DICTIONARY  uint32_t number of strings, the nul terminated
+                       strings, then the uint32_t index of each value
+
+  An entry is the concatenation of its value in each column.
+ */
+#include "ts/ink_platform.h"
+#include "ts/fastlz.h"
+
+#include "LogColumnBlock.h"
+#include "LogField.h"
+#include "LogFormat.h"
+#include "LogLimits.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+enum ColumnEncoding {
+  COLUMN_RAW = 0,
+  COLUMN_STRING,
+  COLUMN_DICTIONARY,
+};
+
+// A dictionary is used if at most one value in this many is distinct.
+const size_t DICTIONARY_RATIO = 4;
+
+struct Column {
+  bool is_string = false; // values of a LogField::STRING field, or text entries
+  std::vector<const char *> values;
+  std::vector<uint32_t> sizes;
+};
+
+template <typename T>
+void
+put(std::string &out, T value)
+{
+  out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Strings are stored as LogAccess::marshal_str() lays them down, nul
+// terminated and padded to LogAccess::strlen(). Only the columns of string
+// fields are checked, the bytes of an integer or an address can look the same.
+bool
+is_string_column(Column const &column)
+{
+  if (!column.is_string) {
+    return false;
+  }
+  for (size_t i = 0; i < column.values.size(); ++i) {
+    if (!memchr(column.values[i], 0, column.sizes[i]) || LogAccess::strlen(column.values[i]) != (int)column.sizes[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+encode_column(std::string &out, Column const &column)
+{
+  size_t n_values   = column.values.size();
+  uint32_t encoding = COLUMN_RAW;
+  std::string data;
+
+  if (is_string_column(column)) {
+    std::unordered_map<std::string, uint32_t> dictionary;
+    std::vector<const char *> strings;
+    std::vector<uint32_t> index;
+
+    for (auto value : column.values) {
+      auto spot = dictionary.emplace(value, strings.size());
+      if (spot.second) {
+        if (dictionary.size() * DICTIONARY_RATIO > n_values) {
+          break;
+        }
+        strings.push_back(value);
+      }
+      index.push_back(spot.first->second);
+    }
+
+    if (index.size() == n_values) {
+      encoding = COLUMN_DICTIONARY;
+      put(data, static_cast<uint32_t>(strings.size()));
+      for (auto str : strings) {
+        data.append(str, strlen(str) + 1);
+      }
+      data.append(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(uint32_t));
+    } else {
+      encoding = COLUMN_STRING;
+      for (auto value : column.values) {
+        data.append(value, strlen(value) + 1);
+      }
+    }
+  } else {
+    data.append(reinterpret_cast<const char *>(column.sizes.data()), column.sizes.size() * sizeof(uint32_t));
+    for (size_t i = 0; i < n_values; ++i) {
+      data.append(column.values[i], column.sizes[i]);
+    }
+  }
+
+  put(out, encoding);
+  put(out, static_cast<uint32_t>(data.size()));
+  out += data;
+}
+
+// Split the entries into their fields, as LogBuffer::to_ascii() would read them.
+bool
+split_entries(std::vector<LogEntryHeader *> const &entries, LogFieldList &fields, std::vector<Column> &columns)
+{
+  char scratch[LOG_MAX_FORMATTED_LINE];
+
+  columns.assign(fields.count(), Column());
+  unsigned n = 0;
+  for (LogField *f = fields.first(); f; f = fields.next(f), ++n) {
+    columns[n].is_string = f->type() == LogField::STRING;
+  }
+  for (auto entry : entries) {
+    char *read_from = reinterpret_cast<char *>(entry) + sizeof(LogEntryHeader);
+    char *end       = reinterpret_cast<char *>(entry) + entry->entry_len;
+    unsigned i      = 0;
+
+    for (LogField *f = fields.first(); f; f = fields.next(f), ++i) {
+      char *next = read_from;
+      f->unmarshal(&next, scratch, sizeof(scratch));
+      if (next <= read_from || next > end) {
+        return false;
+      }
+      columns[i].values.push_back(read_from);
+      columns[i].sizes.push_back(next - read_from);
+      read_from = next;
+    }
+    if (read_from != end) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reads the decompressed columns, failing rather than going past their end.
+struct Reader {
+  const char *next;
+  const char *end;
+  bool ok;
+
+  Reader(const char *start = nullptr, size_t len = 0) : next(start), end(start + len), ok(true) {}
+
+  const char *
+  take(size_t len)
+  {
+    if (!ok || static_cast<size_t>(end - next) < len) {
+      ok = false;
+      return nullptr;
+    }
+    const char *ret = next;
+    next += len;
+    return ret;
+  }
+
+  template <typename T>
+  T
+  get()
+  {
+    T value = T();
+    if (const char *p = take(sizeof(T))) {
+      memcpy(&value, p, sizeof(T));
+    }
+    return value;
+  }
+
+  const char *
+  get_string()
+  {
+    const char *nul = ok ? static_cast<const char *>(memchr(next, 0, end - next)) : nullptr;
+    return nul ? take(nul - next + 1) : take(end - next + 1);
+  }
+};
+
+struct ColumnCursor {
+  uint32_t encoding;
+  Reader sizes; // or the dictionary index of each value
+  Reader values;
+  std::vector<const char *> dictionary;
+
+  bool
+  init(Reader &in, uint32_t n_entries)
+  {
+    encoding          = in.get<uint32_t>();
+    uint32_t length   = in.get<uint32_t>();
+    const char *start = in.take(length);
+    Reader data(start, length);
+
+    if (!start) {
+      return false;
+    }
+    switch (encoding) {
+    case COLUMN_RAW:
+      sizes  = Reader(data.take(n_entries * sizeof(uint32_t)), n_entries * sizeof(uint32_t));
+      values = Reader(data.next, data.end - data.next);
+      break;
+    case COLUMN_STRING:
+      values = data;
+      break;
+    case COLUMN_DICTIONARY: {
+      uint32_t n_strings = data.get<uint32_t>();
+      if (n_strings > length) {
+        return false;
+      }
+      for (uint32_t i = 0; i < n_strings && data.ok; ++i) {
+        dictionary.push_back(data.get_string());
+      }
+      sizes = Reader(data.take(n_entries * sizeof(uint32_t)), n_entries * sizeof(uint32_t));
+      break;
+    }
+    default:
+      return false;
+    }
+    return data.ok;
+  }
+
+  // Copy the next value to @a out, returning its size or -1 on error.
+  int
+  copy_value(char *out, size_t avail)
+  {
+    const char *str = nullptr;
+
+    switch (encoding) {
+    case COLUMN_RAW: {
+      uint32_t size   = sizes.get<uint32_t>();
+      const char *raw = values.take(size);
+      if (!raw || size > avail) {
+        return -1;
+      }
+      memcpy(out, raw, size);
+      return size;
+    }
+    case COLUMN_STRING:
+      str = values.get_string();
+      break;
+    case COLUMN_DICTIONARY: {
+      uint32_t i = sizes.get<uint32_t>();
+      str        = (sizes.ok && i < dictionary.size()) ? dictionary[i] : nullptr;
+      break;
+    }
+    }
+
+    if (!str) {
+      return -1;
+    }
+
+    size_t len  = strlen(str) + 1;
+    size_t size = LogAccess::strlen(str);
+    if (size > avail) {
+      return -1;
+    }
+    memcpy(out, str, len);
+    memset(out + len, 0, size - len);
+    return size;
+  }
+};
+} // namespace
+
+/*-------------------------------------------------------------------------
+  LogColumnBlock::encode
+  -------------------------------------------------------------------------*/
+
+char *
+LogColumnBlock::encode(LogBufferHeader *header, int *block_len)
+{
+  ink_assert(header != nullptr);
+
+  if (header->version != LOG_SEGMENT_VERSION || header->data_offset < sizeof(LogBufferHeader) ||
+      header->data_offset > header->byte_count || header->byte_count > MAX_BUFFER_BYTES) {
+    Note("Cannot encode invalid LogBuffer (version %u, %u bytes)", header->version, header->byte_count);
+    return nullptr;
+  }
+
+  char *buffer = reinterpret_cast<char *>(header);
+  std::vector<LogEntryHeader *> entries;
+  uint32_t offset = header->data_offset;
+
+  for (uint32_t i = 0; i < header->entry_count; ++i) {
+    LogEntryHeader *entry = reinterpret_cast<LogEntryHeader *>(buffer + offset);
+    if (offset + sizeof(LogEntryHeader) > header->byte_count || entry->entry_len < sizeof(LogEntryHeader) ||
+        entry->entry_len > header->byte_count - offset) {
+      Note("Cannot encode LogBuffer with an invalid entry at offset %u", offset);
+      return nullptr;
+    }
+    entries.push_back(entry);
+    offset += entry->entry_len;
+  }
+
+  // Split the entries into their fields if we can, keep them whole otherwise.
+  std::vector<Column> columns;
+  bool split = false;
+
+  if (header->format_type == LOG_FORMAT_CUSTOM && header->fmt_fieldlist()) {
+    LogFieldList fields;
+    bool contains_aggregates = false;
+
+    if (LogFormat::parse_symbol_string(header->fmt_fieldlist(), &fields, &contains_aggregates) > 0) {
+      split = split_entries(entries, fields, columns);
+    }
+  }
+  if (!split) {
+    columns.assign(1, Column());
+    columns[0].is_string = header->format_type == LOG_FORMAT_TEXT;
+    for (auto entry : entries) {
+      columns[0].values.push_back(reinterpret_cast<char *>(entry) + sizeof(LogEntryHeader));
+      columns[0].sizes.push_back(entry->entry_len - sizeof(LogEntryHeader));
+    }
+  }
+
+  std::string raw(buffer, header->data_offset);
+  int64_t last = 0;
+
+  for (auto entry : entries) {
+    put(raw, entry->timestamp - last);
+    last = entry->timestamp;
+  }
+  for (auto entry : entries) {
+    put(raw, entry->timestamp_usec);
+  }
+  put(raw, static_cast<uint32_t>(columns.size()));
+  for (auto const &column : columns) {
+    encode_column(raw, column);
+  }
+
+  // FastLZ needs 5% more room than the input, and at least 66 bytes.
+  size_t room                  = raw.size() + raw.size() / 16 + 66;
+  char *block                  = static_cast<char *>(ats_malloc(sizeof(LogColumnBlockHeader) + room));
+  LogColumnBlockHeader *bheader = reinterpret_cast<LogColumnBlockHeader *>(block);
+  int len                      = fastlz_compress_level(2, raw.data(), raw.size(), block + sizeof(LogColumnBlockHeader));
+
+  // Columns that don't compress could in theory end up past what readers accept.
+  if (sizeof(LogColumnBlockHeader) + len > MAX_BLOCK_BYTES) {
+    Note("Cannot encode LogBuffer of %u bytes in a block of at most %u bytes", header->byte_count, MAX_BLOCK_BYTES);
+    ats_free(block);
+    return nullptr;
+  }
+
+  bheader->cookie       = LOG_COLUMN_BLOCK_COOKIE;
+  bheader->version      = LOG_COLUMN_BLOCK_VERSION;
+  bheader->byte_count   = sizeof(LogColumnBlockHeader) + len;
+  bheader->raw_count    = raw.size();
+  bheader->buffer_count = header->byte_count;
+  bheader->entry_count  = header->entry_count;
+
+  Debug("log-column", "encoded %u entries of %u bytes in %zu columns, %zu bytes, %u compressed", header->entry_count,
+        header->byte_count, columns.size(), raw.size(), bheader->byte_count);
+
+  *block_len = bheader->byte_count;
+  return block;
+}
+
+/*-------------------------------------------------------------------------
+  LogColumnBlock::decode
+  -------------------------------------------------------------------------*/
+
+LogBufferHeader *
+LogColumnBlock::decode(const char *block, int block_len)
+{
+  ink_assert(block != nullptr);
+
+  LogColumnBlockHeader bheader;
+
+  if (block_len < (int)sizeof(bheader)) {
+    return nullptr;
+  }
+  memcpy(&bheader, block, sizeof(bheader));
+  if (bheader.cookie != LOG_COLUMN_BLOCK_COOKIE || bheader.version != LOG_COLUMN_BLOCK_VERSION ||
+      bheader.byte_count != (uint32_t)block_len || bheader.byte_count > MAX_BLOCK_BYTES || bheader.buffer_count > MAX_BUFFER_BYTES ||
+      bheader.raw_count > 2 * MAX_BUFFER_BYTES || bheader.buffer_count < sizeof(LogBufferHeader)) {
+    Debug("log-column", "invalid block header: version %u, %u bytes", bheader.version, bheader.byte_count);
+    return nullptr;
+  }
+
+  std::vector<char> raw(bheader.raw_count);
+  if (fastlz_decompress(block + sizeof(bheader), block_len - sizeof(bheader), raw.data(), raw.size()) != (int)raw.size()) {
+    Debug("log-column", "failed to decompress %u bytes", bheader.byte_count);
+    return nullptr;
+  }
+
+  Reader in(raw.data(), raw.size());
+  LogBufferHeader header;
+  const char *start = in.take(sizeof(header));
+
+  if (!start) {
+    return nullptr;
+  }
+  memcpy(&header, start, sizeof(header));
+  if (header.cookie != LOG_SEGMENT_COOKIE || header.byte_count != bheader.buffer_count ||
+      header.entry_count != bheader.entry_count || header.data_offset < sizeof(header) || header.data_offset > header.byte_count ||
+      !in.take(header.data_offset - sizeof(header))) {
+    Debug("log-column", "invalid LogBufferHeader in block");
+    return nullptr;
+  }
+
+  uint32_t n_entries = header.entry_count;
+  Reader deltas(in.take(n_entries * sizeof(int64_t)), n_entries * sizeof(int64_t));
+  Reader usecs(in.take(n_entries * sizeof(int32_t)), n_entries * sizeof(int32_t));
+  uint32_t n_columns = in.get<uint32_t>();
+
+  if (!in.ok || n_columns > raw.size()) {
+    return nullptr;
+  }
+
+  std::vector<ColumnCursor> columns(n_columns);
+  for (auto &column : columns) {
+    if (!column.init(in, n_entries)) {
+      Debug("log-column", "invalid column in block");
+      return nullptr;
+    }
+  }
+
+  char *buffer    = static_cast<char *>(ats_malloc(header.byte_count));
+  uint32_t offset = header.data_offset;
+  int64_t last    = 0;
+  bool ok         = true;
+
+  memcpy(buffer, raw.data(), header.data_offset);
+  for (uint32_t i = 0; ok && i < n_entries; ++i) {
+    LogEntryHeader entry;
+    uint32_t start = offset;
+
+    if (header.byte_count - offset < sizeof(entry)) {
+      ok = false;
+      break;
+    }
+    offset += sizeof(entry);
+    for (auto &column : columns) {
+      int size = column.copy_value(buffer + offset, header.byte_count - offset);
+      if (size < 0) {
+        ok = false;
+        break;
+      }
+      offset += size;
+    }
+
+    last += deltas.get<int64_t>();
+    entry.timestamp      = last;
+    entry.timestamp_usec = usecs.get<int32_t>();
+    entry.entry_len      = offset - start;
+    memcpy(buffer + start, &entry, sizeof(entry));
+  }
+
+  if (!ok || offset != header.byte_count) {
+    Debug("log-column", "block does not restore a LogBuffer of %u bytes", header.byte_count);
+    ats_free(buffer);
+    return nullptr;
+  }
+
+  return reinterpret_cast<LogBufferHeader *>(buffer);
+}
@@ -0,0 +1,91 @@
+/** @file
+
+  Columnar, compressed encoding of LogBuffers for binary log files.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef LOG_COLUMN_BLOCK_H
+#define LOG_COLUMN_BLOCK_H
+
+#include "ts/ink_platform.h"
+#include "LogBuffer.h"
+
+#define LOG_COLUMN_BLOCK_COOKIE 0xc0cface
+#define LOG_COLUMN_BLOCK_VERSION 1
+
+/*-------------------------------------------------------------------------
+  LogColumnBlockHeader
+
+  Columnar log files are a sequence of blocks, one per LogBuffer, each made
+  of this header and the compressed columns. The cookie and version come
+  first, as in a LogBufferHeader, so a reader can tell the two apart after
+  reading the first 8 bytes.
+  -------------------------------------------------------------------------*/
+
+struct LogColumnBlockHeader {
+  uint32_t cookie;       // LOG_COLUMN_BLOCK_COOKIE
+  uint32_t version;      // LOG_COLUMN_BLOCK_VERSION
+  uint32_t byte_count;   // size of the block, this header included
+  uint32_t raw_count;    // size of the columns once decompressed
+  uint32_t buffer_count; // byte_count of the LogBuffer the block restores
+  uint32_t entry_count;  // number of entries in the block
+};
+
+/*-------------------------------------------------------------------------
+  LogColumnBlock
+
+  Turns a LogBuffer into a block and back. The buffer header is kept as
+  is, the entry timestamps are delta encoded, and the entries are split
+  into one column per field of the format. String columns drop the
+  padding and use a dictionary when few values repeat a lot, such as
+  hosts, methods or user agents. The columns are then compressed with
+  FastLZ.
+
+  Entries that do not split into their fields, text log entries for
+  instance, are kept whole in a single column. Decoding gives back the
+  original LogBuffer, except that the padding after strings is zeroed,
+  so the existing code for binary logs reads it.
+  -------------------------------------------------------------------------*/
+
+class LogColumnBlock
+{
+public:
+  /** Encode the LogBuffer @a header.
+
+      @return The block, to be freed with ats_free(), with its size in
+      @a block_len, or nullptr if the buffer is invalid.
+   */
+  static char *encode(LogBufferHeader *header, int *block_len);
+
+  /** Decode the block @a block of @a block_len bytes, header included.
+
+      @return The LogBuffer, to be freed with ats_free(), or nullptr if
+      the block is corrupt.
+   */
+  static LogBufferHeader *decode(const char *block, int block_len);
+
+  /// Blocks that would restore larger LogBuffers than this are corrupt.
+  static const uint32_t MAX_BUFFER_BYTES = 64 * 1024 * 1024;
+
+  /// Blocks larger than this, header included, are corrupt, so readers can check before allocating.
+  static const uint32_t MAX_BLOCK_BYTES = MAX_BUFFER_BYTES + sizeof(LogColumnBlockHeader);
+};
+
+#endif
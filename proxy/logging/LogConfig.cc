@@ -77,6 +77,7 @@ LogConfig::setup_default_values()
 
   log_buffer_size              = (int)(10 * LOG_KILOBYTE);
   max_secs_per_buffer          = 5;
+  thread_buffers               = 0;
   max_space_mb_for_logs        = 100;
   max_space_mb_for_orphan_logs = 25;
   max_space_mb_headroom        = 10;
@@ -134,6 +135,8 @@ LogConfig::read_configuration_variables()
     max_secs_per_buffer = val;
   }
 
+  thread_buffers = (int)REC_ConfigReadInteger("proxy.config.log.thread_buffers");
+
   val = (int)REC_ConfigReadInteger("proxy.config.log.max_space_mb_for_logs");
   if (val > 0) {
     max_space_mb_for_logs = val;
@@ -447,6 +450,7 @@ LogConfig::display(FILE *fd)
   fprintf(fd, "Config variables:\n");
   fprintf(fd, "   log_buffer_size = %d\n", log_buffer_size);
   fprintf(fd, "   max_secs_per_buffer = %d\n", max_secs_per_buffer);
+  fprintf(fd, "   thread_buffers = %d\n", thread_buffers);
   fprintf(fd, "   max_space_mb_for_logs = %d\n", max_space_mb_for_logs);
   fprintf(fd, "   max_space_mb_for_orphan_logs = %d\n", max_space_mb_for_orphan_logs);
   fprintf(fd, "   use_orphan_log_space_value = %d\n", use_orphan_log_space_value);
@@ -531,6 +535,7 @@ LogConfig::register_config_callbacks()
   static const char *names[] = {
     "proxy.config.log.log_buffer_size",
     "proxy.config.log.max_secs_per_buffer",
+    "proxy.config.log.thread_buffers",
     "proxy.config.log.max_space_mb_for_logs",
     "proxy.config.log.max_space_mb_for_orphan_logs",
     "proxy.config.log.max_space_mb_headroom",
@@ -623,6 +628,8 @@ LogConfig::register_stat_callbacks()
                      (int)log_stat_bytes_written_to_disk_stat, RecRawStatSyncSum);
   RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.bytes_lost_before_written_to_disk", RECD_INT, RECP_PERSISTENT,
                      (int)log_stat_bytes_lost_before_written_to_disk_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(log_rsb, RECT_PROCESS, "proxy.process.log.buffer_checkout_retries", RECD_COUNTER, RECP_PERSISTENT,
+                     (int)log_stat_buffer_checkout_retries_stat, RecRawStatSyncSum);
   //
   // I/O
   //
@@ -62,6 +62,8 @@ enum {
   log_stat_bytes_written_to_disk_stat,
   log_stat_bytes_lost_before_written_to_disk_stat,
 
+  log_stat_buffer_checkout_retries_stat,
+
   // Logging I/O
   log_stat_log_files_open_stat,
   log_stat_log_files_space_used_stat,
@@ -171,6 +173,7 @@ public:
 
   int log_buffer_size;
   int max_secs_per_buffer;
+  int thread_buffers;
   int max_space_mb_for_logs;
   int max_space_mb_for_orphan_logs;
   int max_space_mb_headroom;
@@ -35,6 +35,8 @@
 #include "LogAccess.h"
 #include "Log.h"
 
+#include <string>
+
 // clang-format off
 //
 static const char *container_names[] = {
@@ -205,6 +207,34 @@ static const milestone milestones[] = {
   {"TS_MILESTONE_TLS_HANDSHAKE_END", TS_MILESTONE_TLS_HANDSHAKE_END},
 };
 
+/*-------------------------------------------------------------------------
+  Every distinct field gets a slot in the LogFieldCache, looked up by its
+  symbol and, for container fields, its name. Slots are never given back,
+  a reconfiguration finds the slots of the fields it already had.
+  -------------------------------------------------------------------------*/
+static int
+cache_slot_for(const char *symbol, const char *name)
+{
+  static ink_mutex mutex = INK_MUTEX_INIT;
+  static std::map<std::string, int> slots;
+  std::string key(symbol);
+
+  if (name) {
+    key += '.';
+    key += name;
+  }
+
+  ink_scoped_mutex_lock lock(mutex);
+  auto spot = slots.find(key);
+  if (spot != slots.end()) {
+    return spot->second;
+  }
+
+  int slot = slots.size() < LogFieldCache::MAX_SLOTS ? static_cast<int>(slots.size()) : -1;
+  slots.emplace(key, slot);
+  return slot;
+}
+
 void
 LogField::init_milestone_container()
 {
@@ -232,7 +262,8 @@ LogField::LogField(const char *name, const char *symbol, Type type, MarshalFunc
     m_milestone2(TS_MILESTONE_LAST_ENTRY),
     m_time_field(false),
     m_alias_map(nullptr),
-    m_set_func(_setfunc)
+    m_set_func(_setfunc),
+    m_cache_slot(cache_slot_for(symbol, nullptr))
 {
   ink_assert(m_name != nullptr);
   ink_assert(m_symbol != nullptr);
@@ -259,7 +290,8 @@ LogField::LogField(const char *name, const char *symbol, Type type, MarshalFunc
     m_milestone2(TS_MILESTONE_LAST_ENTRY),
     m_time_field(false),
     m_alias_map(map),
-    m_set_func(_setfunc)
+    m_set_func(_setfunc),
+    m_cache_slot(cache_slot_for(symbol, nullptr))
 {
   ink_assert(m_name != nullptr);
   ink_assert(m_symbol != nullptr);
@@ -326,7 +358,8 @@ LogField::LogField(const char *field, Container container, SetFunc _setfunc)
     m_milestone2(TS_MILESTONE_LAST_ENTRY),
     m_time_field(false),
     m_alias_map(nullptr),
-    m_set_func(_setfunc)
+    m_set_func(_setfunc),
+    m_cache_slot(cache_slot_for(container_names[container], field))
 {
   ink_assert(m_name != nullptr);
   ink_assert(m_symbol != nullptr);
@@ -396,7 +429,8 @@ LogField::LogField(const LogField &rhs)
     m_milestone2(TS_MILESTONE_LAST_ENTRY),
     m_time_field(rhs.m_time_field),
     m_alias_map(rhs.m_alias_map),
-    m_set_func(rhs.m_set_func)
+    m_set_func(rhs.m_set_func),
+    m_cache_slot(rhs.m_cache_slot)
 {
   ink_assert(m_name != nullptr);
   ink_assert(m_symbol != nullptr);
@@ -423,49 +457,22 @@ LogField::~LogField()
 unsigned
 LogField::marshal_len(LogAccess *lad)
 {
-  if (m_container == NO_CONTAINER) {
-    return (lad->*m_marshal_func)(nullptr);
-  }
-
-  switch (m_container) {
-  case CQH:
-  case PSH:
-  case PQH:
-  case SSH:
-  case CSSH:
-    return lad->marshal_http_header_field(m_container, m_name, nullptr);
-
-  case ECQH:
-  case EPSH:
-  case EPQH:
-  case ESSH:
-  case ECSSH:
-    return lad->marshal_http_header_field_escapify(m_container, m_name, nullptr);
-
-  case ICFG:
-    return lad->marshal_config_int_var(m_name, nullptr);
-
-  case SCFG:
-    return lad->marshal_config_str_var(m_name, nullptr);
+  unsigned len;
 
-  case RECORD:
-    return lad->marshal_record(m_name, nullptr);
-
-  case MS:
-    return lad->marshal_milestone(m_milestone1, nullptr);
-
-  case MSDMS:
-    return lad->marshal_milestone_diff(m_milestone1, m_milestone2, nullptr);
-
-  default:
-    return 0;
+  if (_find_cached(lad, &len)) {
+    return len;
   }
+  return _marshal(lad, nullptr);
 }
 
 void
 LogField::updateField(LogAccess *lad, char *buf, int len)
 {
   if (m_container == NO_CONTAINER) {
+    // Whatever was marshalled before may be stale now.
+    if (lad->field_cache) {
+      lad->field_cache->clear();
+    }
     return (lad->*m_set_func)(buf, len);
   }
   // else...// future enhancement
@@ -478,6 +485,25 @@ LogField::updateField(LogAccess *lad, char *buf, int len)
   -------------------------------------------------------------------------*/
 unsigned
 LogField::marshal(LogAccess *lad, char *buf)
+{
+  unsigned len;
+  const char *data = _find_cached(lad, &len);
+
+  if (data) {
+    memcpy(buf, data, len);
+    return len;
+  }
+  return _marshal(lad, buf);
+}
+
+/*-------------------------------------------------------------------------
+  LogField::_marshal
+
+  Extract the field from the LogAccess into @a buf, or only return its
+  length if @a buf is NULL.
+  -------------------------------------------------------------------------*/
+unsigned
+LogField::_marshal(LogAccess *lad, char *buf)
 {
   if (m_container == NO_CONTAINER) {
     return (lad->*m_marshal_func)(buf);
@@ -518,6 +544,34 @@ LogField::marshal(LogAccess *lad, char *buf)
   }
 }
 
+/*-------------------------------------------------------------------------
+  LogField::_find_cached
+
+  If other log objects use this field too, return it from the cache of the
+  entry being logged, marshalling it there the first time. NULL if the field
+  is not cached.
+  -------------------------------------------------------------------------*/
+const char *
+LogField::_find_cached(LogAccess *lad, unsigned *len)
+{
+  LogFieldCache *cache = lad->field_cache;
+
+  if (cache == nullptr || !cache->is_shared(m_cache_slot)) {
+    return nullptr;
+  }
+
+  const char *data = cache->find(m_cache_slot, len);
+  if (data == nullptr) {
+    char *space = cache->reserve(_marshal(lad, nullptr));
+    if (space) {
+      *len = _marshal(lad, space);
+      cache->insert(m_cache_slot, *len);
+      data = space;
+    }
+  }
+  return data;
+}
+
 /*-------------------------------------------------------------------------
   LogField::marshal_agg
   -------------------------------------------------------------------------*/
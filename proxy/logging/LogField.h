@@ -25,7 +25,9 @@
 #define LOG_FIELD_H
 
 #include "ts/ink_platform.h"
+#include "ts/ink_align.h"
 #include "ts/List.h"
+#include <bitset>
 #include "LogFieldAliasMap.h"
 #include "Milestones.h"
 
@@ -171,6 +173,12 @@ public:
     return m_time_field;
   }
 
+  int
+  cache_slot() const
+  {
+    return m_cache_slot;
+  }
+
   void set_aggregate_op(Aggregate agg_op);
   void update_aggregate(int64_t val);
 
@@ -195,8 +203,11 @@ private:
   bool m_time_field;
   Ptr<LogFieldAliasMap> m_alias_map; // map sINT <--> string
   SetFunc m_set_func;
+  int m_cache_slot; // fields marshalling the same data share a slot in the LogFieldCache, -1 if never cached
   TSMilestonesType milestone_from_m_name();
   int milestones_from_m_name(TSMilestonesType *m1, TSMilestonesType *m2);
+  unsigned _marshal(LogAccess *lad, char *buf);
+  const char *_find_cached(LogAccess *lad, unsigned *len);
 
 public:
   LINK(LogField, link);
@@ -255,6 +266,83 @@ private:
   Queue<LogField> m_field_list;
 };
 
+/*-------------------------------------------------------------------------
+  LogFieldCache
+
+  Holds the marshalled fields of the entry being logged, so that a field
+  used by several log objects, in their formats or their filters, is only
+  extracted from the LogAccess once. Only the fields in the shared set are
+  kept, the others are marshalled directly as before.
+  -------------------------------------------------------------------------*/
+
+class LogFieldCache
+{
+public:
+  static const size_t MAX_SLOTS = 256;
+  static const unsigned SPACE   = 4096;
+  typedef std::bitset<MAX_SLOTS> SlotSet;
+
+  explicit LogFieldCache(const SlotSet &shared) : m_shared(shared), m_used(0) {}
+
+  bool
+  is_shared(int slot) const
+  {
+    return slot >= 0 && m_shared.test(slot);
+  }
+
+  // Return the marshalled field in @a slot, nullptr if it is not cached yet.
+  const char *
+  find(int slot, unsigned *len) const
+  {
+    if (!m_valid.test(slot)) {
+      return nullptr;
+    }
+    *len = m_entries[slot].len;
+    return m_space + m_entries[slot].offset;
+  }
+
+  // Room to marshal @a len bytes into, nullptr if the cache is full.
+  char *
+  reserve(unsigned len)
+  {
+    return len <= SPACE - m_used ? m_space + m_used : nullptr;
+  }
+
+  // The field in @a slot was marshalled into the space returned by reserve().
+  void
+  insert(int slot, unsigned len)
+  {
+    m_entries[slot].offset = m_used;
+    m_entries[slot].len    = len;
+    m_valid.set(slot);
+    m_used += len;
+  }
+
+  // The LogAccess was modified, forget everything marshalled from it so far.
+  void
+  clear()
+  {
+    m_valid.reset();
+    m_used = 0;
+  }
+
+  // noncopyable
+  LogFieldCache(const LogFieldCache &rhs) = delete;
+  LogFieldCache &operator=(const LogFieldCache &rhs) = delete;
+
+private:
+  struct Entry {
+    uint32_t offset;
+    uint32_t len;
+  };
+
+  const SlotSet &m_shared;
+  SlotSet m_valid;
+  unsigned m_used;
+  Entry m_entries[MAX_SLOTS];
+  alignas(INK_MIN_ALIGN) char m_space[SPACE];
+};
+
 /** Base IP address data.
     To unpack an IP address, the generic memory is first cast to
     this type to get the family. That pointer can then be static_cast
@@ -45,6 +45,7 @@
 #include "LogFilter.h"
 #include "LogFormat.h"
 #include "LogBuffer.h"
+#include "LogColumnBlock.h"
 #include "LogFile.h"
 #include "LogHost.h"
 #include "LogObject.h"
@@ -200,7 +201,7 @@ LogFile::open_file()
   // file.
   //
   if (!file_exists) {
-    if (m_file_format != LOG_FILE_BINARY && m_header && m_log) {
+    if (m_file_format != LOG_FILE_BINARY && m_file_format != LOG_FILE_COLUMNAR && m_header && m_log) {
       Debug("log-file", "writing header to LogFile %s", m_name);
       writeln(m_header, strlen(m_header), fileno(m_log->m_fp), m_name);
     }
@@ -264,6 +265,7 @@ LogFile::preproc_and_try_delete(LogBuffer *lb)
 {
   int ret = -1;
   LogBufferHeader *buffer_header;
+  uint64_t flush_seq;
 
   if (lb == nullptr) {
     Note("Cannot write LogBuffer to LogFile %s; LogBuffer is NULL", m_name);
@@ -271,6 +273,7 @@ LogFile::preproc_and_try_delete(LogBuffer *lb)
   }
 
   ink_atomic_increment(&lb->m_references, 1);
+  flush_seq = lb->m_flush_seq;
 
   if ((buffer_header = lb->header()) == nullptr) {
     Note("Cannot write LogBuffer to LogFile %s; LogBufferHeader is NULL", m_name);
@@ -304,6 +307,7 @@ LogFile::preproc_and_try_delete(LogBuffer *lb)
     // out the buffer-dependent data from the buffer-independent data.
     //
     LogFlushData *flush_data = new LogFlushData(this, lb);
+    flush_data->m_seq        = flush_seq;
 
     ProxyMutex *mutex = this_thread()->mutex.get();
 
@@ -311,26 +315,157 @@ LogFile::preproc_and_try_delete(LogBuffer *lb)
 
     RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, lb->header()->byte_count);
 
-    ink_atomiclist_push(Log::flush_data_list, flush_data);
-
-    Log::flush_notify->signal();
+    _push_flush_data(flush_data);
 
     //
     // LogBuffer will be deleted in flush thread
     //
     return 0;
+  } else if (m_file_format == LOG_FILE_COLUMNAR) {
+    //
+    // Encode the buffer here, on the preproc thread, and hand the block
+    // to the flush thread as we do for ASCII data.
+    //
+    int block_len = 0;
+    char *block   = LogColumnBlock::encode(buffer_header, &block_len);
+
+    if (block) {
+      LogFlushData *flush_data = new LogFlushData(this, block, block_len);
+      ProxyMutex *mutex        = this_thread()->mutex.get();
+
+      RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_num_flush_to_disk_stat, buffer_header->entry_count);
+      RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, block_len);
+
+      flush_data->m_seq = flush_seq;
+      _push_flush_data(flush_data);
+      flush_seq = 0;
+      ret       = 0;
+    }
   } else if (m_file_format == LOG_FILE_ASCII || m_file_format == LOG_FILE_PIPE) {
-    write_ascii_logbuffer3(buffer_header);
-    ret = 0;
+    write_ascii_logbuffer3(buffer_header, nullptr, flush_seq);
+    flush_seq = 0;
+    ret       = 0;
   } else {
     Note("Cannot write LogBuffer to LogFile %s; invalid file format: %d", m_name, m_file_format);
   }
 
 done:
+  // Let the flush thread know that there is nothing to write for the buffer.
+  _skip_flush_seq(flush_seq);
+
   LogBuffer::destroy(lb);
   return ret;
 }
 
+void
+LogFile::preproc_drop(LogBuffer *lb)
+{
+  _skip_flush_seq(lb->m_flush_seq);
+}
+
+/*-------------------------------------------------------------------------
+  LogFile::_push_flush_data
+
+  Hand the data over to the flush thread.
+  -------------------------------------------------------------------------*/
+
+void
+LogFile::_push_flush_data(LogFlushData *data)
+{
+  ink_atomiclist_push(Log::flush_data_list, data);
+  Log::flush_notify->signal();
+}
+
+void
+LogFile::_skip_flush_seq(uint64_t flush_seq)
+{
+  if (flush_seq) {
+    LogFlushData *flush_data = new LogFlushData(this, nullptr, 0);
+    flush_data->m_seq        = flush_seq;
+    _push_flush_data(flush_data);
+  }
+}
+
+/*-------------------------------------------------------------------------
+  LogFile::order_flush_data
+
+  Several preproc threads may work on the buffers of a LogObject at the
+  same time, so the data reaches the flush thread out of order. The data
+  of a buffer comes in one or more pieces, in order, the last one flagged
+  by m_last, and is held back in m_flush_pending until the pieces of all
+  the buffers queued before it have been written.
+
+  A buffer may never get there, if the LogObject is deleted before its
+  buffers are preprocessed for instance, so the flush thread skips the
+  missing buffers once it has waited for LOG_FLUSH_ORDER_TIMEOUT.
+  -------------------------------------------------------------------------*/
+
+static const ink_hrtime LOG_FLUSH_ORDER_TIMEOUT = HRTIME_SECONDS(5);
+
+bool
+LogFile::order_flush_data(LogFlushData *data, ink_hrtime now, std::vector<LogFlushData *> &ready)
+{
+  if (data->m_seq == 0 || data->m_seq < m_flush_seq) {
+    // Unordered, or too late.
+    ready.push_back(data);
+  } else if (data->m_seq > m_flush_seq) {
+    if (m_flush_pending.empty()) {
+      m_flush_wait_time = now;
+    }
+    m_flush_pending.emplace(data->m_seq, data);
+  } else {
+    ready.push_back(data);
+    if (data->m_last) {
+      ++m_flush_seq;
+      m_flush_wait_time = now;
+      _release_flush_data(ready);
+    }
+  }
+
+  return !m_flush_pending.empty();
+}
+
+bool
+LogFile::expire_flush_data(ink_hrtime now, std::vector<LogFlushData *> &ready)
+{
+  if (!m_flush_pending.empty() && now - m_flush_wait_time >= LOG_FLUSH_ORDER_TIMEOUT) {
+    uint64_t next = m_flush_pending.begin()->first;
+
+    Debug("log-file", "%s: skipping log buffers %" PRIu64 " to %" PRIu64 ", they were not preprocessed in time", m_name,
+          m_flush_seq, next - 1);
+    m_flush_seq       = next;
+    m_flush_wait_time = now;
+    _release_flush_data(ready);
+  }
+
+  return !m_flush_pending.empty();
+}
+
+void
+LogFile::drain_flush_data(std::vector<LogFlushData *> &ready)
+{
+  while (!m_flush_pending.empty()) {
+    m_flush_seq = m_flush_pending.begin()->first;
+    _release_flush_data(ready);
+  }
+}
+
+void
+LogFile::_release_flush_data(std::vector<LogFlushData *> &ready)
+{
+  auto it = m_flush_pending.begin();
+
+  while (it != m_flush_pending.end() && it->first == m_flush_seq) {
+    LogFlushData *data = it->second;
+
+    ready.push_back(data);
+    if (data->m_last) {
+      ++m_flush_seq;
+    }
+    it = m_flush_pending.erase(it);
+  }
+}
+
 /*-------------------------------------------------------------------------
   LogFile::write_ascii_logbuffer
 
@@ -406,7 +541,7 @@ LogFile::write_ascii_logbuffer(LogBufferHeader *buffer_header, int fd, const cha
 }
 
 int
-LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_format)
+LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_format, uint64_t flush_seq)
 {
   Debug("log-file", "entering LogFile::write_ascii_logbuffer3 for %s "
                     "(this=%p)",
@@ -416,9 +551,10 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_
   ProxyMutex *mutex = this_thread()->mutex.get();
   LogBufferIterator iter(buffer_header);
   LogEntryHeader *entry_header;
-  int fmt_entry_count = 0;
-  int fmt_buf_bytes   = 0;
-  int total_bytes     = 0;
+  int fmt_entry_count           = 0;
+  int fmt_buf_bytes             = 0;
+  int total_bytes               = 0;
+  LogFlushData *last_flush_data = nullptr;
 
   LogFormatType format_type;
   char *fieldlist_str;
@@ -436,6 +572,7 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_
     Note("Invalid LogBuffer version %d in write_ascii_logbuffer; "
          "current version is %d",
          buffer_header->version, LOG_SEGMENT_VERSION);
+    _skip_flush_seq(flush_seq);
     return 0;
   }
 
@@ -484,21 +621,31 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_
       }
     } while ((entry_header = iter.next()));
 
-    // send the buffer to flush thread
+    // send the buffer to flush thread, holding on to it until we know
+    // whether it is the last one of the LogBuffer
     //
     LogFlushData *flush_data = new LogFlushData(this, ascii_buffer, fmt_buf_bytes);
+    flush_data->m_seq        = flush_seq;
 
     RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_num_flush_to_disk_stat, fmt_entry_count);
 
     RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, fmt_buf_bytes);
 
-    ink_atomiclist_push(Log::flush_data_list, flush_data);
-
-    Log::flush_notify->signal();
+    if (last_flush_data) {
+      last_flush_data->m_last = false;
+      _push_flush_data(last_flush_data);
+    }
+    last_flush_data = flush_data;
 
     total_bytes += fmt_buf_bytes;
   }
 
+  if (last_flush_data) {
+    _push_flush_data(last_flush_data);
+  } else {
+    _skip_flush_seq(flush_seq);
+  }
+
   return total_bytes;
 }
 
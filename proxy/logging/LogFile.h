@@ -26,12 +26,16 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <map>
+#include <vector>
 
 #include "ts/ink_platform.h"
+#include "ts/ink_hrtime.h"
 #include "LogBufferSink.h"
 
 class LogSock;
 class LogBuffer;
+class LogFlushData;
 struct LogBufferHeader;
 class LogObject;
 class BaseLogFile;
@@ -59,6 +63,29 @@ public:
   };
 
   int preproc_and_try_delete(LogBuffer *lb);
+  void preproc_drop(LogBuffer *lb);
+
+  /** Called by the flush thread for each @a data handed over by the
+      preproc threads. The data is appended to @a ready, along with the
+      data it was holding back, once the data of all the buffers queued
+      before has been seen.
+
+      @return true if data is held back, in which case the flush thread
+      should call expire_flush_data() later.
+   */
+  bool order_flush_data(LogFlushData *data, ink_hrtime now, std::vector<LogFlushData *> &ready);
+
+  /** Stop waiting for the data of missing buffers, and append what was
+      held back to @a ready, if that has been going on for too long.
+
+      @return true if data is still held back.
+   */
+  bool expire_flush_data(ink_hrtime now, std::vector<LogFlushData *> &ready);
+
+  /** Stop waiting for the data of missing buffers altogether, on shutdown,
+      and append all that was held back to @a ready.
+   */
+  void drain_flush_data(std::vector<LogFlushData *> &ready);
 
   int roll(long interval_start, long interval_end);
 
@@ -80,11 +107,20 @@ public:
   const char *
   get_format_name() const
   {
-    return (m_file_format == LOG_FILE_BINARY ? "binary" : (m_file_format == LOG_FILE_PIPE ? "ascii_pipe" : "ascii"));
+    switch (m_file_format) {
+    case LOG_FILE_BINARY:
+      return "binary";
+    case LOG_FILE_PIPE:
+      return "ascii_pipe";
+    case LOG_FILE_COLUMNAR:
+      return "columnar";
+    default:
+      return "ascii";
+    }
   }
 
   static int write_ascii_logbuffer(LogBufferHeader *buffer_header, int fd, const char *path, const char *alt_format = nullptr);
-  int write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_format = nullptr);
+  int write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_format = nullptr, uint64_t flush_seq = 0);
   static bool rolled_logfile(char *file);
   static bool exists(const char *pathname);
 
@@ -123,6 +159,17 @@ public:
   size_t m_max_line_size;     // size of longest log line (record)
   int m_fd;                   // this could back m_log or a pipe, depending on the situation
 
+private:
+  // Only used by the flush thread, to write the data of the buffers in
+  // the order of LogBuffer::m_flush_seq.
+  uint64_t m_flush_seq         = 1; // next buffer to write
+  ink_hrtime m_flush_wait_time = 0; // when the flush thread started to wait for it
+  std::multimap<uint64_t, LogFlushData *> m_flush_pending;
+
+  void _push_flush_data(LogFlushData *data);
+  void _skip_flush_seq(uint64_t flush_seq);
+  void _release_flush_data(std::vector<LogFlushData *> &ready);
+
 public:
   Link<LogFile> link;
   // noncopyable
@@ -40,6 +40,8 @@
 #include "Log.h"
 #include "ts/SimpleTokenizer.h"
 
+#include <algorithm>
+
 const char *LogFilter::OPERATOR_NAME[] = {"MATCH", "CASE_INSENSITIVE_MATCH", "CONTAIN", "CASE_INSENSITIVE_CONTAIN"};
 const char *LogFilter::ACTION_NAME[]   = {"REJECT", "ACCEPT", "WIPE_FIELD_VALUE"};
 
@@ -210,9 +212,73 @@ LogFilterString::_setValues(size_t n, char **value)
       }
       m_value_uppercase[i][j] = 0;
     }
+    _compile();
   }
 }
 
+void
+LogFilterString::_compile()
+{
+  if (m_num_values < 2) {
+    return;
+  }
+
+  switch (m_operator) {
+  case MATCH:
+  case CASE_INSENSITIVE_MATCH: {
+    bool nocase = (m_operator == CASE_INSENSITIVE_MATCH);
+
+    m_value_set = new ValueSet(m_num_values, ValueHash{nocase}, ValueEqual{nocase});
+    for (size_t i = 0; i < m_num_values; ++i) {
+      m_value_set->insert(m_value[i]);
+    }
+    break;
+  }
+  case CONTAIN:
+  case CASE_INSENSITIVE_CONTAIN:
+    m_contains = new RegexPrefilter;
+    for (size_t i = 0; i < m_num_values; ++i) {
+      m_contains->add_literal(m_value[i], i);
+    }
+    m_contains->build();
+    break;
+  default:
+    break;
+  }
+}
+
+/*-------------------------------------------------------------------------
+  LogFilterString::_containsAny
+
+  The automaton ignores case, so for CASE_INSENSITIVE_CONTAIN any candidate
+  is a match, while for CONTAIN the candidates are checked with strstr().
+  -------------------------------------------------------------------------*/
+
+bool
+LogFilterString::_containsAny(const char *field_value, bool nocase)
+{
+  int ids[MAX_CANDIDATES];
+  int n = m_contains->candidates(field_value, strlen(field_value), ids, MAX_CANDIDATES);
+
+  if (nocase) {
+    return n != 0; // -1 means more than MAX_CANDIDATES values were found
+  }
+  if (n < 0) {
+    for (size_t i = 0; i < m_num_values; ++i) {
+      if (strstr(field_value, m_value[i])) {
+        return true;
+      }
+    }
+    return false;
+  }
+  for (int k = 0; k < n; ++k) {
+    if (strstr(field_value, m_value[ids[k]])) {
+      return true;
+    }
+  }
+  return false;
+}
+
 LogFilterString::LogFilterString(const char *name, LogField *field, LogFilter::Action action, LogFilter::Operator oper,
                                  char *values)
   : LogFilter(name, field, action, oper)
@@ -266,6 +332,8 @@ LogFilterString::~LogFilterString()
     delete[] m_value_uppercase;
     delete[] m_length;
   }
+  delete m_value_set;
+  delete m_contains;
 }
 
 /*-------------------------------------------------------------------------
@@ -374,6 +442,9 @@ LogFilterString::wipe_this_entry(LogAccess *lad)
 
   The m_substr field tells us whether we can match based on substrings, or
   whether we should compare the entire string.
+
+  Filters with several values use the set or automaton built by _compile()
+  rather than comparing against each value in turn.
   -------------------------------------------------------------------------*/
 
 bool
@@ -401,39 +472,45 @@ LogFilterString::toss_this_entry(LogAccess *lad)
   m_field->marshal(lad, buf);
 
   bool cond_satisfied = false;
-  switch (m_operator) {
-  case MATCH:
-    // marsh_len is an upper bound on the length of the marshalled string
-    // because marsh_len counts padding and the eos. So for a MATCH
-    // operator, we use the DATA_LENGTH_LARGER length condition rather
-    // than DATA_LENGTH_EQUAL, which we would use if we had the actual
-    // length of the string. It is probably not worth computing the
-    // actual length, so we just use the fact that a MATCH is not possible
-    // when marsh_len <= (length of the filter string)
-    //
-    cond_satisfied = _checkCondition(&strcmp, buf, marsh_len, m_value, DATA_LENGTH_LARGER);
-    break;
-  case CASE_INSENSITIVE_MATCH:
-    cond_satisfied = _checkCondition(&strcasecmp, buf, marsh_len, m_value, DATA_LENGTH_LARGER);
-    break;
-  case CONTAIN:
-    cond_satisfied = _checkCondition(&_isSubstring, buf, marsh_len, m_value, DATA_LENGTH_LARGER);
-    break;
-  case CASE_INSENSITIVE_CONTAIN: {
-    if (big_buf) {
-      big_buf_upper = (char *)ats_malloc((unsigned int)marsh_len);
-      buf_upper     = big_buf_upper;
-    } else {
-      buf = small_buf; // make clang happy
+  if (m_value_set) {
+    cond_satisfied = m_value_set->count(buf) > 0;
+  } else if (m_contains) {
+    cond_satisfied = _containsAny(buf, m_operator == CASE_INSENSITIVE_CONTAIN);
+  } else {
+    switch (m_operator) {
+    case MATCH:
+      // marsh_len is an upper bound on the length of the marshalled string
+      // because marsh_len counts padding and the eos. So for a MATCH
+      // operator, we use the DATA_LENGTH_LARGER length condition rather
+      // than DATA_LENGTH_EQUAL, which we would use if we had the actual
+      // length of the string. It is probably not worth computing the
+      // actual length, so we just use the fact that a MATCH is not possible
+      // when marsh_len <= (length of the filter string)
+      //
+      cond_satisfied = _checkCondition(&strcmp, buf, marsh_len, m_value, DATA_LENGTH_LARGER);
+      break;
+    case CASE_INSENSITIVE_MATCH:
+      cond_satisfied = _checkCondition(&strcasecmp, buf, marsh_len, m_value, DATA_LENGTH_LARGER);
+      break;
+    case CONTAIN:
+      cond_satisfied = _checkCondition(&_isSubstring, buf, marsh_len, m_value, DATA_LENGTH_LARGER);
+      break;
+    case CASE_INSENSITIVE_CONTAIN: {
+      if (big_buf) {
+        big_buf_upper = (char *)ats_malloc((unsigned int)marsh_len);
+        buf_upper     = big_buf_upper;
+      } else {
+        buf = small_buf; // make clang happy
+      }
+      for (size_t i = 0; i < marsh_len; i++) {
+        buf_upper[i] = ParseRules::ink_toupper(buf[i]);
+      }
+      cond_satisfied = _checkCondition(&_isSubstring, buf_upper, marsh_len, m_value_uppercase, DATA_LENGTH_LARGER);
+      break;
     }
-    for (size_t i = 0; i < marsh_len; i++) {
-      buf_upper[i] = ParseRules::ink_toupper(buf[i]);
+    default:
+      ink_assert(!"INVALID FILTER OPERATOR");
     }
-    cond_satisfied = _checkCondition(&_isSubstring, buf_upper, marsh_len, m_value_uppercase, DATA_LENGTH_LARGER);
-    break;
-  }
-  default:
-    ink_assert(!"INVALID FILTER OPERATOR");
   }
 
   ats_free(big_buf);
@@ -474,7 +551,34 @@ LogFilterInt::_setValues(size_t n, int64_t *value)
   if (n) {
     m_value = new int64_t[n];
     memcpy(m_value, value, n * sizeof(int64_t));
+
+    // Long lists such as status codes are mostly runs of consecutive values,
+    // so they are checked as a few ranges.
+    std::vector<int64_t> sorted(value, value + n);
+    std::sort(sorted.begin(), sorted.end());
+    for (int64_t v : sorted) {
+      // Nothing is past a range ending at INT64_MAX, and checking that first keeps the + 1 from overflowing.
+      if (!m_ranges.empty() && (m_ranges.back().second == INT64_MAX || v <= m_ranges.back().second + 1)) {
+        m_ranges.back().second = std::max(m_ranges.back().second, v);
+      } else {
+        m_ranges.emplace_back(v, v);
+      }
+    }
+  }
+}
+
+bool
+LogFilterInt::_isMatch(int64_t value) const
+{
+  // most common case is single value, speed it up a little bit by unrolling
+  //
+  if (m_num_values == 1) {
+    return value == *m_value;
   }
+
+  // the last range that starts at or before value
+  auto spot = std::upper_bound(m_ranges.begin(), m_ranges.end(), std::make_pair(value, INT64_MAX));
+  return spot != m_ranges.begin() && value <= (--spot)->second;
 }
 
 // TODO: ival should be int64_t
@@ -607,7 +711,6 @@ LogFilterInt::wipe_this_entry(LogAccess *lad)
     return false;
   }
 
-  bool cond_satisfied = false;
   int64_t value;
 
   m_field->marshal(lad, (char *)&value);
@@ -617,21 +720,7 @@ LogFilterInt::wipe_this_entry(LogAccess *lad)
   // we don't use m_operator because we consider all operators to be
   // equivalent to "MATCH" for an integer field
   //
-
-  // most common case is single value, speed it up a little bit by unrolling
-  //
-  if (m_num_values == 1) {
-    cond_satisfied = (value == *m_value);
-  } else {
-    for (size_t i = 0; i < m_num_values; ++i) {
-      if (value == m_value[i]) {
-        cond_satisfied = true;
-        break;
-      }
-    }
-  }
-
-  return cond_satisfied;
+  return _isMatch(value);
 }
 
 /*-------------------------------------------------------------------------
@@ -645,7 +734,6 @@ LogFilterInt::toss_this_entry(LogAccess *lad)
     return false;
   }
 
-  bool cond_satisfied = false;
   int64_t value;
 
   m_field->marshal(lad, (char *)&value);
@@ -655,19 +743,7 @@ LogFilterInt::toss_this_entry(LogAccess *lad)
   // we don't use m_operator because we consider all operators to be
   // equivalent to "MATCH" for an integer field
   //
-
-  // most common case is single value, speed it up a little bit by unrolling
-  //
-  if (m_num_values == 1) {
-    cond_satisfied = (value == *m_value);
-  } else {
-    for (size_t i = 0; i < m_num_values; ++i) {
-      if (value == m_value[i]) {
-        cond_satisfied = true;
-        break;
-      }
-    }
-  }
+  bool cond_satisfied = _isMatch(value);
 
   return (m_action == REJECT && cond_satisfied) || (m_action == ACCEPT && !cond_satisfied);
 }
@@ -1084,6 +1160,9 @@ LogFilterList::display(FILE *fd)
 #if TS_HAS_TESTS
 #include "ts/TestBox.h"
 
+#include <string>
+#include <vector>
+
 REGRESSION_TEST(Log_FilterParse)(RegressionTest *t, int /* atype */, int *pstatus)
 {
   TestBox box(t, pstatus);
@@ -1109,4 +1188,127 @@ REGRESSION_TEST(Log_FilterParse)(RegressionTest *t, int /* atype */, int *pstatu
 #undef CHECK_FORMAT_PARSE
 }
 
+// An entry with just a URL and a status code.
+class TestFilterAccess : public LogAccess
+{
+public:
+  LogEntryType
+  entry_type() const override
+  {
+    return LOG_ENTRY_HTTP;
+  }
+
+  int
+  marshal_client_req_url(char *buf) override
+  {
+    int len = LogAccess::strlen(url.c_str());
+    if (buf) {
+      marshal_str(buf, url.c_str(), len);
+    }
+    return len;
+  }
+
+  int
+  marshal_proxy_resp_status_code(char *buf) override
+  {
+    if (buf) {
+      marshal_int(buf, status);
+    }
+    return INK_MIN_ALIGN;
+  }
+
+  std::string url;
+  int64_t status = 0;
+};
+
+static const char *test_filter_urls[] = {
+  "http://www.example.com/index.html",     "http://img3.example.com/a/b/c.jpg?w=100", "https://cdn.example.net/Video/Seg-17.ts",
+  "http://WWW.EXAMPLE.COM/INDEX.HTML",     "http://api.example.org/v1/items?id=42",   "http://example.com/",
+  "http://www.example.com/index.html?x=1", "h",                                       "",
+};
+
+static const char *test_filter_values = "http://www.example.com/index.html,img3,/video/,.ts,example.org/v1,"
+                                        "http://example.com/,?x=1,seg-17,nothing-like-this,h,index";
+
+REGRESSION_TEST(Log_FilterCompiled)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  TestFilterAccess lad;
+
+  box = REGRESSION_TEST_PASSED;
+
+  // A filter with many values must agree with one filter per value, which are not compiled.
+  for (unsigned oper = 0; oper < LogFilter::N_OPERATORS; ++oper) {
+    char cond[1024];
+    std::vector<LogFilter *> singles;
+
+    snprintf(cond, sizeof(cond), "cqu %s %s", LogFilter::OPERATOR_NAME[oper], test_filter_values);
+    LogFilter *all = LogFilter::parse("all", LogFilter::REJECT, cond);
+    box.check(all != nullptr && all->get_num_values() == 11, "failed to parse '%s'", cond);
+    if (!all) {
+      continue;
+    }
+
+    SimpleTokenizer tok(test_filter_values, ',');
+    for (char *value = tok.getNext(); value; value = tok.getNext()) {
+      snprintf(cond, sizeof(cond), "cqu %s %s", LogFilter::OPERATOR_NAME[oper], value);
+      singles.push_back(LogFilter::parse("single", LogFilter::REJECT, cond));
+    }
+
+    for (auto url : test_filter_urls) {
+      bool expected = false;
+      lad.url       = url;
+      for (auto single : singles) {
+        expected = expected || single->toss_this_entry(&lad);
+      }
+      box.check(all->toss_this_entry(&lad) == expected, "%s of '%s' should be %s", LogFilter::OPERATOR_NAME[oper], url,
+                expected ? "tossed" : "kept");
+    }
+
+    for (auto single : singles) {
+      delete single;
+    }
+    delete all;
+  }
+
+  // Integer values are checked as ranges.
+  char cond[]      = "pssc MATCH 204,200,201,202,203,206,404,301,302,5";
+  LogFilter *ints  = LogFilter::parse("ints", LogFilter::ACCEPT, cond);
+  int64_t kept[]   = {5, 200, 201, 202, 203, 204, 206, 301, 302, 404};
+  int64_t tossed[] = {-1, 0, 4, 6, 199, 205, 207, 300, 303, 403, 405, INT64_MAX};
+
+  box.check(ints != nullptr, "failed to parse integer filter");
+  if (ints) {
+    for (auto status : kept) {
+      lad.status = status;
+      box.check(!ints->toss_this_entry(&lad), "status %" PRId64 " should be kept", status);
+    }
+    for (auto status : tossed) {
+      lad.status = status;
+      box.check(ints->toss_this_entry(&lad), "status %" PRId64 " should be tossed", status);
+    }
+    delete ints;
+  }
+
+  // Ranges up to the largest value, which the configuration parser can't produce.
+  int64_t max_values[] = {INT64_MAX, INT64_MAX - 1, INT64_MAX, 0};
+  int64_t max_kept[]   = {0, INT64_MAX - 1, INT64_MAX};
+  int64_t max_tossed[] = {-1, 1, INT64_MAX - 2};
+  LogField *field      = Log::global_field_list.find_by_symbol("pssc");
+  LogFilter *max_ints  = field ? new LogFilterInt("max_ints", field, LogFilter::ACCEPT, LogFilter::MATCH, 4, max_values) : nullptr;
+
+  box.check(max_ints != nullptr, "no pssc field");
+  if (max_ints) {
+    for (auto status : max_kept) {
+      lad.status = status;
+      box.check(!max_ints->toss_this_entry(&lad), "status %" PRId64 " should be kept", status);
+    }
+    for (auto status : max_tossed) {
+      lad.status = status;
+      box.check(max_ints->toss_this_entry(&lad), "status %" PRId64 " should be tossed", status);
+    }
+    delete max_ints;
+  }
+}
+
 #endif
@@ -25,12 +25,18 @@
 #define LOG_FILTER_H
 
 #include "ts/ink_platform.h"
+#include "ts/HashFNV.h"
 #include "ts/IpMap.h"
 #include "ts/Ptr.h"
+#include "ts/RegexPrefilter.h"
 #include "LogAccess.h"
 #include "LogField.h"
 #include "LogFormat.h"
 
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 /*-------------------------------------------------------------------------
   LogFilter
 
@@ -81,6 +87,12 @@ public:
     return m_name;
   }
 
+  LogField *
+  field() const
+  {
+    return m_field;
+  }
+
   Type
   type() const
   {
@@ -148,7 +160,49 @@ private:
   char **m_value_uppercase = nullptr; // m_value in all uppercase
   size_t *m_length         = nullptr; // length of m_value string
 
+  // Filters with more than one value are compiled when they are created: the values of a
+  // MATCH filter go into a hash set, those of a CONTAIN filter into one automaton that
+  // finds all of them in a single pass over the field.
+  //
+  struct ValueHash {
+    bool nocase;
+
+    size_t
+    operator()(const char *s) const
+    {
+      ATSHash32FNV1a fnv;
+
+      if (nocase) {
+        fnv.update(s, strlen(s), ATSHash::nocase());
+      } else {
+        fnv.update(s, strlen(s));
+      }
+      fnv.final();
+      return fnv.get();
+    }
+  };
+
+  struct ValueEqual {
+    bool nocase;
+
+    bool
+    operator()(const char *s1, const char *s2) const
+    {
+      return 0 == (nocase ? strcasecmp(s1, s2) : strcmp(s1, s2));
+    }
+  };
+
+  typedef std::unordered_set<const char *, ValueHash, ValueEqual> ValueSet;
+
+  ValueSet *m_value_set      = nullptr; // m_value, for MATCH and CASE_INSENSITIVE_MATCH
+  RegexPrefilter *m_contains = nullptr; // m_value, for CONTAIN and CASE_INSENSITIVE_CONTAIN
+
+  // Candidates looked at before falling back to trying every value.
+  static const int MAX_CANDIDATES = 16;
+
   void _setValues(size_t n, char **value);
+  void _compile();
+  bool _containsAny(const char *field_value, bool nocase);
 
   // note: OperatorFunction's must return 0 (zero) if condition is satisfied
   // (as strcmp does)
@@ -203,7 +257,12 @@ public:
 private:
   int64_t *m_value = nullptr; // the array of values
 
+  // m_value as sorted, disjoint ranges of consecutive values
+  //
+  std::vector<std::pair<int64_t, int64_t>> m_ranges;
+
   void _setValues(size_t n, int64_t *value);
+  bool _isMatch(int64_t value) const;
   int _convertStringToInt(char *val, int64_t *ival, LogFieldAliasMap *map);
 
   // -- member functions that are not allowed --
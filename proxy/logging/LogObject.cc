@@ -30,14 +30,21 @@
 #include "ts/CryptoHash.h"
 #include "ts/INK_MD5.h"
 #include "P_EventSystem.h"
+#include "I_Net.h"
 #include "LogUtils.h"
 #include "LogField.h"
 #include "LogObject.h"
 #include "LogConfig.h"
 #include "LogAccess.h"
 #include "Log.h"
+#include "LogColumnBlock.h"
 #include "ts/TestBox.h"
 
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
 static bool
 should_roll_on_time(Log::RollingEnabledValues roll)
 {
@@ -50,8 +57,15 @@ should_roll_on_size(Log::RollingEnabledValues roll)
   return roll == Log::ROLL_ON_SIZE_ONLY || roll == Log::ROLL_ON_TIME_OR_SIZE;
 }
 
+// The time of an entry, in microseconds.
+static int64_t
+entry_time(LogEntryHeader *entry)
+{
+  return entry->timestamp * 1000000 + entry->timestamp_usec;
+}
+
 size_t
-LogBufferManager::preproc_buffers(LogBufferSink *sink)
+LogBufferManager::preproc_buffers(LogBufferSink *sink, int64_t merge_until)
 {
   SList(LogBuffer, write_link) q(write_list.popall()), new_q;
   LogBuffer *b = nullptr;
@@ -59,11 +73,16 @@ LogBufferManager::preproc_buffers(LogBufferSink *sink)
     if (b->m_references || b->m_state.s.num_writers) {
       // Still has outstanding references.
       write_list.push(b);
+      // And its entries may not all be there yet.
+      if (merge_until >= 0) {
+        merge_until = std::min(merge_until, (int64_t)b->header()->low_timestamp * 1000000);
+      }
     } else if (_num_flush_buffers > FLUSH_ARRAY_SIZE) {
       ink_atomic_increment(&_num_flush_buffers, -1);
       Warning("Dropping log buffer, can't keep up.");
       RecIncrRawStat(log_rsb, this_thread()->mutex->thread_holding, log_stat_bytes_lost_before_preproc_stat,
                      b->header()->byte_count);
+      sink->preproc_drop(b);
       delete b;
     } else {
       new_q.push(b);
@@ -73,12 +92,113 @@ LogBufferManager::preproc_buffers(LogBufferSink *sink)
   int prepared = 0;
   while ((b = new_q.pop())) {
     b->update_header_data();
-    sink->preproc_and_try_delete(b);
-    ink_atomic_increment(&_num_flush_buffers, -1);
+    if (merge_until >= 0) {
+      LogBufferHeader *header = b->header();
+      _merge_list.push_back({b, (char *)header + header->data_offset, header->entry_count});
+    } else {
+      sink->preproc_and_try_delete(b);
+      ink_atomic_increment(&_num_flush_buffers, -1);
+      prepared++;
+    }
+  }
+
+  if (merge_until >= 0) {
+    prepared = _merge_buffers(sink, merge_until);
+  }
+
+  return prepared;
+}
+
+/*-------------------------------------------------------------------------
+  LogBufferManager::_merge_buffers
+
+  Each thread buffer fills and flushes on its own, so the entries of the
+  held back buffers overlap in time. The entries logged before merge_until
+  are merged in time order, copied to new buffers if they interleave, and
+  the rest wait for the next call. The buffers that are merged whole, in
+  order, are handed to the sink as they are.
+  -------------------------------------------------------------------------*/
+
+size_t
+LogBufferManager::_merge_buffers(LogBufferSink *sink, int64_t merge_until)
+{
+  struct MergeEntry {
+    int64_t time;
+    LogEntryHeader *entry;
+  };
+  std::vector<MergeEntry> entries;
+  bool whole = true;
+
+  for (MergeBuffer &m : _merge_list) {
+    unsigned count = m.buffer->header()->entry_count;
+    unsigned left  = m.left;
+
+    // Entries are in time order within a buffer.
+    while (m.left && entry_time((LogEntryHeader *)m.next) < merge_until) {
+      LogEntryHeader *entry = (LogEntryHeader *)m.next;
+      entries.push_back({entry_time(entry), entry});
+      m.next += entry->entry_len;
+      --m.left;
+    }
+    if (m.left != left && (left != count || m.left)) {
+      whole = false;
+    }
+  }
+
+  size_t prepared = 0;
+  auto earlier    = [](const MergeEntry &lhs, const MergeEntry &rhs) { return lhs.time < rhs.time; };
+
+  if (!whole || !std::is_sorted(entries.begin(), entries.end(), earlier)) {
+    std::stable_sort(entries.begin(), entries.end(), earlier);
+
+    LogObject *owner  = _merge_list.front().buffer->get_owner();
+    LogBuffer *merged = nullptr;
+
+    for (const MergeEntry &e : entries) {
+      size_t write_size = e.entry->entry_len - sizeof(LogEntryHeader);
+      size_t offset;
+
+      if (merged && merged->checkout_write(&offset, write_size) != LogBuffer::LB_OK) {
+        merged->update_header_data();
+        sink->preproc_and_try_delete(merged);
+        prepared++;
+        merged = nullptr;
+      }
+      if (!merged) {
+        // The entry came from a buffer of the same size, so it fits.
+        merged                               = new LogBuffer(owner, Log::config->log_buffer_size);
+        LogBuffer::LB_ResultCode result_code = merged->checkout_write(&offset, write_size);
+        ink_release_assert(result_code == LogBuffer::LB_OK);
+      }
+
+      // Copy the entry header too, for its timestamp.
+      memcpy(&(*merged)[offset - sizeof(LogEntryHeader)], e.entry, e.entry->entry_len);
+      merged->checkin_write(offset);
+    }
+
+    merged->update_header_data();
+    sink->preproc_and_try_delete(merged);
     prepared++;
   }
 
-  Debug("log-logbuffer", "prepared %d buffers", prepared);
+  // Release the buffers whose entries are all merged.
+  auto m = _merge_list.begin();
+  while (m != _merge_list.end()) {
+    if (m->left) {
+      ++m;
+      continue;
+    }
+
+    if (whole) {
+      sink->preproc_and_try_delete(m->buffer);
+      prepared++;
+    } else {
+      delete m->buffer;
+    }
+    ink_atomic_increment(&_num_flush_buffers, -1);
+    m = _merge_list.erase(m);
+  }
+
   return prepared;
 }
 
@@ -98,7 +218,8 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
     m_rolling_offset_hr(rolling_offset_hr),
     m_rolling_size_mb(rolling_size_mb),
     m_last_roll_time(0),
-    m_buffer_manager_idx(0)
+    m_buffer_manager_idx(0),
+    m_flush_seq(0)
 {
   ink_release_assert(format);
   m_format         = new LogFormat(*format);
@@ -106,6 +227,8 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
 
   if (file_format == LOG_FILE_BINARY) {
     m_flags |= BINARY;
+  } else if (file_format == LOG_FILE_COLUMNAR) {
+    m_flags |= BINARY | COLUMNAR;
   } else if (file_format == LOG_FILE_PIPE) {
     m_flags |= WRITES_TO_PIPE;
   }
@@ -123,6 +246,7 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
   LogBuffer *b = new LogBuffer(this, Log::config->log_buffer_size);
   ink_assert(b);
   SET_FREELIST_POINTER_VERSION(m_log_buffer, b, 0);
+  _setup_thread_buffers();
 
   _setup_rolling(rolling_enabled, rolling_interval_sec, rolling_offset_hr, rolling_size_mb);
 
@@ -143,7 +267,8 @@ LogObject::LogObject(LogObject &rhs)
     m_rolling_offset_hr(rhs.m_rolling_offset_hr),
     m_rolling_size_mb(rhs.m_rolling_size_mb),
     m_last_roll_time(rhs.m_last_roll_time),
-    m_buffer_manager_idx(rhs.m_buffer_manager_idx)
+    m_buffer_manager_idx(rhs.m_buffer_manager_idx),
+    m_flush_seq(0)
 
 {
   m_format         = new LogFormat(*(rhs.m_format));
@@ -170,6 +295,7 @@ LogObject::LogObject(LogObject &rhs)
   LogBuffer *b = new LogBuffer(this, Log::config->log_buffer_size);
   ink_assert(b);
   SET_FREELIST_POINTER_VERSION(m_log_buffer, b, 0);
+  _setup_thread_buffers();
 
   Debug("log-config", "exiting LogObject copy constructor, "
                       "filename=%s this=%p",
@@ -180,7 +306,10 @@ LogObject::~LogObject()
 {
   Debug("log-config", "entering LogObject destructor, this=%p", this);
 
-  preproc_buffers();
+  // Merge all the entries held back, nothing comes after them.
+  for (int i = 0; i < m_flush_threads; ++i) {
+    _preproc_buffers(i, m_n_thread_buffers ? INT64_MAX : -1);
+  }
 
   // here we need to free LogHost if it is remote logging.
   if (is_collation_client()) {
@@ -194,6 +323,27 @@ LogObject::~LogObject()
   delete m_format;
   delete[] m_buffer_manager;
   delete (LogBuffer *)FREELIST_POINTER(m_log_buffer);
+  for (int i = 0; i < m_n_thread_buffers; ++i) {
+    delete (LogBuffer *)FREELIST_POINTER(m_thread_buffers[i].buffer);
+  }
+  ats_memalign_free(m_thread_buffers);
+}
+
+void
+LogObject::_setup_thread_buffers()
+{
+  m_thread_buffers   = nullptr;
+  m_n_thread_buffers = 0;
+  m_retiring_buffers = 0;
+
+  // Only the network threads, which do most of the logging, get their own buffer.
+  if (Log::config->thread_buffers && eventProcessor.thread_group[ET_NET]._count > 0) {
+    m_n_thread_buffers = eventProcessor.thread_group[ET_NET]._count;
+    m_thread_buffers   = (ThreadBuffer *)ats_memalign(LOG_OBJECT_CACHE_LINE_SIZE, m_n_thread_buffers * sizeof(ThreadBuffer));
+    for (int i = 0; i < m_n_thread_buffers; ++i) {
+      new (&m_thread_buffers[i]) ThreadBuffer();
+    }
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -241,6 +391,10 @@ LogObject::generate_filenames(const char *log_dir, const char *basename, LogFile
       ext     = LOG_FILE_PIPE_OBJECT_FILENAME_EXTENSION;
       ext_len = 5;
       break;
+    case LOG_FILE_COLUMNAR:
+      ext     = LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION;
+      ext_len = 5;
+      break;
     default:
       ink_assert(!"unknown file format");
     }
@@ -332,7 +486,10 @@ LogObject::compute_signature(LogFormat *format, char *filename, unsigned int fla
     char *buffer = (char *)ats_malloc(buf_size);
 
     ink_string_concatenate_strings(buffer, fl, ps, filename,
-                                   flags & LogObject::BINARY ? "B" : (flags & LogObject::WRITES_TO_PIPE ? "P" : "A"), NULL);
+                                   flags & LogObject::COLUMNAR ?
+                                     "C" :
+                                     (flags & LogObject::BINARY ? "B" : (flags & LogObject::WRITES_TO_PIPE ? "P" : "A")),
+                                   NULL);
 
     CryptoHash hash;
     MD5Context().hash_immediate(hash, buffer, buf_size - 1);
@@ -361,17 +518,19 @@ LogObject::display(FILE *fd)
 }
 
 static head_p
-increment_pointer_version(volatile head_p *dst)
+increment_pointer_version(volatile head_p *dst, unsigned *retries)
 {
   head_p h;
   head_p new_h;
 
-  do {
+  while (true) {
     INK_QUEUE_LD(h, *dst);
     SET_FREELIST_POINTER_VERSION(new_h, FREELIST_POINTER(h), FREELIST_VERSION(h) + 1);
-  } while (ink_atomic_cas(&dst->data, h.data, new_h.data) == false);
-
-  return h;
+    if (ink_atomic_cas(&dst->data, h.data, new_h.data)) {
+      return h;
+    }
+    ++*retries;
+  }
 }
 
 static bool
@@ -383,24 +542,100 @@ write_pointer_version(volatile head_p *dst, head_p old_h, void *ptr, head_p::ver
   return ink_atomic_cas(&dst->data, old_h.data, tmp_h.data);
 }
 
+// The work buffer of the calling thread. EThread::id only numbers the threads
+// within their group, so it is used for the network threads alone.
+volatile head_p *
+LogObject::_work_buffer()
+{
+  EThread *thread = this_ethread();
+
+  if (thread && thread->is_event_type(ET_NET) && thread->id >= 0 && thread->id < m_n_thread_buffers) {
+    return &m_thread_buffers[thread->id].buffer;
+  }
+  return &m_log_buffer;
+}
+
+/*-------------------------------------------------------------------------
+  LogObject::_merge_watermark
+
+  The time, in microseconds, before which no more entries can be queued:
+  the creation time of the oldest work buffer that has entries, or now.
+  Entries are stamped when they are checked out, so a work buffer holds no
+  entry older than itself. A buffer that is being swapped out is in no
+  work buffer and not queued yet either, so nothing is merged meanwhile.
+  -------------------------------------------------------------------------*/
+
+int64_t
+LogObject::_merge_watermark()
+{
+  struct timeval tp = ink_gettimeofday();
+  int64_t watermark = tp.tv_sec * 1000000 + tp.tv_usec;
+  head_p h;
+
+  for (int i = -1; i < m_n_thread_buffers; ++i) {
+    volatile head_p *work_buffer = i < 0 ? &m_log_buffer : &m_thread_buffers[i].buffer;
+
+    INK_QUEUE_LD(h, *work_buffer);
+    LogBuffer *b = (LogBuffer *)FREELIST_POINTER(h);
+    if (b && b->m_state.s.num_entries) {
+      watermark = std::min(watermark, (int64_t)b->header()->low_timestamp * 1000000);
+    }
+  }
+
+  if (ink_atomic_increment(&m_retiring_buffers, 0)) {
+    return 0;
+  }
+  return watermark;
+}
+
+size_t
+LogObject::_preproc_buffers(int idx, int64_t merge_until)
+{
+  size_t nfb;
+
+  if (idx == -1)
+    idx = m_n_thread_buffers ? 0 : m_buffer_manager_idx++ % m_flush_threads;
+
+  if (m_logFile) {
+    nfb = m_buffer_manager[idx].preproc_buffers(m_logFile.get(), merge_until);
+  } else {
+    nfb = m_buffer_manager[idx].preproc_buffers(&m_host_list, merge_until);
+  }
+  return nfb;
+}
+
 LogBuffer *
-LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
+LogObject::_checkout_write(volatile head_p *work_buffer, size_t *write_offset, size_t bytes_needed)
 {
   LogBuffer::LB_ResultCode result_code;
   LogBuffer *buffer;
   LogBuffer *new_buffer;
-  bool retry = true;
+  bool retry       = true;
+  unsigned retries = 0;
   head_p old_h;
 
   do {
+    // Thread work buffers are created when their thread first logs.
+    INK_QUEUE_LD(old_h, *work_buffer);
+    if (FREELIST_POINTER(old_h) == nullptr) {
+      if (!write_offset) {
+        return nullptr;
+      }
+      new_buffer = new LogBuffer(this, Log::config->log_buffer_size);
+      if (!write_pointer_version(work_buffer, old_h, new_buffer, 0)) {
+        delete new_buffer;
+      }
+      continue;
+    }
+
     // To avoid a race condition, we keep a count of held references in
     // the pointer itself and add this to m_outstanding_references.
 
-    // Increment the version of m_log_buffer, returning the previous version.
-    head_p h = increment_pointer_version(&m_log_buffer);
+    // Increment the version of the work buffer, returning the previous version.
+    head_p h = increment_pointer_version(work_buffer, &retries);
 
     buffer           = (LogBuffer *)FREELIST_POINTER(h);
-    result_code      = buffer->checkout_write(write_offset, bytes_needed);
+    result_code      = buffer->checkout_write(write_offset, bytes_needed, &retries);
     bool decremented = false;
 
     switch (result_code) {
@@ -416,10 +651,11 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
       new_buffer = new LogBuffer(this, Log::config->log_buffer_size);
 
       // swap the new buffer for the old one
+      ink_atomic_increment(&m_retiring_buffers, 1);
       INK_WRITE_MEMORY_BARRIER;
 
       do {
-        INK_QUEUE_LD(old_h, m_log_buffer);
+        INK_QUEUE_LD(old_h, *work_buffer);
         // we may depend on comparing the old pointer to the new pointer to detect buffer swaps
         // without worrying about pointer collisions because we always allocate a new LogBuffer
         // before freeing the old one
@@ -431,17 +667,17 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
           delete new_buffer;
           break;
         }
-      } while (!write_pointer_version(&m_log_buffer, old_h, new_buffer, 0));
+      } while (!write_pointer_version(work_buffer, old_h, new_buffer, 0));
 
       if (FREELIST_POINTER(old_h) == FREELIST_POINTER(h)) {
         ink_atomic_increment(&buffer->m_references, FREELIST_VERSION(old_h) - 1);
 
-        int idx = m_buffer_manager_idx++ % m_flush_threads;
         Debug("log-logbuffer", "adding buffer %d to flush list after checkout", buffer->get_id());
-        m_buffer_manager[idx].add_to_flush_queue(buffer);
+        int idx = add_to_flush_queue(buffer);
         Log::preproc_notify[idx].signal();
         buffer = nullptr;
       }
+      ink_atomic_increment(&m_retiring_buffers, -1);
 
       decremented = true;
       break;
@@ -450,6 +686,7 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
       // no more room, but another thread should be taking care of
       // creating a new buffer, so try again
       //
+      ++retries;
       break;
 
     case LogBuffer::LB_BUFFER_TOO_SMALL:
@@ -467,16 +704,19 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
     if (!decremented) {
       head_p old_h;
 
-      // The do-while loop protects us from races while we're examining ptr(old_h) and ptr(h)
+      // The loop protects us from races while we're examining ptr(old_h) and ptr(h)
       // (essentially an optimistic lock)
-      do {
-        INK_QUEUE_LD(old_h, m_log_buffer);
+      while (true) {
+        INK_QUEUE_LD(old_h, *work_buffer);
         if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h)) {
           // Another thread's allocated a new LogBuffer, we don't need to do anything more
           break;
         }
-
-      } while (!write_pointer_version(&m_log_buffer, old_h, FREELIST_POINTER(h), FREELIST_VERSION(old_h) - 1));
+        if (write_pointer_version(work_buffer, old_h, FREELIST_POINTER(h), FREELIST_VERSION(old_h) - 1)) {
+          break;
+        }
+        ++retries;
+      }
 
       if (FREELIST_POINTER(old_h) != FREELIST_POINTER(h)) {
         // Another thread's allocated a new LogBuffer, meaning this LogObject is no longer referencing the old LogBuffer
@@ -490,6 +730,12 @@ LogObject::_checkout_write(size_t *write_offset, size_t bytes_needed)
   if (result_code == LogBuffer::LB_BUFFER_TOO_SMALL) {
     buffer = nullptr;
   }
+
+  // Count the compare and swaps that failed because other threads were using the same buffer.
+  EThread *thread = this_ethread();
+  if (retries && thread) {
+    RecIncrRawStat(log_rsb, thread, log_stat_buffer_checkout_retries_stat, retries);
+  }
   return buffer;
 }
 
@@ -599,7 +845,7 @@ LogObject::log(LogAccess *lad, const char *text_entry)
   }
 
   // Now try to place this entry in the current LogBuffer.
-  buffer = _checkout_write(&offset, bytes_needed);
+  buffer = _checkout_write(_work_buffer(), &offset, bytes_needed);
 
   if (!buffer) {
     Note("Skipping the current log entry for %s because its size (%zu) exceeds "
@@ -787,7 +1033,23 @@ LogObject::check_buffer_expiration(long time_now)
 {
   LogBuffer *b = (LogBuffer *)FREELIST_POINTER(m_log_buffer);
   if (b && time_now > b->expiration_time()) {
-    force_new_buffer();
+    _checkout_write(&m_log_buffer, nullptr, 0);
+  }
+
+  for (int i = 0; i < m_n_thread_buffers; ++i) {
+    b = (LogBuffer *)FREELIST_POINTER(m_thread_buffers[i].buffer);
+    if (b && time_now > b->expiration_time()) {
+      _checkout_write(&m_thread_buffers[i].buffer, nullptr, 0);
+    }
+  }
+}
+
+void
+LogObject::force_new_buffer()
+{
+  _checkout_write(&m_log_buffer, nullptr, 0);
+  for (int i = 0; i < m_n_thread_buffers; ++i) {
+    _checkout_write(&m_thread_buffers[i].buffer, nullptr, 0);
   }
 }
 
@@ -897,6 +1159,7 @@ LogObjectManager::_manage_object(LogObject *log_object, bool is_api_object, int
           _APIobjects.push_back(log_object);
         } else {
           _objects.push_back(log_object);
+          _update_shared_fields();
         }
 
         ink_release_assert(retVal == NO_FILENAME_CONFLICTS);
@@ -1157,6 +1420,44 @@ LogObjectManager::add_filter_to_all(LogFilter *filter)
   for (unsigned i = 0; i < this->_objects.length(); i++) {
     _objects[i]->add_filter(filter);
   }
+  _update_shared_fields();
+}
+
+// Find the fields marshalled more than once per entry, by several of the configured objects or by
+// the filters of one of them.
+void
+LogObjectManager::_update_shared_fields()
+{
+  LogFieldCache::SlotSet seen, shared;
+
+  for (unsigned i = 0; i < this->_objects.length(); i++) {
+    LogObject *obj = _objects[i];
+    LogFieldCache::SlotSet used;
+
+    if (obj->m_auto_created) {
+      continue;
+    }
+    if (obj->m_format) {
+      for (LogField *f = obj->m_format->m_field_list.first(); f; f = obj->m_format->m_field_list.next(f)) {
+        if (f->cache_slot() >= 0) {
+          used.set(f->cache_slot());
+        }
+      }
+    }
+    for (LogFilter *filter = obj->m_filter_list.first(); filter; filter = obj->m_filter_list.next(filter)) {
+      if (filter->field() && filter->field()->cache_slot() >= 0) {
+        int slot = filter->field()->cache_slot();
+        if (used.test(slot)) {
+          shared.set(slot);
+        }
+        used.set(slot);
+      }
+    }
+    shared |= seen & used;
+    seen |= used;
+  }
+
+  _shared_fields = shared;
 }
 
 void
@@ -1296,6 +1597,12 @@ LogObjectManager::log(LogAccess *lad)
 {
   int ret           = Log::SKIP;
   ProxyMutex *mutex = this_thread()->mutex.get();
+  LogFieldCache cache(_shared_fields);
+
+  // Fields used by several objects are extracted once for all of them.
+  if (_shared_fields.any()) {
+    lad->field_cache = &cache;
+  }
 
   for (unsigned i = 0; i < this->_objects.length(); i++) {
     //
@@ -1309,6 +1616,7 @@ LogObjectManager::log(LogAccess *lad)
 
     ret |= _objects[i]->log(lad);
   }
+  lad->field_cache = nullptr;
 
   //
   // The bit-field code in *ret* are priority chain:
@@ -1351,16 +1659,16 @@ LogObjectManager::flush_all_objects()
 #if TS_HAS_TESTS
 
 static LogObject *
-MakeTestLogObject(const char *name)
+MakeTestLogObject(const char *name, const char *format_str = nullptr, LogFileFormat file_format = LOG_FILE_ASCII)
 {
   const char *tmpdir = getenv("TMPDIR");
-  LogFormat format("testfmt", nullptr);
+  LogFormat format("testfmt", format_str);
 
   if (!tmpdir) {
     tmpdir = "/tmp";
   }
 
-  return new LogObject(&format, tmpdir, name, LOG_FILE_ASCII /* file_format */, name /* header */,
+  return new LogObject(&format, tmpdir, name, file_format, name /* header */,
                        Log::ROLL_ON_TIME_ONLY /* rolling_enabled */, 1 /* flush_threads */);
 }
 
@@ -1394,4 +1702,391 @@ REGRESSION_TEST(LogObjectManager_Transfer)(RegressionTest *t, int /* atype ATS_U
   box = REGRESSION_TEST_PASSED;
 }
 
+// A transaction with a few request headers, counting how often its fields are extracted.
+class TestLogAccess : public LogAccess
+{
+public:
+  LogEntryType
+  entry_type() const override
+  {
+    return LOG_ENTRY_HTTP;
+  }
+
+  int
+  marshal_client_req_url(char *buf) override
+  {
+    return marshal_string(buf, url);
+  }
+
+  void
+  set_client_req_url(char *buf, int len) override
+  {
+    url = std::string(buf, len);
+  }
+
+  int
+  marshal_client_req_http_method(char *buf) override
+  {
+    return marshal_string(buf, "GET");
+  }
+
+  int
+  marshal_proxy_resp_status_code(char *buf) override
+  {
+    ++extracted;
+    if (buf) {
+      marshal_int(buf, status);
+    }
+    return INK_MIN_ALIGN;
+  }
+
+  int
+  marshal_client_host_ip(char *buf) override
+  {
+    return marshal_ip(buf, &client_ip.sa);
+  }
+
+  int
+  marshal_http_header_field(LogField::Container /* container ATS_UNUSED */, char *field, char *buf) override
+  {
+    for (auto const &header : headers) {
+      if (strcasecmp(header.first, field) == 0) {
+        return marshal_string(buf, header.second);
+      }
+    }
+    return marshal_string(buf, "-");
+  }
+
+  int extracted   = 0;
+  int64_t status  = 200;
+  IpEndpoint client_ip;
+  std::string url = "http://www.example.com/some/path/to/an/object.jpg?with=query&string=1";
+  std::vector<std::pair<const char *, const char *>> headers = {
+    {"Host", "www.example.com"},
+    {"User-Agent", "Mozilla/5.0 (X11; Linux x86_64)"},
+    {"Accept", "image/*"},
+    {"Accept-Encoding", "gzip"},
+    {"Accept-Language", "en-US,en;q=0.5"},
+    {"Cookie", "session=abcdef"},
+    {"Referer", "http://www.example.com/"},
+    {"X-Forwarded-For", "192.0.2.1"},
+  };
+
+private:
+  int
+  marshal_string(char *buf, std::string const &str)
+  {
+    int len = LogAccess::strlen(str.c_str());
+
+    ++extracted;
+    if (buf) {
+      memset(buf, 0, len); // so that entries can be compared, padding is left alone otherwise
+      marshal_str(buf, str.c_str(), len);
+    }
+    return len;
+  }
+};
+
+// Formats of an access log, an error sampling log and an analytics log, and a few more.
+static const char *test_shared_formats[] = {
+  "%<cqu> %<cqhm> %<pssc> %<{Host}cqh> %<{User-Agent}cqh> %<{Referer}cqh>",
+  "%<cqu> %<pssc> %<{Host}cqh>",
+  "%<cqu> %<cqhm> %<pssc> %<{Host}cqh> %<{Accept}cqh> %<{Accept-Encoding}cqh> %<{Accept-Language}cqh>",
+  "%<pssc> %<{Cookie}cqh>",
+  "%<cqu> %<{X-Forwarded-For}cqh> %<{User-Agent}cqh>",
+  "%<cqhm> %<cqu> %<pssc>",
+  "%<{Host}cqh> %<{Referer}cqh> %<pssc>",
+  "%<cqu>",
+};
+
+REGRESSION_TEST(LogObjectManager_SharedFields)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  LogObjectManager mgr;
+  TestLogAccess lad;
+
+  box = REGRESSION_TEST_PASSED;
+
+  for (unsigned i = 0; i < countof(test_shared_formats); ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "shared_fields%u", i);
+    mgr.manage_object(MakeTestLogObject(name, test_shared_formats[i]));
+  }
+
+  // Every format marshals the same bytes with or without the cache.
+  LogFieldCache::SlotSet all;
+  LogFieldCache cache(all.set());
+
+  for (unsigned i = 0; i < countof(test_shared_formats); ++i) {
+    LogFormat format("testfmt", test_shared_formats[i]);
+    LogFieldList &fields = format.m_field_list;
+    char plain[1024], cached[1024];
+
+    lad.field_cache    = nullptr;
+    unsigned plain_len = fields.marshal_len(&lad);
+    box.check(plain_len <= sizeof(plain) && fields.marshal(&lad, plain) == plain_len, "format %u marshals", i);
+
+    lad.field_cache     = &cache;
+    unsigned cached_len = fields.marshal_len(&lad);
+    box.check(cached_len == plain_len && fields.marshal(&lad, cached) == plain_len, "format %u marshals from the cache", i);
+    box.check(memcmp(plain, cached, plain_len) == 0, "format %u marshals the same bytes from the cache", i);
+  }
+
+  // Changing the entry, as a wipe filter does, drops what was marshalled before.
+  LogField *url = Log::global_field_list.find_by_symbol("cqu");
+  char buf[1024];
+  url->updateField(&lad, const_cast<char *>("http://www.example.com/"), 23);
+  box.check(url->marshal(&lad, buf) == 24 && strcmp(buf, "http://www.example.com/") == 0, "an updated field is marshalled again");
+  lad.field_cache = nullptr;
+
+  // Logging to all the objects extracts each field once, plus once for its length.
+  lad.extracted = 0;
+  mgr.log(&lad);
+  box.check(lad.extracted == 2 * 11, "%d fields extracted for %u objects, expected %d", lad.extracted,
+            (unsigned)countof(test_shared_formats), 2 * 11);
+  box.check(lad.field_cache == nullptr, "the cache does not outlive the entry");
+}
+
+// Fill a buffer of the object with entries for a few hosts and a lot of urls.
+static LogBuffer *
+MakeTestLogBuffer(LogObject *obj, TestLogAccess &lad, size_t size)
+{
+  const char *hosts[]  = {"www.example.com", "img.example.com", "cdn.example.net"};
+  LogBuffer *lb        = new LogBuffer(obj, size);
+  LogFieldList &fields = obj->m_format->m_field_list;
+  size_t offset;
+
+  for (unsigned i = 0;; ++i) {
+    const char *host = hosts[i % countof(hosts)];
+
+    lad.url               = std::string("http://") + host + "/images/" + std::to_string(i * 7919 % 1000) + ".jpg";
+    lad.headers[0].second = host;
+    if (lb->checkout_write(&offset, fields.marshal_len(&lad)) != LogBuffer::LB_OK) {
+      break;
+    }
+    fields.marshal(&lad, &(*lb)[offset]);
+    lb->checkin_write(offset);
+  }
+  lb->update_header_data();
+
+  return lb;
+}
+
+REGRESSION_TEST(LogObject_ColumnarBlock)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  TestLogAccess lad;
+  Ptr<LogObject> obj      = make_ptr(MakeTestLogObject("columnar", test_shared_formats[0], LOG_FILE_COLUMNAR));
+  LogBuffer *lb           = MakeTestLogBuffer(obj.get(), lad, 64 * 1024);
+  LogBufferHeader *header = lb->header();
+  int block_len;
+
+  box = REGRESSION_TEST_PASSED;
+  box.check(obj->get_flags() & LogObject::COLUMNAR, "the object writes columnar blocks");
+
+  char *block = LogColumnBlock::encode(header, &block_len);
+  box.check(block != nullptr, "the buffer is encoded");
+  if (block == nullptr) {
+    delete lb;
+    return;
+  }
+  rprintf(t, "%u entries, %u bytes encoded into %d bytes\n", header->entry_count, header->byte_count, block_len);
+  box.check(block_len < static_cast<int>(header->byte_count) / 4, "the block is compressed");
+
+  // The buffer comes back byte for byte, as the strings were padded with zeros.
+  LogBufferHeader *decoded = LogColumnBlock::decode(block, block_len);
+  box.check(decoded != nullptr && decoded->byte_count == header->byte_count && memcmp(decoded, header, header->byte_count) == 0,
+            "the block decodes to the same buffer");
+  ats_free(decoded);
+
+  // Truncated or damaged blocks are rejected, or at least decoded within bounds.
+  box.check(LogColumnBlock::decode(block, block_len - 1) == nullptr, "a truncated block is rejected");
+  for (int i = sizeof(LogColumnBlockHeader); i < block_len; i += 7) {
+    block[i] ^= 0x5a;
+    ats_free(LogColumnBlock::decode(block, block_len));
+    block[i] ^= 0x5a;
+  }
+
+  ats_free(block);
+  delete lb;
+
+  // Integers and addresses come back too, even those whose bytes look like a padded string.
+  int64_t statuses[] = {1024, 65537, 256, 4096, 200};
+  obj                = make_ptr(MakeTestLogObject("columnar_ints", "%<chi> %<pssc> %<cqu>", LOG_FILE_COLUMNAR));
+  lb                 = new LogBuffer(obj.get(), 4096);
+  ats_ip_pton("192.0.2.10", &lad.client_ip);
+  for (auto status : statuses) {
+    LogFieldList &fields = obj->m_format->m_field_list;
+    size_t offset;
+
+    lad.status = status;
+    if (lb->checkout_write(&offset, fields.marshal_len(&lad)) == LogBuffer::LB_OK) {
+      fields.marshal(&lad, &(*lb)[offset]);
+      lb->checkin_write(offset);
+    }
+  }
+  lb->update_header_data();
+  header = lb->header();
+  block  = LogColumnBlock::encode(header, &block_len);
+  box.check(block != nullptr, "the buffer with integers is encoded");
+  decoded = block ? LogColumnBlock::decode(block, block_len) : nullptr;
+  box.check(decoded != nullptr && decoded->byte_count == header->byte_count && memcmp(decoded, header, header->byte_count) == 0,
+            "the block with integers decodes to the same buffer");
+  ats_free(decoded);
+  ats_free(block);
+  delete lb;
+}
+
+// A sink that records the buffers it gets and the times of their entries.
+class TestLogBufferSink : public LogBufferSink
+{
+public:
+  int
+  preproc_and_try_delete(LogBuffer *buffer) override
+  {
+    LogBufferIterator iter(buffer->header());
+    LogEntryHeader *entry;
+
+    while ((entry = iter.next())) {
+      times.push_back(entry_time(entry) / 1000000);
+    }
+    seqs.push_back(buffer->m_flush_seq);
+    delete buffer;
+    return 0;
+  }
+
+  std::vector<int64_t> times;
+  std::vector<uint64_t> seqs;
+};
+
+// Queues a buffer of entries logged at the given seconds.
+static void
+QueueTestLogBuffer(LogBufferManager &manager, LogObject *obj, std::initializer_list<int> seconds, uint64_t seq = 0)
+{
+  LogFieldList &fields = obj->m_format->m_field_list;
+  LogBuffer *lb        = new LogBuffer(obj, 4096);
+  TestLogAccess lad;
+
+  lb->m_flush_seq = seq;
+  for (int second : seconds) {
+    size_t offset;
+
+    lb->checkout_write(&offset, fields.marshal_len(&lad));
+    fields.marshal(&lad, &(*lb)[offset]);
+    ((LogEntryHeader *)&(*lb)[offset - sizeof(LogEntryHeader)])->timestamp = second;
+    lb->checkin_write(offset);
+  }
+  manager.add_to_flush_queue(lb);
+}
+
+REGRESSION_TEST(LogObject_ThreadBuffers)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  TestLogAccess lad;
+  int thread_buffers = Log::config->thread_buffers;
+
+  box = REGRESSION_TEST_PASSED;
+
+  // Without merging, the buffers are flushed in the order they were queued.
+  Ptr<LogObject> obj = make_ptr(MakeTestLogObject("buffer_order", test_shared_formats[1]));
+  {
+    LogBufferManager manager;
+    TestLogBufferSink sink;
+
+    QueueTestLogBuffer(manager, obj.get(), {1005, 1006}, 1);
+    QueueTestLogBuffer(manager, obj.get(), {1003, 1004}, 2);
+    QueueTestLogBuffer(manager, obj.get(), {1009}, 3);
+    box.check(manager.preproc_buffers(&sink) == 3, "all the buffers are flushed");
+    box.check(sink.seqs == std::vector<uint64_t>({1, 2, 3}), "the buffers are flushed in queue order");
+  }
+
+  // The entries of two thread buffers interleave, and the second buffer is
+  // only queued after the first batch. The first batch may not merge past
+  // the start of the second buffer, which is still being written.
+  {
+    LogBufferManager manager;
+    TestLogBufferSink sink;
+
+    QueueTestLogBuffer(manager, obj.get(), {1000, 1002, 1004});
+    box.check(manager.preproc_buffers(&sink, 1001 * 1000000LL) == 1, "the first batch flushes one buffer");
+    box.check(sink.times == std::vector<int64_t>({1000}), "the first batch holds back the entries after the watermark");
+
+    QueueTestLogBuffer(manager, obj.get(), {1001, 1003, 1005});
+    QueueTestLogBuffer(manager, obj.get(), {1007, 1008});
+    box.check(manager.preproc_buffers(&sink, 1006 * 1000000LL) == 1, "the second batch flushes one merged buffer");
+    box.check(sink.times == std::vector<int64_t>({1000, 1001, 1002, 1003, 1004, 1005}),
+              "the second batch merges the entries of both buffers in order");
+
+    // Buffers that do not overlap are flushed whole.
+    QueueTestLogBuffer(manager, obj.get(), {1009});
+    box.check(manager.preproc_buffers(&sink, INT64_MAX) == 2, "the buffers that do not overlap are flushed as they are");
+    box.check(sink.times == std::vector<int64_t>({1000, 1001, 1002, 1003, 1004, 1005, 1007, 1008, 1009}),
+              "all the entries are flushed in order");
+  }
+
+  // The entries logged by this thread go to its own buffer if it is a network thread, and are flushed either way.
+  Log::config->thread_buffers = 1;
+  obj                         = make_ptr(MakeTestLogObject("thread_buffers", test_shared_formats[1]));
+  Log::config->thread_buffers = thread_buffers;
+
+  for (int i = 0; i < 10; ++i) {
+    box.check(obj->log(&lad) == Log::LOG_OK, "entry %d is logged", i);
+  }
+  obj->force_new_buffer();
+  box.check(obj->preproc_buffers() == 1, "the entries are flushed");
+}
+
+REGRESSION_TEST(LogFile_OrderedFlush)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  Ptr<LogFile> file = make_ptr(new LogFile("ordered_flush", nullptr, LOG_FILE_PIPE, 0));
+  std::vector<LogFlushData *> ready;
+  ink_hrtime now = Thread::get_hrtime();
+
+  box = REGRESSION_TEST_PASSED;
+
+  // The data of buffer 2 comes in two pieces, with buffer 1 late, buffer 4
+  // missing and some unordered data. m_len tells the pieces apart.
+  struct {
+    uint64_t seq;
+    bool last;
+    bool waiting;
+  } pieces[] = {
+    {2, false, true}, {3, true, true}, {1, true, true}, {0, true, true}, {2, true, false}, {5, true, true},
+  };
+  int expected[] = {2, 0, 3, 4, 1};
+
+  for (unsigned i = 0; i < countof(pieces); ++i) {
+    LogFlushData *data = new LogFlushData(file.get(), nullptr, i);
+    data->m_seq        = pieces[i].seq;
+    data->m_last       = pieces[i].last;
+    box.check(file->order_flush_data(data, now, ready) == pieces[i].waiting, "piece %u is %sheld back", i,
+              pieces[i].waiting ? "" : "not ");
+  }
+  box.check(file->expire_flush_data(now + HRTIME_SECOND, ready), "buffer 5 still waits for buffer 4");
+  box.check(!file->expire_flush_data(now + HRTIME_MINUTE, ready), "buffer 4 is given up on");
+
+  box.check(ready.size() == countof(expected) + 1, "%zu pieces are ready", ready.size());
+  for (unsigned i = 0; i < ready.size(); ++i) {
+    int want = i < countof(expected) ? expected[i] : 5;
+    box.check(ready[i]->m_len == want, "piece %d is written at position %u, expected %d", ready[i]->m_len, i, want);
+    delete ready[i];
+  }
+  ready.clear();
+
+  // On shutdown the flush thread gives up on every missing buffer at once.
+  for (uint64_t seq : {9, 7, 12}) {
+    LogFlushData *data = new LogFlushData(file.get(), nullptr, seq);
+    data->m_seq        = seq;
+    data->m_last       = true;
+    box.check(file->order_flush_data(data, now, ready), "buffer %" PRIu64 " is held back", seq);
+  }
+  file->drain_flush_data(ready);
+  box.check(ready.size() == 3 && ready[0]->m_len == 7 && ready[1]->m_len == 9 && ready[2]->m_len == 12,
+            "the held back buffers are written in order");
+  for (auto data : ready) {
+    delete data;
+  }
+}
+
 #endif
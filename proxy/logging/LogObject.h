@@ -35,6 +35,8 @@
 #include "LogFilter.h"
 #include "ts/Vec.h"
 
+#include <vector>
+
 /*-------------------------------------------------------------------------
   LogObject
 
@@ -50,11 +52,16 @@
 #define LOG_FILE_ASCII_OBJECT_FILENAME_EXTENSION ".log"
 #define LOG_FILE_BINARY_OBJECT_FILENAME_EXTENSION ".blog"
 #define LOG_FILE_PIPE_OBJECT_FILENAME_EXTENSION ".pipe"
+#define LOG_FILE_COLUMNAR_OBJECT_FILENAME_EXTENSION ".clog"
 
 #define FLUSH_ARRAY_SIZE (512 * 4)
 
 #define LOG_OBJECT_ARRAY_DELTA 8
 
+// Work buffers used by a single thread are padded to this size so that
+// they do not share cache lines.
+#define LOG_OBJECT_CACHE_LINE_SIZE 64
+
 #define ACQUIRE_API_MUTEX(_f)   \
   ink_mutex_acquire(_APImutex); \
   Debug("log-api-mutex", _f)
@@ -69,6 +76,16 @@ private:
   ASLL(LogBuffer, write_link) write_list;
   int _num_flush_buffers;
 
+  // A buffer held back by the ordered merge, with its entries not merged yet.
+  struct MergeBuffer {
+    LogBuffer *buffer;
+    char *next;
+    unsigned left;
+  };
+  std::vector<MergeBuffer> _merge_list;
+
+  size_t _merge_buffers(LogBufferSink *sink, int64_t merge_until);
+
 public:
   LogBufferManager() : _num_flush_buffers(0) {}
   inline void
@@ -78,7 +95,11 @@ public:
     ink_atomic_increment(&_num_flush_buffers, 1);
   }
 
-  size_t preproc_buffers(LogBufferSink *sink);
+  // Hands the queued buffers to the sink in the order they were queued. With
+  // merge_until >= 0, the entries of the buffers are merged instead, in time
+  // order, up to the entries logged at merge_until (in microseconds). Later
+  // entries are held back for the next call.
+  size_t preproc_buffers(LogBufferSink *sink, int64_t merge_until = -1);
 };
 
 // LogObject is atomically reference counted, and the reference count is always owned by
@@ -91,12 +112,14 @@ public:
     REMOTE_DATA              = 2,
     WRITES_TO_PIPE           = 4,
     LOG_OBJECT_FMT_TIMESTAMP = 8, // always format a timestamp into each log line (for raw text logs)
+    COLUMNAR                 = 16,
   };
 
   // BINARY: log is written in binary format (rather than ascii)
   // REMOTE_DATA: object receives data from remote collation clients, so
   //              it should not be destroyed during a reconfiguration
   // WRITES_TO_PIPE: object writes to a named pipe rather than to a file
+  // COLUMNAR: binary log is written in compressed column blocks
 
   LogObject(const LogFormat *format, const char *log_dir, const char *basename, LogFileFormat file_format, const char *header,
             Log::RollingEnabledValues rolling_enabled, int flush_threads, int rolling_interval_sec = 0, int rolling_offset_hr = 0,
@@ -127,8 +150,15 @@ public:
   inline int
   add_to_flush_queue(LogBuffer *buffer)
   {
-    int idx = m_buffer_manager_idx++ % m_flush_threads;
-
+    // The buffers of the thread buffers all go to the first preproc thread,
+    // which merges their entries.
+    int idx = m_n_thread_buffers ? 0 : m_buffer_manager_idx++ % m_flush_threads;
+
+    // Several preproc threads work on the buffers of the object in
+    // parallel, number them so the flush thread writes them in order.
+    if (m_flush_threads > 1 && m_logFile && !m_n_thread_buffers) {
+      buffer->m_flush_seq = ink_atomic_increment(&m_flush_seq, (uint64_t)1) + 1;
+    }
     m_buffer_manager[idx].add_to_flush_queue(buffer);
 
     return idx;
@@ -137,17 +167,7 @@ public:
   inline size_t
   preproc_buffers(int idx = -1)
   {
-    size_t nfb;
-
-    if (idx == -1)
-      idx = m_buffer_manager_idx++ % m_flush_threads;
-
-    if (m_logFile) {
-      nfb = m_buffer_manager[idx].preproc_buffers(m_logFile.get());
-    } else {
-      nfb = m_buffer_manager[idx].preproc_buffers(&m_host_list);
-    }
-    return nfb;
+    return _preproc_buffers(idx, m_n_thread_buffers ? _merge_watermark() : -1);
   }
 
   void check_buffer_expiration(long time_now);
@@ -256,11 +276,7 @@ public:
     return (m_format ? m_format->format_string() : "<none>");
   }
 
-  inline void
-  force_new_buffer()
-  {
-    _checkout_write(nullptr, 0);
-  }
+  void force_new_buffer();
 
   bool operator==(LogObject &rhs);
 
@@ -297,13 +313,30 @@ private:
   volatile head_p m_log_buffer; // current work buffer
   unsigned m_buffer_manager_idx;
   LogBufferManager *m_buffer_manager;
+  uint64_t m_flush_seq; // number of buffers queued for flushing
+
+  // With proxy.config.log.thread_buffers, each network thread writes to its
+  // own work buffer, indexed by EThread::id, instead of m_log_buffer. The
+  // other threads keep sharing m_log_buffer. The buffers are created when
+  // the threads first log.
+  struct ThreadBuffer {
+    volatile head_p buffer;
+    char pad[LOG_OBJECT_CACHE_LINE_SIZE - sizeof(head_p)];
+  };
+  ThreadBuffer *m_thread_buffers;
+  int m_n_thread_buffers;
+  volatile int m_retiring_buffers; // work buffers swapped out but not queued yet
 
   void generate_filenames(const char *log_dir, const char *basename, LogFileFormat file_format);
   void _setup_rolling(Log::RollingEnabledValues rolling_enabled, int rolling_interval_sec, int rolling_offset_hr,
                       int rolling_size_mb);
   unsigned _roll_files(long interval_start, long interval_end);
 
-  LogBuffer *_checkout_write(size_t *write_offset, size_t write_size);
+  void _setup_thread_buffers();
+  volatile head_p *_work_buffer();
+  int64_t _merge_watermark();
+  size_t _preproc_buffers(int idx, int64_t merge_until);
+  LogBuffer *_checkout_write(volatile head_p *work_buffer, size_t *write_offset, size_t write_size);
 
   // noncopyable
   LogObject(const LogObject &) = delete;
@@ -357,6 +390,8 @@ private:
   LogObjectList _objects;    // array of configured objects
   LogObjectList _APIobjects; // array of API objects
 
+  LogFieldCache::SlotSet _shared_fields; // fields used by more than one configured object
+
 public:
   ink_mutex *_APImutex; // synchronize access to array of API objects
 private:
@@ -365,6 +400,7 @@ private:
   int _solve_filename_conflicts(LogObject *log_obj, int maxConflicts);
   int _solve_internal_filename_conflicts(LogObject *log_obj, int maxConflicts, int fileNum = 0);
   void _filename_resolution_abort(const char *fname);
+  void _update_shared_fields();
 
 public:
   LogObjectManager();
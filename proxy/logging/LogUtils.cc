@@ -74,18 +74,18 @@ LogUtils::timestamp_to_str(long timestamp, char *buf, int size)
   This routine will convert a timestamp (seconds) into a string compatible
   with the Netscape logging formats.
 
-  This routine is intended to be called from the (single) logging thread,
-  and is therefore NOT MULTITHREADED SAFE.  There is a single, static,
-  string buffer that the time string is constructed into and returned.
+  Each thread has its own string buffer that the time string is
+  constructed into and returned, and only formats it again when the
+  second changes, as do the date and time routines below.
   -------------------------------------------------------------------------*/
 
 char *
 LogUtils::timestamp_to_netscape_str(long timestamp)
 {
-  static char timebuf[64]; // NOTE: not MT safe
-  static char gmtstr[16];
-  static long last_timestamp = 0;
-  static char bad_time[]     = "Bad timestamp";
+  static thread_local char timebuf[64];
+  static thread_local char gmtstr[16];
+  static thread_local long last_timestamp = 0;
+  static char bad_time[]                  = "Bad timestamp";
 
   // safety check
   if (timestamp < 0) {
@@ -137,9 +137,9 @@ LogUtils::timestamp_to_netscape_str(long timestamp)
 char *
 LogUtils::timestamp_to_date_str(long timestamp)
 {
-  static char timebuf[64]; // NOTE: not MT safe
-  static long last_timestamp = 0;
-  static char bad_time[]     = "Bad timestamp";
+  static thread_local char timebuf[64];
+  static thread_local long last_timestamp = 0;
+  static char bad_time[]                  = "Bad timestamp";
 
   // safety check
   if (timestamp < 0) {
@@ -169,9 +169,9 @@ LogUtils::timestamp_to_date_str(long timestamp)
 char *
 LogUtils::timestamp_to_time_str(long timestamp)
 {
-  static char timebuf[64]; // NOTE: not MT safe
-  static long last_timestamp = 0;
-  static char bad_time[]     = "Bad timestamp";
+  static thread_local char timebuf[64];
+  static thread_local long last_timestamp = 0;
+  static char bad_time[]                  = "Bad timestamp";
 
   // safety check
   if (timestamp < 0) {
@@ -35,6 +35,7 @@
 #include "LogStandalone.cc"
 
 #include "LogObject.h"
+#include "LogColumnBlock.h"
 #include "hdrs/HTTP.h"
 
 #include <sys/utsname.h>
@@ -1716,6 +1717,80 @@ parse_log_buff(LogBufferHeader *buf_header, bool summary = false, bool aggregate
   return 0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Process a columnar block, whose first bytes were already read into start.
+static int
+process_column_block(int in_fd, const char *start, unsigned start_size, unsigned max_age)
+{
+  LogColumnBlockHeader block_header;
+  int nread;
+
+  memcpy(&block_header, start, start_size);
+  nread = read(in_fd, reinterpret_cast<char *>(&block_header) + start_size, sizeof(block_header) - start_size);
+  if (nread != static_cast<int>(sizeof(block_header) - start_size)) {
+    Debug("logstats", "Read of the column block header failed, nread=%d, errno=%d.", nread, errno);
+    return 1;
+  }
+
+  Debug("logstats", "LogColumnBlock version %d, current = %d", block_header.version, LOG_COLUMN_BLOCK_VERSION);
+  // Check the size before allocating, a corrupt header could ask for up to 4GB.
+  if (block_header.version != LOG_COLUMN_BLOCK_VERSION || block_header.byte_count <= sizeof(block_header) ||
+      block_header.byte_count > LogColumnBlock::MAX_BLOCK_BYTES || block_header.buffer_count > LogColumnBlock::MAX_BUFFER_BYTES) {
+    Debug("logstats", "Column block header is wrong.");
+    return 1;
+  }
+
+  const int MAX_READ_TRIES = 5;
+  int block_bytes          = block_header.byte_count - sizeof(block_header);
+  int total_read           = 0;
+  int read_tries_remaining = MAX_READ_TRIES;
+  char *block              = static_cast<char *>(ats_malloc(block_header.byte_count));
+
+  memcpy(block, &block_header, sizeof(block_header));
+  do {
+    nread = read(in_fd, block + sizeof(block_header) + total_read, block_bytes - total_read);
+    if (EOF == nread || !nread) {
+      Debug("logstats", "Read failed while reading column block, wanted %d bytes, nread=%d, errno=%d", block_bytes - total_read,
+            nread, errno);
+      ats_free(block);
+      return 1;
+    }
+    total_read += nread;
+
+    if (total_read < block_bytes) {
+      if (--read_tries_remaining <= 0) {
+        Debug("logstats_failed_retries", "Unable to read after %d tries, total_read=%d, block_bytes=%d", MAX_READ_TRIES, total_read,
+              block_bytes);
+        ats_free(block);
+        return 1;
+      }
+      usleep(50 * 1000); // wait 50ms
+    }
+  } while (total_read < block_bytes);
+
+  LogBufferHeader *header = LogColumnBlock::decode(block, block_header.byte_count);
+  int ret                 = 0;
+
+  ats_free(block);
+  if (header == nullptr) {
+    Debug("logstats", "Failed to decode column block.");
+    return 1;
+  }
+
+  // Possibly skip too old entries (the entire block is skipped)
+  if (header->high_timestamp >= max_age) {
+    if (parse_log_buff(header, cl.summary != 0, cl.report_per_user != 0) != 0) {
+      Debug("logstats", "Failed to parse log buffer.");
+      ret = 1;
+    }
+  } else {
+    Debug("logstats", "Skipping old block (age=%d, max=%d)", header->high_timestamp, max_age);
+  }
+  ats_free(header);
+
+  return ret;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Process a file (FD)
 int
@@ -1750,7 +1825,7 @@ process_file(int in_fd, off_t offset, unsigned max_age)
           return 0;
         }
         // ensure that this is a valid logbuffer header
-        if (header->cookie && (LOG_SEGMENT_COOKIE == header->cookie)) {
+        if (header->cookie && (LOG_SEGMENT_COOKIE == header->cookie || LOG_COLUMN_BLOCK_COOKIE == header->cookie)) {
           offset = 0;
           break;
         }
@@ -1766,12 +1841,20 @@ process_file(int in_fd, off_t offset, unsigned max_age)
       }
 
       // ensure that this is a valid logbuffer header
-      if (header->cookie != LOG_SEGMENT_COOKIE) {
+      if (header->cookie != LOG_SEGMENT_COOKIE && header->cookie != LOG_COLUMN_BLOCK_COOKIE) {
         Debug("logstats", "Invalid segment cookie (expected %d, got %d)", LOG_SEGMENT_COOKIE, header->cookie);
         return 1;
       }
     }
 
+    // columnar log files hold compressed blocks rather than logbuffers
+    if (header->cookie == LOG_COLUMN_BLOCK_COOKIE) {
+      if (process_column_block(in_fd, buffer, first_read_size, max_age) != 0) {
+        return 1;
+      }
+      continue;
+    }
+
     Debug("logstats", "LogBuffer version %d, current = %d", header->version, LOG_SEGMENT_VERSION);
     if (header->version != LOG_SEGMENT_VERSION) {
       return 1;